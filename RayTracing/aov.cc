@@ -0,0 +1,153 @@
+// arbitrary output variables
+//
+//
+
+#include "aov.h"
+#include <cstring>
+#include <string>
+#include "exr.h"
+
+
+static const char* kAovNames[(int)EAov::Count] = { "depth", "normal", "albedo", "material", "object", "direct", "indirect", "samples" };
+
+// exr channels of each aov, after "<name>."
+static const char* kAovChannels[(int)EAov::Count][3] = {
+	{ "Z" }, { "X", "Y", "Z" }, { "R", "G", "B" }, { "id" }, { "id" }, { "R", "G", "B" }, { "R", "G", "B" }, { "count" },
+};
+
+static int aov_channels(EAov aov)
+{
+	int n = 0;
+	while (n < 3 && kAovChannels[(int)aov][n]) n++;
+	return n;
+}
+
+const char* aov_name(EAov aov)
+{
+	return kAovNames[(int)aov];
+}
+
+bool parse_aovs(const char* list, uint32_t& mask)
+{
+	mask = 0;
+	if (strcmp(list, "all") == 0)
+	{
+		mask = (1u << (int)EAov::Count) - 1;
+		return true;
+	}
+
+	std::string names(list);
+	size_t start = 0;
+	while (start <= names.size())
+	{
+		size_t end = names.find(',', start);
+		if (end == std::string::npos) end = names.size();
+		const std::string name = names.substr(start, end - start);
+
+		int a = 0;
+		while (a < (int)EAov::Count && name != kAovNames[a]) a++;
+		if (a == (int)EAov::Count)
+			return false;
+
+		mask |= 1u << a;
+		start = end + 1;
+	}
+	return mask != 0;
+}
+
+FAovBuffer::FAovBuffer(int w, int h, uint32_t m)
+	: width(w), height(h), mask(m)
+{
+	for (int a = 0; a < (int)EAov::Count; a++)
+	{
+		offsets[a] = enabled((EAov)a) ? stride : -1;
+		stride += enabled((EAov)a) ? aov_channels((EAov)a) : 0;
+	}
+	sums.assign(size_t(width) * height * stride, 0.0);
+	samples.assign(size_t(width) * height, 0);
+}
+
+float FAovBuffer::id_of(const void* p)
+{
+	if (!p)
+		return -1.0f;
+
+	auto it = ids.find(p);
+	if (it == ids.end())
+		it = ids.emplace(p, int(ids.size())).first;
+	return float(it->second);
+}
+
+void FAovBuffer::add(int pixel, const FColor3& radiance, const FPathAovs& aovs)
+{
+	double* sum = &sums[size_t(pixel) * stride];
+	auto add3 = [&](EAov aov, FReal x, FReal y, FReal z) {
+		double* p = sum + offsets[(int)aov];
+		p[0] += x; p[1] += y; p[2] += z;
+	};
+
+	if (enabled(EAov::Depth)) sum[offsets[(int)EAov::Depth]] += aovs.depth;
+	if (enabled(EAov::Normal)) add3(EAov::Normal, aovs.normal.x(), aovs.normal.y(), aovs.normal.z());
+	if (enabled(EAov::Albedo)) add3(EAov::Albedo, aovs.albedo.x(), aovs.albedo.y(), aovs.albedo.z());
+	if (enabled(EAov::Direct)) add3(EAov::Direct, aovs.direct.x(), aovs.direct.y(), aovs.direct.z());
+	if (enabled(EAov::Indirect))
+	{
+		const FColor3 indirect = radiance - aovs.direct;
+		add3(EAov::Indirect, indirect.x(), indirect.y(), indirect.z());
+	}
+
+	// ids do not average, the first sample of the pixel names it
+	if (samples[pixel] == 0)
+	{
+		if (enabled(EAov::MaterialId)) sum[offsets[(int)EAov::MaterialId]] = id_of(aovs.material);
+		if (enabled(EAov::ObjectId)) sum[offsets[(int)EAov::ObjectId]] = id_of(aovs.object);
+	}
+	samples[pixel]++;
+}
+
+bool FAovBuffer::write_exr(const char* filename, const std::vector<FColor3>& image) const
+{
+	const size_t n = size_t(width) * height;
+	std::vector<FExrChannel> channels;
+	auto add_channel = [&](const std::string& name) -> std::vector<float>& {
+		channels.push_back({ name, std::vector<float>(n) });
+		return channels.back().pixels;
+	};
+
+	// exr rows run top down
+	for (int c = 0; c < 3; c++)
+	{
+		std::vector<float>& pixels = add_channel(kAovChannels[(int)EAov::Albedo][c]);
+		for (int j = 0; j < height; j++)
+			for (int i = 0; i < width; i++)
+				pixels[size_t(height - 1 - j) * width + i] = float(image[size_t(j) * width + i][c]);
+	}
+
+	for (int a = 0; a < (int)EAov::Count; a++)
+	{
+		const EAov aov = (EAov)a;
+		if (!enabled(aov))
+			continue;
+
+		const bool averaged = aov != EAov::MaterialId && aov != EAov::ObjectId && aov != EAov::SampleCount;
+		for (int c = 0; c < aov_channels(aov); c++)
+		{
+			std::vector<float>& pixels = add_channel(std::string(kAovNames[a]) + "." + kAovChannels[a][c]);
+			for (int j = 0; j < height; j++)
+			{
+				for (int i = 0; i < width; i++)
+				{
+					const size_t p = size_t(j) * width + i;
+					double value = sums[p * stride + offsets[a] + c];
+					if (aov == EAov::SampleCount)
+						value = samples[p];
+					else if (averaged)
+						value = samples[p] > 0 ? value / samples[p] : 0.0;
+					pixels[size_t(height - 1 - j) * width + i] = float(value);
+				}
+			}
+		}
+	}
+
+	return ::write_exr(filename, width, height, channels);
+}
@@ -0,0 +1,75 @@
+// arbitrary output variables
+// besides its radiance a camera sample can report where its path started and
+// how its light splits into direct and indirect. the integrators fill an
+// FPathAovs when handed one, FAovBuffer averages the selected channels per
+// pixel and writes them with the image to an openexr file.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "basic.h"
+#include "vec3.h"
+#include "color.h"
+
+class FMaterial;
+class FHittable;
+
+
+enum class EAov
+{
+	Depth,        // distance to the first hit, 0 on a miss
+	Normal,       // world space normal at the first hit, facing the camera
+	Albedo,       // base color of the first hit material
+	MaterialId,   // first hit material, numbered in the order materials are first seen
+	ObjectId,     // first hit primitive, numbered the same way
+	Direct,       // emitted at the first hit or reaching it from a light in one bounce
+	Indirect,     // the rest of the radiance
+	SampleCount,  // samples taken in the pixel
+	Count,
+};
+
+const char* aov_name(EAov aov);
+// comma separated aov names, or "all", as a bit mask of (1 << EAov)
+bool parse_aovs(const char* list, uint32_t& mask);
+
+// aovs of one camera sample
+struct FPathAovs
+{
+	FColor3	albedo = FColor3(1, 1, 1);
+	FVec3	normal = FVec3(0, 0, 0);
+	FReal	depth = 0;
+	const FMaterial* material = nullptr;
+	const FHittable* object = nullptr;
+	FColor3	direct = FColor3(0, 0, 0);
+};
+
+// per pixel sums of the enabled aovs, row j at j * width
+class FAovBuffer
+{
+public:
+	FAovBuffer(int width, int height, uint32_t mask);
+
+	bool enabled(EAov aov) const { return (mask & (1u << (int)aov)) != 0; }
+
+	// one sample of pixel, radiance is its full estimate
+	void add(int pixel, const FColor3& radiance, const FPathAovs& aovs);
+
+	// image (pixel means, row j at j * width) as R, G, B and every enabled aov
+	bool write_exr(const char* filename, const std::vector<FColor3>& image) const;
+
+private:
+	// dense id of p, ids are handed out in the order pointers are first seen
+	float id_of(const void* p);
+
+	int width;
+	int height;
+	uint32_t mask;
+	int offsets[(int)EAov::Count];  // first float of the aov in a pixel, -1 when disabled
+	int stride = 0;                 // floats per pixel
+	std::vector<double> sums;
+	std::vector<uint32_t> samples;
+	std::unordered_map<const void*, int> ids;
+};
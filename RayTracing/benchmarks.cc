@@ -0,0 +1,1139 @@
+// benchmarks
+//
+//
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <vector>
+#include "benchmarks.h"
+#include "mesh_loader.h"
+#include "timer.h"
+#include "color.h"
+#include "examples.h"
+#include "integrator.h"
+#include "sphere.h"
+#include "compiled_scene.h"
+#include "light_list.h"
+#include "environment.h"
+#include "sampler.h"
+#include "denoiser.h"
+#include "parallel.h"
+
+
+// example built as main builds it, with the random sequence reset first
+static shared_ptr<FHittable> load_example(int scene, shared_ptr<FRayCamera>& camera, FColor3& background)
+{
+	srand(1);
+	camera = nullptr;
+	background = FColor3(0, 0, 0);
+	return examples[scene]._funcptr(camera, background);
+}
+
+// tessellated torus with positions, normals and uvs, 2 * rings * sides triangles
+static bool write_torus_obj(const char* filename, int rings, int sides)
+{
+	FILE* fp = fopen(filename, "wb");
+	if (!fp) return false;
+
+	for (int i = 0; i < rings; i++) {
+		double phi = kTwoPi * i / rings;
+		for (int j = 0; j < sides; j++) {
+			double theta = kTwoPi * j / sides;
+			FVec3 n(cos(phi) * cos(theta), sin(theta), sin(phi) * cos(theta));
+			FPoint3 p = FVec3(cos(phi) * 3.0, 0, sin(phi) * 3.0) + n;
+			fprintf(fp, "v %.6f %.6f %.6f\nvn %.6f %.6f %.6f\nvt %.6f %.6f\n",
+				p.x(), p.y(), p.z(), n.x(), n.y(), n.z(), (double)i / rings, (double)j / sides);
+		}
+	}
+
+	for (int i = 0; i < rings; i++) {
+		for (int j = 0; j < sides; j++) {
+			int a = i * sides + j + 1;
+			int b = ((i + 1) % rings) * sides + j + 1;
+			int c = i * sides + (j + 1) % sides + 1;
+			int d = ((i + 1) % rings) * sides + (j + 1) % sides + 1;
+			fprintf(fp, "f %d/%d/%d %d/%d/%d %d/%d/%d\nf %d/%d/%d %d/%d/%d %d/%d/%d\n",
+				a, a, a, b, b, b, c, c, c, c, c, c, b, b, b, d, d, d);
+		}
+	}
+
+	fclose(fp);
+	return true;
+}
+
+// the same torus as binary little endian ply, positions only
+static bool write_torus_ply(const char* filename, int rings, int sides)
+{
+	FILE* fp = fopen(filename, "wb");
+	if (!fp) return false;
+
+	fprintf(fp, "ply\nformat binary_little_endian 1.0\nelement vertex %d\nproperty float x\nproperty float y\nproperty float z\n"
+		"element face %d\nproperty list uchar int vertex_indices\nend_header\n", rings * sides, 2 * rings * sides);
+
+	for (int i = 0; i < rings; i++) {
+		double phi = kTwoPi * i / rings;
+		for (int j = 0; j < sides; j++) {
+			double theta = kTwoPi * j / sides;
+			FVec3 n(cos(phi) * cos(theta), sin(theta), sin(phi) * cos(theta));
+			FPoint3 p = FVec3(cos(phi) * 3.0, 0, sin(phi) * 3.0) + n;
+			float xyz[3] = { (float)p.x(), (float)p.y(), (float)p.z() };
+			fwrite(xyz, sizeof(float), 3, fp);
+		}
+	}
+
+	for (int i = 0; i < rings; i++) {
+		for (int j = 0; j < sides; j++) {
+			int a = i * sides + j;
+			int b = ((i + 1) % rings) * sides + j;
+			int c = i * sides + (j + 1) % sides;
+			int d = ((i + 1) % rings) * sides + (j + 1) % sides;
+			int faces[2][3] = { { a, b, c }, { c, b, d } };
+			for (int f = 0; f < 2; f++) {
+				unsigned char count = 3;
+				fwrite(&count, 1, 1, fp);
+				fwrite(faces[f], sizeof(int), 3, fp);
+			}
+		}
+	}
+
+	fclose(fp);
+	return true;
+}
+
+static int bench_mesh_loader(const char* filename)
+{
+	FMeshLoadStats stats;
+	shared_ptr<FTriangleMesh> mesh = load_mesh(filename, nullptr, &stats);
+	if (!mesh)
+	{
+		return 1;
+	}
+
+	const double megabytes = stats.file_bytes / (1024.0 * 1024.0);
+	std::cerr << filename << ":\n"
+		<< "  size:       " << megabytes << " MB\n"
+		<< "  vertices:   " << stats.vertices << "\n"
+		<< "  triangles:  " << stats.triangles << "\n"
+		<< "  threads:    " << stats.threads << "\n"
+		<< "  parse:      " << stats.parse_seconds << " s, "
+		<< megabytes / stats.parse_seconds << " MB/s, "
+		<< stats.triangles / stats.parse_seconds << " triangles/s\n"
+		<< "  bvh build:  " << stats.build_seconds << " s\n"
+		<< "  index+bvh:  " << (double)mesh->triangle_bytes() / stats.triangles << " bytes/triangle\n";
+	return 0;
+}
+
+#ifdef RT_SCALAR_FLOAT
+static const char* kPrecision = "float";
+static const char* kOtherPrecision = "double";
+#else
+static const char* kPrecision = "double";
+static const char* kOtherPrecision = "float";
+#endif
+
+// 8-bit values of an ascii ppm as written by write_color
+static bool read_ppm(const char* filename, int& width, int& height, std::vector<int>& values)
+{
+	std::ifstream in(filename);
+	std::string magic;
+	int max_value;
+	if (!(in >> magic >> width >> height >> max_value) || magic != "P3")
+		return false;
+
+	values.resize(3 * width * height);
+	for (int& value : values)
+	{
+		if (!(in >> value))
+			return false;
+	}
+	return true;
+}
+
+// renders every example with ray_color into bench_<precision>_<index>.ppm and
+// compares it with the image of the other precision when it is there
+static int bench_precision(int width, int samples_per_pixel)
+{
+	const int max_depth = 50;
+
+	std::cerr << kPrecision << " math, " << width << "x" << width << ", " << samples_per_pixel << " spp\n";
+	for (int index = 0; index < num_examples; index++)
+	{
+		shared_ptr<FRayCamera> camera;
+		FColor3 background;
+		shared_ptr<FHittable> world = load_example(index, camera, background);
+
+		char filename[64];
+		snprintf(filename, sizeof(filename), "bench_%s_%d.ppm", kPrecision, index);
+		std::ofstream out(filename);
+		out << "P3\n" << width << " " << width << "\n255\n";
+
+		FPerformanceCounter counter;
+		counter.StartPerf();
+		for (int j = width - 1; j >= 0; --j)
+		{
+			for (int i = 0; i < width; ++i)
+			{
+				FColor3 pixel_color(0, 0, 0);
+				for (int s = 0; s < samples_per_pixel; ++s)
+				{
+					auto u = (i + random_double()) / (width - 1);
+					auto v = (j + random_double()) / (width - 1);
+					pixel_color += ray_color(camera->castRay(u, v), background, *world, max_depth);
+				}
+				write_color(out, pixel_color, samples_per_pixel, 2.2);
+			}
+		}
+		const double seconds = counter.EndPerf() / 1000000.0;
+		out.close();
+
+		char line[256];
+		snprintf(line, sizeof(line), "  %2d %-20s %8.3f s %12.0f samples/s", index, examples[index]._name,
+			seconds, (double)width * width * samples_per_pixel / seconds);
+		std::cerr << line;
+
+		// per channel difference of the 8-bit images
+		char other_filename[64];
+		snprintf(other_filename, sizeof(other_filename), "bench_%s_%d.ppm", kOtherPrecision, index);
+		int w0, h0, w1, h1;
+		std::vector<int> a, b;
+		if (read_ppm(filename, w0, h0, a) && read_ppm(other_filename, w1, h1, b) && w0 == w1 && h0 == h1)
+		{
+			double sum = 0.0, sum2 = 0.0;
+			int max_diff = 0;
+			for (size_t k = 0; k < a.size(); k++)
+			{
+				const int d = abs(a[k] - b[k]);
+				sum += d;
+				sum2 += (double)d * d;
+				max_diff = std::max(max_diff, d);
+			}
+			snprintf(line, sizeof(line), "   vs %s: mean %.3f rmse %.3f max %d", kOtherPrecision,
+				sum / a.size(), sqrt(sum2 / a.size()), max_diff);
+			std::cerr << line;
+		}
+		std::cerr << std::endl;
+	}
+	return 0;
+}
+
+// ns per call of op over arrays of random vectors
+template<typename FOp>
+static void bench_vector_op(const char* name, const std::vector<FVec3>& a, const std::vector<FVec3>& b, FOp op)
+{
+	const int rounds = 2000;
+	std::vector<FVec3> out(a.size());
+
+	FPerformanceCounter counter;
+	counter.StartPerf();
+	for (int r = 0; r < rounds; r++)
+	{
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			out[i] = op(a[i], b[i]);
+		}
+	}
+	const double ns = counter.EndPerf() * 1000.0 / ((double)rounds * a.size());
+
+	FReal checksum = 0;
+	for (const FVec3& v : out) checksum += v.x() + v.y() + v.z();
+
+	char line[128];
+	snprintf(line, sizeof(line), "  %-14s %7.2f ns  (checksum %g)\n", name, ns, (double)checksum);
+	std::cerr << line;
+}
+
+static int bench_vector()
+{
+	const size_t count = 4096;
+	std::vector<FVec3> a(count), b(count), n(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		a[i] = FVec3::random(-1, 1);
+		b[i] = FVec3::random(-1, 1);
+		n[i] = random_unit_vector();
+	}
+
+#if RT_VEC3_SIMD
+	std::cerr << "simd vec3, " << sizeof(FVec3) << " bytes\n";
+#else
+	std::cerr << "scalar vec3, " << sizeof(FVec3) << " bytes\n";
+#endif
+	bench_vector_op("add", a, b, [](const FVec3& x, const FVec3& y) { return x + y; });
+	bench_vector_op("mul scalar", a, b, [](const FVec3& x, const FVec3& y) { return x * y.x(); });
+	bench_vector_op("dot", a, b, [](const FVec3& x, const FVec3& y) { return FVec3(dot(x, y), 0, 0); });
+	bench_vector_op("cross", a, b, [](const FVec3& x, const FVec3& y) { return cross(x, y); });
+	bench_vector_op("unit_vector", a, b, [](const FVec3& x, const FVec3& y) { return unit_vector(x); });
+	bench_vector_op("reflect", a, n, [](const FVec3& x, const FVec3& y) { return reflect(x, y); });
+	bench_vector_op("refract", n, a, [](const FVec3& x, const FVec3& y) {
+		const FVec3 normal = dot(x, y) < 0 ? y : -y;
+		return refract(x, unit_vector(normal), 0.75);
+	});
+
+	// unit sphere hit by rays from a radius 5 shell, aimed at a radius 1.5 ball: about 40% hit
+	FSphere sphere(FPoint3(0, 0, 0), 1.0, nullptr);
+	std::vector<FRay> rays(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		const FPoint3 origin = 5.0 * random_unit_vector();
+		rays[i] = FRay(origin, 1.5 * FVec3::random(-1, 1) - origin);
+	}
+
+	const int rounds = 2000;
+	int hits = 0;
+	FHitRecord rec;
+	FPerformanceCounter counter;
+	counter.StartPerf();
+	for (int r = 0; r < rounds; r++)
+	{
+		for (const FRay& ray : rays)
+		{
+			hits += sphere.intersect(ray, 0.001, kInfinity, rec) ? 1 : 0;
+		}
+	}
+	const double intersect_ns = counter.EndPerf() * 1000.0 / ((double)rounds * count);
+
+	counter.StartPerf();
+	for (int r = 0; r < rounds; r++)
+	{
+		for (const FRay& ray : rays)
+		{
+			hits += sphere.hit(ray, 0.001, kInfinity, rec) ? 1 : 0;
+		}
+	}
+	const double hit_ns = counter.EndPerf() * 1000.0 / ((double)rounds * count);
+
+	char line[160];
+	snprintf(line, sizeof(line), "  %-14s %7.2f ns\n  %-14s %7.2f ns  (%.0f%% hit)\n", "sphere intersect", intersect_ns,
+		"sphere hit", hit_ns, 50.0 * hits / ((double)rounds * count));
+	std::cerr << line;
+	return 0;
+}
+
+// primary rays through the pixel centers, traced one by one and in 4x2 packets
+static int bench_packets(int first, int last, int width)
+{
+	const int rounds = 4;
+
+	std::cerr << "primary rays, " << width << "x" << width << ", " << rounds << " rounds\n";
+	for (int index = first; index <= last; index++)
+	{
+		shared_ptr<FRayCamera> camera;
+		FColor3 background;
+		shared_ptr<FHittable> world = load_example(index, camera, background);
+
+		std::vector<FRayPacket> packets;
+		for (int tj = 0; tj < width; tj += 2)
+		{
+			for (int ti = 0; ti < width; ti += 4)
+			{
+				FRayPacket packet;
+				for (int j = tj; j < tj + 2 && j < width; ++j)
+				{
+					for (int i = ti; i < ti + 4 && i < width; ++i)
+					{
+						packet.add(camera->castRay((i + 0.5) / (width - 1), (j + 0.5) / (width - 1)));
+					}
+				}
+				packet.finalize();
+				packets.push_back(packet);
+			}
+		}
+		const double num_rays = (double)rounds * width * width;
+
+		// warm up lazy bvh nodes before timing
+		FHitRecord rec;
+		for (const FRayPacket& packet : packets)
+			for (int k = 0; k < packet.count; k++)
+				world->intersect(packet.rays[k], 0.001, kInfinity, rec);
+
+		std::vector<FReal> single_t(packets.size() * kPacketSize);
+		FPerformanceCounter counter;
+		counter.StartPerf();
+		for (int r = 0; r < rounds; r++)
+		{
+			for (size_t p = 0; p < packets.size(); p++)
+			{
+				for (int k = 0; k < packets[p].count; k++)
+				{
+					single_t[p * kPacketSize + k] = world->intersect(packets[p].rays[k], 0.001, kInfinity, rec) ? rec.t : kInfinity;
+				}
+			}
+		}
+		const double single_seconds = counter.EndPerf() / 1000000.0;
+
+		std::vector<FReal> packet_t(packets.size() * kPacketSize);
+		FHitRecord recs[kPacketSize];
+		counter.StartPerf();
+		for (int r = 0; r < rounds; r++)
+		{
+			for (size_t p = 0; p < packets.size(); p++)
+			{
+				FReal* t_max = &packet_t[p * kPacketSize];
+				for (int k = 0; k < kPacketSize; k++) t_max[k] = kInfinity;
+				world->intersect_packet(packets[p], 0.001, t_max, recs);
+			}
+		}
+		const double packet_seconds = counter.EndPerf() / 1000000.0;
+
+		int mismatches = 0;
+		for (size_t p = 0; p < packets.size(); p++)
+			for (int k = 0; k < packets[p].count; k++)
+				mismatches += single_t[p * kPacketSize + k] != packet_t[p * kPacketSize + k] ? 1 : 0;
+
+		char line[256];
+		snprintf(line, sizeof(line), "  %2d %-20s single %7.2f Mrays/s   packet %7.2f Mrays/s   x%.2f   %d mismatches\n",
+			index, examples[index]._name, num_rays / single_seconds / 1e6, num_rays / packet_seconds / 1e6,
+			single_seconds / packet_seconds, mismatches);
+		std::cerr << line;
+	}
+	return 0;
+}
+
+// image of width x width pixels, summed samples of trace(ray), from the
+// active sampler if one is set
+template<typename FTrace>
+static void render_image(const FRayCamera& camera, int width, int samples_per_pixel, std::vector<FColor3>& image, FTrace trace)
+{
+	image.assign(width * width, FColor3(0, 0, 0));
+	for (int j = 0; j < width; ++j)
+	{
+		for (int i = 0; i < width; ++i)
+		{
+			for (int s = 0; s < samples_per_pixel; ++s)
+			{
+				if (active_sampler)
+					active_sampler->start_pixel_sample(i, j, s);
+				FReal du, dv;
+				sample_2d(du, dv);
+				auto u = (i + du) / (width - 1);
+				auto v = (j + dv) / (width - 1);
+				image[j * width + i] += trace(camera.castRay(u, v));
+			}
+		}
+	}
+}
+
+// render_image() summing into denoiser buffers, trace(ray, aovs) fills the guides
+template<typename FTrace>
+static void render_image_guides(const FRayCamera& camera, int width, int samples_per_pixel, FDenoiseBuffers& buffers, FTrace trace)
+{
+	buffers.resize(width, width);
+	FPathAovs aovs;
+	for (int j = 0; j < width; ++j)
+	{
+		for (int i = 0; i < width; ++i)
+		{
+			for (int s = 0; s < samples_per_pixel; ++s)
+			{
+				if (active_sampler)
+					active_sampler->start_pixel_sample(i, j, s);
+				FReal du, dv;
+				sample_2d(du, dv);
+				auto u = (i + du) / (width - 1);
+				auto v = (j + dv) / (width - 1);
+				const FColor3 radiance = trace(camera.castRay(u, v), &aovs);
+				buffers.add(j * width + i, radiance, aovs.albedo, aovs.normal, aovs.depth);
+			}
+		}
+	}
+}
+
+// ray_color image
+static void render_image(const FRayCamera& camera, const FColor3& background, FHittable& world, int width, int samples_per_pixel, std::vector<FColor3>& image)
+{
+	const int max_depth = 50;
+	render_image(camera, width, samples_per_pixel, image, [&](const FRay& ray) { return ray_color(ray, background, world, max_depth); });
+}
+
+// rms difference of the displayed (gamma 2.2, clamped) images, and of the mean linear value
+static void image_error(const std::vector<FColor3>& image, int spp, const std::vector<FColor3>& reference, int reference_spp, FReal& rmse, FReal& mean_error)
+{
+	double sum2 = 0.0, mean = 0.0, reference_mean = 0.0;
+	for (size_t k = 0; k < image.size(); k++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			const double a = image[k][c] / spp, b = reference[k][c] / reference_spp;
+			const double d = pow(clamp(a, 0.0, 1.0), 1 / 2.2) - pow(clamp(b, 0.0, 1.0), 1 / 2.2);
+			sum2 += d * d;
+			mean += a;
+			reference_mean += b;
+		}
+	}
+	rmse = sqrt(sum2 / (image.size() * 3));
+	mean_error = (mean - reference_mean) / reference_mean;
+}
+
+// render time and image_error() of one image
+struct FBenchScore
+{
+	double	seconds = 0;
+	FReal	rmse = 0;
+	FReal	mean = 0;  // relative error of the mean
+
+	// mse x time, lower is better at any sample count
+	double cost() const { return rmse * rmse * seconds; }
+};
+
+template<typename FTrace>
+static FBenchScore time_and_score(const FRayCamera& camera, int width, int samples_per_pixel,
+	const std::vector<FColor3>& reference, int reference_spp, FTrace trace)
+{
+	FBenchScore score;
+	std::vector<FColor3> image;
+	FPerformanceCounter counter;
+	counter.StartPerf();
+	render_image(camera, width, samples_per_pixel, image, trace);
+	score.seconds = counter.EndPerf() / 1000000.0;
+	image_error(image, samples_per_pixel, reference, reference_spp, score.rmse, score.mean);
+	return score;
+}
+
+static void print_score(const char* name, const FBenchScore& score)
+{
+	char line[256];
+	snprintf(line, sizeof(line), "  %-15s %7.3f s  rmse %.4f  mean %+6.2f%%\n", name, score.seconds, score.rmse, 100 * score.mean);
+	std::cerr << line;
+}
+
+// every example rendered from its shared_ptr graph and from an FCompiledScene
+static int bench_compiled(int width, int samples_per_pixel)
+{
+	std::cerr << width << "x" << width << ", " << samples_per_pixel << " spp\n";
+	for (int index = 0; index < num_examples; index++)
+	{
+		shared_ptr<FRayCamera> camera;
+		FColor3 background;
+		shared_ptr<FHittable> world = load_example(index, camera, background);
+
+		FPerformanceCounter counter;
+		counter.StartPerf();
+		FCompiledScene compiled(world, 0.0, 1.0);
+		const double compile_ms = counter.EndPerf() / 1000.0;
+
+		std::vector<FColor3> image, compiled_image;
+		srand(2);
+		counter.StartPerf();
+		render_image(*camera, background, *world, width, samples_per_pixel, image);
+		const double seconds = counter.EndPerf() / 1000000.0;
+
+		srand(2);
+		counter.StartPerf();
+		render_image(*camera, background, compiled, width, samples_per_pixel, compiled_image);
+		const double compiled_seconds = counter.EndPerf() / 1000000.0;
+
+		// same random sequence: differences only come from hit order and rounding
+		int differing = 0;
+		for (size_t k = 0; k < image.size(); k++)
+			differing += (image[k] - compiled_image[k]).length2() > 1e-6 * samples_per_pixel ? 1 : 0;
+
+		char line[256];
+		snprintf(line, sizeof(line), "  %2d %-20s %7.3f s  compiled %7.3f s  x%.2f   %zu prims (%zu virtual), %.1f ms build, %d pixels differ\n",
+			index, examples[index]._name, seconds, compiled_seconds, seconds / compiled_seconds,
+			compiled.num_primitives(), compiled.num_fallbacks(), compile_ms, differing);
+		std::cerr << line;
+	}
+	return 0;
+}
+
+// error against a long monte carlo reference, brute force vs light sampling at equal spp
+static int bench_nee(int scene, int width, int samples_per_pixel, int reference_spp)
+{
+	const FRoulette roulette;
+
+	shared_ptr<FRayCamera> camera;
+	FColor3 background;
+	shared_ptr<FHittable> world = load_example(scene, camera, background);
+	FLightList lights(*world);
+
+	std::cerr << examples[scene]._name << ", " << lights.size() << " lights, " << width << "x" << width << ", "
+		<< samples_per_pixel << " spp, reference " << reference_spp << " spp\n";
+
+	auto brute_trace = [&](const FRay& ray) { return ray_color_montecarlo(ray, background, *world, roulette); };
+	std::vector<FColor3> reference;
+	render_image(*camera, width, reference_spp, reference, brute_trace);
+
+	const FBenchScore brute = time_and_score(*camera, width, samples_per_pixel, reference, reference_spp, brute_trace);
+	const FBenchScore nee = time_and_score(*camera, width, samples_per_pixel, reference, reference_spp,
+		[&](const FRay& ray) { return ray_color_nee(ray, background, *world, lights, roulette); });
+	print_score("monte carlo", brute);
+	print_score("light sampling", nee);
+
+	char line[256];
+	snprintf(line, sizeof(line), "  rmse ratio %.1f, mse x time ratio %.1f\n", brute.rmse / nee.rmse, brute.cost() / nee.cost());
+	std::cerr << line;
+	return 0;
+}
+
+// convergence of monte carlo, light sampling and mis: error against a long
+// mis reference as the sample count doubles. the monte carlo reference of
+// bench_nee is too noisy around small lights
+static int bench_mis(int scene, int width, int max_spp, int reference_spp)
+{
+	const FRoulette roulette;
+
+	shared_ptr<FRayCamera> camera;
+	FColor3 background;
+	shared_ptr<FHittable> world = load_example(scene, camera, background);
+	FLightList lights(*world);
+
+	std::cerr << examples[scene]._name << ", " << lights.size() << " lights, " << width << "x" << width
+		<< ", mis reference " << reference_spp << " spp\n";
+
+	std::vector<FColor3> reference;
+	render_image(*camera, width, reference_spp, reference, [&](const FRay& ray) { return ray_color_mis(ray, background, *world, lights, roulette); });
+
+	const std::function<FColor3(const FRay&)> methods[] = {
+		[&](const FRay& ray) { return ray_color_montecarlo(ray, background, *world, roulette); },
+		[&](const FRay& ray) { return ray_color_nee(ray, background, *world, lights, roulette); },
+		[&](const FRay& ray) { return ray_color_mis(ray, background, *world, lights, roulette); },
+	};
+
+	char line[256];
+	snprintf(line, sizeof(line), "  %6s   %-27s %-27s %-27s\n", "spp", "monte carlo", "light sampling", "mis");
+	std::cerr << line;
+	for (int spp = 1; spp <= max_spp; spp *= 2)
+	{
+		snprintf(line, sizeof(line), "  %6d", spp);
+		std::cerr << line;
+		for (int m = 0; m < 3; m++)
+		{
+			const FBenchScore score = time_and_score(*camera, width, spp, reference, reference_spp, methods[m]);
+			snprintf(line, sizeof(line), "   %.4f %7.3f s %+6.2f%%", score.rmse, score.seconds, 100 * score.mean);
+			std::cerr << line;
+		}
+		std::cerr << "\n";
+	}
+	return 0;
+}
+
+// error of every sampler against a long random sampler reference as the
+// sample count doubles, mis integrator. time to a target error is read off
+// the rows
+static int bench_sampler(int scene, int width, int max_spp, int reference_spp)
+{
+	const FRoulette roulette;
+
+	shared_ptr<FRayCamera> camera;
+	FColor3 background;
+	shared_ptr<FHittable> world = load_example(scene, camera, background);
+	FLightList lights(*world);
+	auto trace = [&](const FRay& ray) { return ray_color_mis(ray, background, *world, lights, roulette); };
+
+	std::cerr << examples[scene]._name << ", " << width << "x" << width << ", mis, reference " << reference_spp << " spp\n";
+
+	std::vector<FColor3> reference;
+	shared_ptr<FSampler> reference_sampler = make_sampler(ESamplerType::Random);
+	active_sampler = reference_sampler.get();
+	render_image(*camera, width, reference_spp, reference, trace);
+
+	shared_ptr<FSampler> samplers[(int)ESamplerType::Count];
+	char line[256];
+	snprintf(line, sizeof(line), "  %6s", "spp");
+	std::cerr << line;
+	for (int t = 0; t < (int)ESamplerType::Count; t++)
+	{
+		samplers[t] = make_sampler((ESamplerType)t);
+		snprintf(line, sizeof(line), "   %-18s", samplers[t]->name());
+		std::cerr << line;
+	}
+	std::cerr << "\n";
+
+	for (int spp = 1; spp <= max_spp; spp *= 2)
+	{
+		snprintf(line, sizeof(line), "  %6d", spp);
+		std::cerr << line;
+		for (int t = 0; t < (int)ESamplerType::Count; t++)
+		{
+			active_sampler = samplers[t].get();
+			const FBenchScore score = time_and_score(*camera, width, spp, reference, reference_spp, trace);
+			snprintf(line, sizeof(line), "   %.4f %7.3f s  ", score.rmse, score.seconds);
+			std::cerr << line;
+		}
+		std::cerr << "\n";
+	}
+
+	active_sampler = nullptr;
+	return 0;
+}
+
+// fixed probability roulette (the former 0.6 of every integrator) against
+// throughput roulette, mis integrator on every example. the estimator variance
+// is the per pixel variance of the sample luminance, averaged over the image
+static int bench_roulette(int width, int samples_per_pixel)
+{
+	FRoulette fixed;
+	fixed.throughput = false;
+	fixed.survival = 0.6;
+	fixed.min_depth = 0;
+	fixed.max_depth = std::numeric_limits<int>::max();
+	const FRoulette throughput;
+	const FRoulette* modes[2] = { &fixed, &throughput };
+
+	std::cerr << width << "x" << width << ", " << samples_per_pixel << " spp, mis, fixed survival 0.6 vs throughput (min depth "
+		<< throughput.min_depth << ", max depth " << throughput.max_depth << ", survival " << throughput.survival << ")\n";
+	char line[256];
+	snprintf(line, sizeof(line), "     %-20s %-42s %-42s %s\n", "", "fixed 0.6", "throughput", "var x time");
+	std::cerr << line;
+
+	for (int index = 0; index < num_examples; index++)
+	{
+		double seconds[2], variance[2], length_mean[2], length_variance[2];
+		for (int m = 0; m < 2; m++)
+		{
+			shared_ptr<FRayCamera> camera;
+			FColor3 background;
+			shared_ptr<FHittable> world = load_example(index, camera, background);
+			FLightList lights(*world);
+
+			srand(2);
+			FBounceStats stats;
+			double variance_sum = 0.0;
+			FPerformanceCounter counter;
+			counter.StartPerf();
+			for (int j = 0; j < width; ++j)
+			{
+				for (int i = 0; i < width; ++i)
+				{
+					double sum = 0.0, sum2 = 0.0;
+					for (int s = 0; s < samples_per_pixel; ++s)
+					{
+						auto u = (i + random_double()) / (width - 1);
+						auto v = (j + random_double()) / (width - 1);
+						const double y = luminance(ray_color_mis(camera->castRay(u, v), background, *world, lights, *modes[m], &stats));
+						sum += y;
+						sum2 += y * y;
+					}
+					const double mean = sum / samples_per_pixel;
+					variance_sum += std::max(0.0, sum2 / samples_per_pixel - mean * mean);
+				}
+			}
+			seconds[m] = counter.EndPerf() / 1000000.0;
+			variance[m] = variance_sum / (width * width);
+			stats.path_length(length_mean[m], length_variance[m]);
+		}
+
+		snprintf(line, sizeof(line), "  %2d %-20s %6.3f s  var %9.4g  rays %5.2f (var %6.2f)   %6.3f s  var %9.4g  rays %5.2f (var %6.2f)   x%.2f\n",
+			index, examples[index]._name,
+			seconds[0], variance[0], length_mean[0], length_variance[0],
+			seconds[1], variance[1], length_mean[1], length_variance[1],
+			(variance[0] * seconds[0]) / (variance[1] * seconds[1]));
+		std::cerr << line;
+	}
+	return 0;
+}
+
+// denoised image against the noisy one and against more samples, mis
+// integrator, sobol sampler. the denoiser runs on one thread and on all of
+// them, the two results must match bit for bit
+static int bench_denoise(int scene, int width, int samples_per_pixel, int reference_spp)
+{
+	const FRoulette roulette;
+
+	shared_ptr<FRayCamera> camera;
+	FColor3 background;
+	shared_ptr<FHittable> world = load_example(scene, camera, background);
+	FLightList lights(*world);
+	auto trace = [&](const FRay& ray, FPathAovs* aovs) { return ray_color_mis(ray, background, *world, lights, roulette, nullptr, aovs); };
+
+	std::cerr << examples[scene]._name << ", " << width << "x" << width << ", mis, reference " << reference_spp << " spp\n";
+
+	shared_ptr<FSampler> sampler = make_sampler(ESamplerType::Sobol);
+	active_sampler = sampler.get();
+	FDenoiseBuffers reference;
+	render_image_guides(*camera, width, reference_spp, reference, trace);
+
+	char line[256];
+	for (int spp = samples_per_pixel; spp <= samples_per_pixel * 16; spp *= 4)
+	{
+		FDenoiseBuffers buffers;
+		FPerformanceCounter counter;
+		counter.StartPerf();
+		render_image_guides(*camera, width, spp, buffers, trace);
+		const double render_seconds = counter.EndPerf() / 1000000.0;
+
+		FReal rmse, mean;
+		image_error(buffers.color, spp, reference.color, reference_spp, rmse, mean);
+		snprintf(line, sizeof(line), "  %6d spp  noisy     rmse %.4f  mean %+.2f%%  render %7.3f s\n", spp, rmse, 100 * mean, render_seconds);
+		std::cerr << line;
+		if (spp != samples_per_pixel)
+			continue;
+
+		FDenoiseSettings settings;
+		settings.threads = 1;
+		std::vector<FColor3> single, denoised;
+		counter.StartPerf();
+		denoise(buffers, spp, settings, single);
+		const double single_seconds = counter.EndPerf() / 1000000.0;
+
+		settings.threads = std::max(hardware_threads(), 4);
+		counter.StartPerf();
+		denoise(buffers, spp, settings, denoised);
+		const double seconds = counter.EndPerf() / 1000000.0;
+
+		bool identical = true;
+		for (size_t k = 0; k < denoised.size(); k++)
+			identical = identical && single[k].x() == denoised[k].x() && single[k].y() == denoised[k].y() && single[k].z() == denoised[k].z();
+
+		image_error(denoised, 1, reference.color, reference_spp, rmse, mean);
+		snprintf(line, sizeof(line), "  %6d spp  denoised  rmse %.4f  mean %+.2f%%  denoise %7.3f s on %d threads, %7.3f s on 1, %s\n",
+			spp, rmse, 100 * mean, seconds, settings.threads, single_seconds, identical ? "identical" : "DIFFERENT");
+		std::cerr << line;
+	}
+
+	active_sampler = nullptr;
+	return 0;
+}
+
+// mis with the light to sample picked uniformly, by power and by the light
+// bvh, at equal spp against a long light bvh reference
+static int bench_lights(int scene, int width, int samples_per_pixel, int reference_spp)
+{
+	const FRoulette roulette;
+
+	shared_ptr<FRayCamera> camera;
+	FColor3 background;
+	shared_ptr<FHittable> world = load_example(scene, camera, background);
+
+	std::cerr << examples[scene]._name << ", " << width << "x" << width << ", " << samples_per_pixel
+		<< " spp, bvh reference " << reference_spp << " spp\n";
+
+	const FLightList reference_lights(*world, nullptr, ELightSampling::Bvh);
+	std::vector<FColor3> reference;
+	render_image(*camera, width, reference_spp, reference, [&](const FRay& ray) { return ray_color_mis(ray, background, *world, reference_lights, roulette); });
+
+	char line[256];
+	double uniform_cost = 0.0;
+	for (int s = 0; s < (int)ELightSampling::Count; s++)
+	{
+		FPerformanceCounter counter;
+		counter.StartPerf();
+		const FLightList lights(*world, nullptr, (ELightSampling)s);
+		const double build_ms = counter.EndPerf() / 1000.0;
+
+		const FBenchScore score = time_and_score(*camera, width, samples_per_pixel, reference, reference_spp,
+			[&](const FRay& ray) { return ray_color_mis(ray, background, *world, lights, roulette); });
+		if (s == 0) uniform_cost = score.cost();
+
+		snprintf(line, sizeof(line), "  %-8s %4zu lights, %6.2f ms build  %7.3f s  rmse %.4f  mean %+6.2f%%  mse x time vs uniform x%.2f\n",
+			light_sampling_name((ELightSampling)s), lights.size(), build_ms, score.seconds, score.rmse, 100 * score.mean, uniform_cost / score.cost());
+		std::cerr << line;
+	}
+	return 0;
+}
+
+// clear sky over a dark ground with a small sun, 35 degrees up, as a flat
+// (not run-length encoded) radiance rgbe file. the sun outshines the sky
+// several times from 0.1% of the directions
+static bool write_sky_hdr(const char* filename, int width, int height)
+{
+	FILE* fp = fopen(filename, "wb");
+	if (!fp) return false;
+
+	fprintf(fp, "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y %d +X %d\n", height, width);
+	const FReal sun_elevation = 35 * kPiOver180, sun_phi = 60 * kPiOver180;
+	const FVec3 sun(cos(sun_elevation) * sin(sun_phi), sin(sun_elevation), -cos(sun_elevation) * cos(sun_phi));
+	const FReal sun_cos = cos(1.5 * kPiOver180);
+
+	std::vector<unsigned char> row(width * 4);
+	for (int j = 0; j < height; j++)
+	{
+		const FReal theta = kPi * (j + 0.5) / height;
+		for (int i = 0; i < width; i++)
+		{
+			// the mapping of FEnvironment
+			const FReal phi = kTwoPi * ((i + 0.5) / width - 0.5);
+			const FVec3 d(sin(theta) * sin(phi), cos(theta), -sin(theta) * cos(phi));
+
+			FColor3 c = d.y() > 0 ? FColor3(0.3, 0.5, 1.0) * (1 - 0.6 * d.y()) : FColor3(0.15, 0.12, 0.1);
+			if (dot(d, sun) > sun_cos)
+				c = FColor3(5000, 4750, 4250);
+
+			const double v = std::max(c.x(), std::max(c.y(), c.z()));
+			int e = 0;
+			const double scale = frexp(v, &e) * 256.0 / v;
+			unsigned char* p = &row[i * 4];
+			p[0] = (unsigned char)(c.x() * scale);
+			p[1] = (unsigned char)(c.y() * scale);
+			p[2] = (unsigned char)(c.z() * scale);
+			p[3] = (unsigned char)(e + 128);
+		}
+		fwrite(row.data(), 1, row.size(), fp);
+	}
+
+	fclose(fp);
+	return true;
+}
+
+// an example under an environment map: monte carlo, light sampling and mis
+// at equal spp against a long mis reference
+static int bench_environment(int scene, int width, int samples_per_pixel, int reference_spp, const char* filename)
+{
+	const FRoulette roulette;
+
+	const FEnvironment environment(filename);
+	if (!environment.valid())
+		return 1;
+
+	shared_ptr<FRayCamera> camera;
+	FColor3 color;
+	shared_ptr<FHittable> world = load_example(scene, camera, color);
+	const FBackground background(color, &environment);
+	const FLightList lights(*world, &environment);
+
+	std::cerr << examples[scene]._name << " under " << filename << ", " << lights.size() << " lights + environment (picked "
+		<< 100 * lights.environment_pdf() << "%), " << width << "x" << width << ", " << samples_per_pixel
+		<< " spp, mis reference " << reference_spp << " spp\n";
+
+	std::vector<FColor3> reference;
+	render_image(*camera, width, reference_spp, reference, [&](const FRay& ray) { return ray_color_mis(ray, background, *world, lights, roulette); });
+
+	const char* names[] = { "monte carlo", "light sampling", "mis" };
+	const std::function<FColor3(const FRay&)> methods[] = {
+		[&](const FRay& ray) { return ray_color_montecarlo(ray, background, *world, roulette); },
+		[&](const FRay& ray) { return ray_color_nee(ray, background, *world, lights, roulette); },
+		[&](const FRay& ray) { return ray_color_mis(ray, background, *world, lights, roulette); },
+	};
+
+	for (int m = 0; m < 3; m++)
+	{
+		print_score(names[m], time_and_score(*camera, width, samples_per_pixel, reference, reference_spp, methods[m]));
+	}
+	return 0;
+}
+
+// cornell noise smoke with majorant grids from a single cell to 32^3: build
+// time, render time and error of mis against a long 16^3 reference. coarser
+// grids take more null collisions through the thin parts, the images agree
+static int bench_media(int width, int samples_per_pixel, int reference_spp)
+{
+	const FRoulette roulette;
+
+	srand(1);
+	shared_ptr<FRayCamera> camera;
+	FColor3 background;
+	shared_ptr<FHittable> reference_world = make_cornell_noise_smoke(camera, background, 16);
+	const FLightList reference_lights(*reference_world);
+
+	std::cerr << "cornell noise smoke, " << width << "x" << width << ", " << samples_per_pixel << " spp, mis reference "
+		<< reference_spp << " spp\n";
+
+	std::vector<FColor3> reference;
+	render_image(*camera, width, reference_spp, reference, [&](const FRay& ray) { return ray_color_mis(ray, background, *reference_world, reference_lights, roulette); });
+
+	char line[256];
+	const int resolutions[] = { 1, 4, 16, 32 };
+	for (int resolution : resolutions)
+	{
+		FPerformanceCounter counter;
+		counter.StartPerf();
+		shared_ptr<FHittable> world = make_cornell_noise_smoke(camera, background, resolution);
+		const double build_ms = counter.EndPerf() / 1000.0;
+		const FLightList lights(*world);
+
+		const FBenchScore score = time_and_score(*camera, width, samples_per_pixel, reference, reference_spp,
+			[&](const FRay& ray) { return ray_color_mis(ray, background, *world, lights, roulette); });
+		snprintf(line, sizeof(line), "  grid %2d^3  %7.1f ms build  %7.3f s  rmse %.4f  mean %+6.2f%%\n",
+			resolution, build_ms, score.seconds, score.rmse, 100 * score.mean);
+		std::cerr << line;
+	}
+	return 0;
+}
+
+void display_benchmark_usage()
+{
+	std::cerr << "        program.exe -bench loader [mesh.obj|mesh.ply]" << std::endl;
+	std::cerr << "            without a file a 2M triangle torus is written to bench_mesh.obj/.ply first" << std::endl;
+	std::cerr << "        program.exe -bench precision [width] [spp]" << std::endl;
+	std::cerr << "            renders every example, run the double and the float build to compare them" << std::endl;
+	std::cerr << "        program.exe -bench vector" << std::endl;
+	std::cerr << "            vec3 kernels and FSphere::hit, build with RT_VEC3_SCALAR to compare" << std::endl;
+	std::cerr << "        program.exe -bench compiled [width] [spp]" << std::endl;
+	std::cerr << "            render time of every example as built and as an FCompiledScene" << std::endl;
+	std::cerr << "        program.exe -bench nee [sceneId] [width] [spp] [reference spp]" << std::endl;
+	std::cerr << "            error of monte carlo and light sampling against a monte carlo reference" << std::endl;
+	std::cerr << "        program.exe -bench mis [sceneId] [width] [max spp] [reference spp]" << std::endl;
+	std::cerr << "            rmse, time and mean error of monte carlo, light sampling and mis as spp doubles, against mis" << std::endl;
+	std::cerr << "        program.exe -bench sampler [sceneId] [width] [max spp] [reference spp]" << std::endl;
+	std::cerr << "            rmse and time of every sampler as spp doubles" << std::endl;
+	std::cerr << "        program.exe -bench lights [sceneId] [width] [spp] [reference spp]" << std::endl;
+	std::cerr << "            rmse and time of mis with uniform, power and light bvh light selection" << std::endl;
+	std::cerr << "        program.exe -bench env [sceneId] [width] [spp] [reference spp] [file.hdr]" << std::endl;
+	std::cerr << "            rmse of monte carlo, light sampling and mis under an environment map," << std::endl;
+	std::cerr << "            without a file a sky with a small sun is written to bench_sky.hdr first" << std::endl;
+	std::cerr << "        program.exe -bench media [width] [spp] [reference spp]" << std::endl;
+	std::cerr << "            time and rmse of the cornell noise smoke with majorant grids of 1 to 32^3 cells" << std::endl;
+	std::cerr << "        program.exe -bench roulette [width] [spp]" << std::endl;
+	std::cerr << "            variance, time and rays per path of fixed vs throughput russian roulette, every example" << std::endl;
+	std::cerr << "        program.exe -bench denoise [sceneId] [width] [spp] [reference spp]" << std::endl;
+	std::cerr << "            rmse of the denoised image against noisy ones at 1x, 4x and 16x spp, denoiser threads" << std::endl;
+	std::cerr << "        program.exe -bench packets [sceneId] [width]" << std::endl;
+	std::cerr << "            primary ray throughput of single rays vs ray packets, all scenes by default" << std::endl;
+}
+
+int run_benchmark(int argc, char* argv[])
+{
+	if (argc >= 1 && strcmp(argv[0], "loader") == 0)
+	{
+		if (argc >= 2)
+		{
+			return bench_mesh_loader(argv[1]);
+		}
+
+		const int rings = 1000, sides = 1000;
+		std::cerr << "writing bench_mesh.obj and bench_mesh.ply ..." << std::endl;
+		if (!write_torus_obj("bench_mesh.obj", rings, sides) || !write_torus_ply("bench_mesh.ply", rings, sides))
+		{
+			std::cerr << "ERROR: Could not write benchmark meshes." << std::endl;
+			return 1;
+		}
+		return bench_mesh_loader("bench_mesh.obj") | bench_mesh_loader("bench_mesh.ply");
+	}
+
+	if (argc >= 1 && strcmp(argv[0], "precision") == 0)
+	{
+		const int width = (argc >= 2) ? atoi(argv[1]) : 100;
+		const int samples_per_pixel = (argc >= 3) ? atoi(argv[2]) : 16;
+		return bench_precision(width, samples_per_pixel);
+	}
+
+	if (argc >= 1 && strcmp(argv[0], "vector") == 0)
+	{
+		return bench_vector();
+	}
+
+	if (argc >= 1 && strcmp(argv[0], "compiled") == 0)
+	{
+		const int width = (argc >= 2) ? atoi(argv[1]) : 100;
+		const int samples_per_pixel = (argc >= 3) ? atoi(argv[2]) : 16;
+		return bench_compiled(width, samples_per_pixel);
+	}
+
+	if (argc >= 1 && strcmp(argv[0], "nee") == 0)
+	{
+		const int scene = (argc >= 2) ? atoi(argv[1]) : 6;
+		const int width = (argc >= 3) ? atoi(argv[2]) : 64;
+		const int samples_per_pixel = (argc >= 4) ? atoi(argv[3]) : 16;
+		const int reference_spp = (argc >= 5) ? atoi(argv[4]) : 4096;
+		if (scene < 0 || scene >= num_examples)
+		{
+			display_benchmark_usage();
+			return 1;
+		}
+		return bench_nee(scene, width, samples_per_pixel, reference_spp);
+	}
+
+	if (argc >= 1 && strcmp(argv[0], "mis") == 0)
+	{
+		const int scene = (argc >= 2) ? atoi(argv[1]) : 11;
+		const int width = (argc >= 3) ? atoi(argv[2]) : 64;
+		const int max_spp = (argc >= 4) ? atoi(argv[3]) : 64;
+		const int reference_spp = (argc >= 5) ? atoi(argv[4]) : 4096;
+		if (scene < 0 || scene >= num_examples)
+		{
+			display_benchmark_usage();
+			return 1;
+		}
+		return bench_mis(scene, width, max_spp, reference_spp);
+	}
+
+	if (argc >= 1 && strcmp(argv[0], "sampler") == 0)
+	{
+		const int scene = (argc >= 2) ? atoi(argv[1]) : 6;
+		const int width = (argc >= 3) ? atoi(argv[2]) : 64;
+		const int max_spp = (argc >= 4) ? atoi(argv[3]) : 64;
+		const int reference_spp = (argc >= 5) ? atoi(argv[4]) : 4096;
+		if (scene < 0 || scene >= num_examples)
+		{
+			display_benchmark_usage();
+			return 1;
+		}
+		return bench_sampler(scene, width, max_spp, reference_spp);
+	}
+
+	if (argc >= 1 && strcmp(argv[0], "lights") == 0)
+	{
+		const int scene = (argc >= 2) ? atoi(argv[1]) : 15;
+		const int width = (argc >= 3) ? atoi(argv[2]) : 64;
+		const int samples_per_pixel = (argc >= 4) ? atoi(argv[3]) : 16;
+		const int reference_spp = (argc >= 5) ? atoi(argv[4]) : 1024;
+		if (scene < 0 || scene >= num_examples)
+		{
+			display_benchmark_usage();
+			return 1;
+		}
+		return bench_lights(scene, width, samples_per_pixel, reference_spp);
+	}
+
+	if (argc >= 1 && strcmp(argv[0], "env") == 0)
+	{
+		const int scene = (argc >= 2) ? atoi(argv[1]) : 12;
+		const int width = (argc >= 3) ? atoi(argv[2]) : 64;
+		const int samples_per_pixel = (argc >= 4) ? atoi(argv[3]) : 16;
+		const int reference_spp = (argc >= 5) ? atoi(argv[4]) : 1024;
+		if (scene < 0 || scene >= num_examples)
+		{
+			display_benchmark_usage();
+			return 1;
+		}
+		if (argc >= 6)
+		{
+			return bench_environment(scene, width, samples_per_pixel, reference_spp, argv[5]);
+		}
+
+		std::cerr << "writing bench_sky.hdr ..." << std::endl;
+		if (!write_sky_hdr("bench_sky.hdr", 512, 256))
+		{
+			std::cerr << "ERROR: Could not write benchmark environment." << std::endl;
+			return 1;
+		}
+		return bench_environment(scene, width, samples_per_pixel, reference_spp, "bench_sky.hdr");
+	}
+
+	if (argc >= 1 && strcmp(argv[0], "media") == 0)
+	{
+		const int width = (argc >= 2) ? atoi(argv[1]) : 64;
+		const int samples_per_pixel = (argc >= 3) ? atoi(argv[2]) : 16;
+		const int reference_spp = (argc >= 4) ? atoi(argv[3]) : 512;
+		return bench_media(width, samples_per_pixel, reference_spp);
+	}
+
+	if (argc >= 1 && strcmp(argv[0], "roulette") == 0)
+	{
+		const int width = (argc >= 2) ? atoi(argv[1]) : 64;
+		const int samples_per_pixel = (argc >= 3) ? atoi(argv[2]) : 16;
+		return bench_roulette(width, samples_per_pixel);
+	}
+
+	if (argc >= 1 && strcmp(argv[0], "denoise") == 0)
+	{
+		const int scene = (argc >= 2) ? atoi(argv[1]) : 6;
+		const int width = (argc >= 3) ? atoi(argv[2]) : 128;
+		const int samples_per_pixel = (argc >= 4) ? atoi(argv[3]) : 16;
+		const int reference_spp = (argc >= 5) ? atoi(argv[4]) : 2048;
+		if (scene < 0 || scene >= num_examples)
+		{
+			display_benchmark_usage();
+			return 1;
+		}
+		return bench_denoise(scene, width, samples_per_pixel, reference_spp);
+	}
+
+	if (argc >= 1 && strcmp(argv[0], "packets") == 0)
+	{
+		const int scene = (argc >= 2) ? atoi(argv[1]) : -1;
+		const int width = (argc >= 3) ? atoi(argv[2]) : 600;
+		if (scene >= num_examples)
+		{
+			display_benchmark_usage();
+			return 1;
+		}
+		return scene < 0 ? bench_packets(0, num_examples - 1, width) : bench_packets(scene, scene, width);
+	}
+
+	display_benchmark_usage();
+	return 1;
+}
@@ -0,0 +1,11 @@
+// benchmarks
+// usage: program.exe -bench name [args]
+//
+
+#pragma once
+
+
+void display_benchmark_usage();
+
+// argv[0] is the benchmark name
+int run_benchmark(int argc, char* argv[]);
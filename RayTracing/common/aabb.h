@@ -24,7 +24,7 @@ public:
 	const FPoint3& min() const { return _min; }
 	const FPoint3& max() const { return _max; }
 
-	bool hit(const FRay& ray, double tmin, double tmax) const
+	bool hit(const FRay& ray, FReal tmin, FReal tmax) const
 	{
 		FPoint3 origin = ray.Origin();
 		FVec3 dir = ray.Direction();
@@ -45,7 +45,7 @@ public:
 	}
 
 	// area of surface
-	double area() const 
+	FReal area() const 
 	{
 		auto a = _max.x() - _min.x();
 		auto b = _max.y() - _min.y();
@@ -16,33 +16,42 @@ using std::shared_ptr;
 using std::make_shared;
 using std::sqrt;
 
+// scalar type of the math core, build with RT_SCALAR_FLOAT for single precision
+#ifdef RT_SCALAR_FLOAT
+typedef float FReal;
+#else
+typedef double FReal;
+#endif
+
 // constants
-const double kInfinity = std::numeric_limits<double>::infinity();
-const double kPi = 3.1415926535897932385;
-const double kHalfPi = kPi * 0.5;
-const double kTwoPi = kPi * 2.0;
-const double kOneOverPi = 1.0 / kPi;
-const double kPiOver180 = kPi / 180.0;
-const double KINDA_SMALL_NUMBER = 0.0001;
+const FReal kInfinity = std::numeric_limits<FReal>::infinity();
+const FReal kPi = 3.1415926535897932385;
+const FReal kHalfPi = kPi * 0.5;
+const FReal kTwoPi = kPi * 2.0;
+const FReal kOneOverPi = 1.0 / kPi;
+const FReal kPiOver180 = kPi / 180.0;
+const FReal KINDA_SMALL_NUMBER = 0.0001;
 
 // utility functions
-inline double degrees_2_radians(double degrees)
+inline FReal degrees_2_radians(FReal degrees)
 {
 	return degrees * kPiOver180;
 }
 
-inline double clamp(double x, double min, double max)
+inline FReal clamp(FReal x, FReal min, FReal max)
 {
 	if (x < min) return min;
 	if (x > max) return max;
 	return x;
 }
 
-inline double random_double() {
-	return rand() * (1.0 / (RAND_MAX + 1.0));
+inline FReal random_double() {
+	// [0, 1), rounding to float may reach 1
+	const FReal r = static_cast<FReal>(rand() * (1.0 / (RAND_MAX + 1.0)));
+	return r < FReal(1) ? r : FReal(1) - std::numeric_limits<FReal>::epsilon() * FReal(0.5);
 }
 
-inline double random_double(double min, double max)
+inline FReal random_double(FReal min, FReal max)
 {
 	// return a random real in [min, max).
 	return min + (max - min) * random_double();
@@ -51,17 +60,17 @@ inline double random_double(double min, double max)
 inline int random_int(int min, int max)
 {
 	// return a random integer in [min, max]
-	return static_cast<int>(random_double((double)min, (double)(max + 1)));
+	return static_cast<int>(random_double((FReal)min, (FReal)(max + 1)));
 }
 
 // linear interpolation
 template<typename T>
-T lerp(const T& a, const T& b, double t)
+T lerp(const T& a, const T& b, FReal t)
 {
 	return (a + t * (b - a));
 }
 
-inline double fract(double x)
+inline FReal fract(FReal x)
 {
 	return x - floor(x);
 }
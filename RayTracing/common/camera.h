@@ -12,13 +12,14 @@
 #include "vec3.h"
 #include "ray.h"
 #include "plane.h"
+#include "sampler.h"
 
 
 // abstract camera
 class FRayCamera
 {
 public:
-	virtual FRay castRay(double u, double v) const = 0;
+	virtual FRay castRay(FReal u, FReal v) const = 0;
 };
 
 
@@ -30,11 +31,11 @@ public:
 		FPoint3 lookfrom,
 		FPoint3	lookat,
 		FVec3	vup,
-		double vfov, // vertical field-of-view in degree
-		double aspect_ratio,
-		double film_dist,
-		double t0,  // shutter open timestamp
-		double t1)  // shutter close timestamp
+		FReal vfov, // vertical field-of-view in degree
+		FReal aspect_ratio,
+		FReal film_dist,
+		FReal t0,  // shutter open timestamp
+		FReal t1)  // shutter close timestamp
 	{
 		auto theta = degrees_2_radians(vfov);
 		auto h = tan(theta * 0.5) * film_dist;
@@ -54,9 +55,9 @@ public:
 		time1 = t1;
 	}
 
-	virtual FRay castRay(double u, double v) const override 
+	virtual FRay castRay(FReal u, FReal v) const override 
 	{
-		auto timestamp = random_double(time0, time1);
+		auto timestamp = lerp(time0, time1, sample_1d());
 		return FRay(origin, lower_left_corner + u * horizontal + v * vertical - origin, timestamp);
 	}
 
@@ -65,8 +66,8 @@ protected:
 	FVec3	lower_left_corner;
 	FVec3	horizontal;  // virtual viewport x
 	FVec3	vertical;    // virtual viewport y
-	double  time0;
-	double  time1;
+	FReal  time0;
+	FReal  time1;
 };
 
 
@@ -79,15 +80,15 @@ public:
 		FPoint3 lookfrom,
 		FPoint3	lookat,
 		FVec3	vup,
-		double vfov, // vertical field-of-view in degree
-		double aspect_ratio,
-		double aperture,
-		double focus_length,
-		double film_dist,
-		double photo_height,
-		double coc_pixel,
-		double t0,  // shutter open timestamp
-		double t1)  // shutter close timestamp
+		FReal vfov, // vertical field-of-view in degree
+		FReal aspect_ratio,
+		FReal aperture,
+		FReal focus_length,
+		FReal film_dist,
+		FReal photo_height,
+		FReal coc_pixel,
+		FReal t0,  // shutter open timestamp
+		FReal t1)  // shutter close timestamp
 	{
 		auto theta = degrees_2_radians(vfov);
 		auto h = tan(theta * 0.5) * film_dist;
@@ -104,7 +105,7 @@ public:
 		lower_left_corner = origin - (horizontal * 0.5) - (vertical * 0.5) + w * film_dist;
 
 		// zo = (f * zi) / (zi - f)
-		double zo = (focus_length * film_dist) / (film_dist - focus_length);
+		FReal zo = (focus_length * film_dist) / (film_dist - focus_length);
 		FVec3 object_plane_loc = origin - zo * w;
 		object_plane = FPlane(w, object_plane_loc);
 
@@ -113,14 +114,14 @@ public:
 		// calculate depth of field (reference GAMES101_Lecture_19.pdf)
 		{
 			// calculate circle of confusion
-			double coc = film_height * coc_pixel / photo_height;
-			double Num = focus_length / aperture;
-			double f2 = focus_length * focus_length;
-			double Dsf2 = zo * f2;
-			double NCDsmiusF = Num * coc * (zo - focus_length);
+			FReal coc = film_height * coc_pixel / photo_height;
+			FReal Num = focus_length / aperture;
+			FReal f2 = focus_length * focus_length;
+			FReal Dsf2 = zo * f2;
+			FReal NCDsmiusF = Num * coc * (zo - focus_length);
 
-			double Df = Dsf2 / (f2 - NCDsmiusF);
-			double Dn = Dsf2 / (f2 + NCDsmiusF);
+			FReal Df = Dsf2 / (f2 - NCDsmiusF);
+			FReal Dn = Dsf2 / (f2 + NCDsmiusF);
 
 			depthFieldFar = Df;
 			depthFieldNear = Dn;
@@ -130,15 +131,15 @@ public:
 		time1 = t1;
 	}
 
-	virtual FRay castRay(double s, double t) const override
+	virtual FRay castRay(FReal s, FReal t) const override
 	{
-		auto timestamp = random_double(time0, time1);
+		auto timestamp = lerp(time0, time1, sample_1d());
 
 		// flip s, t
 		s = 1.0 - s;
 		t = 1.0 - t;
 
-		FVec3 rd = lens_radius * random_in_unit_disk();
+		FVec3 rd = lens_radius * sample_unit_disk();
 		FVec3 offset = u * rd.x() + v * rd.y();
 
 		FPoint3 p0 = lower_left_corner + s * horizontal + t * vertical;
@@ -152,7 +153,7 @@ public:
 		return FRay(p1, p2 - p1, timestamp);
 	}
 
-	void GetDepthOfField(double& Far, double& Near)
+	void GetDepthOfField(FReal& Far, FReal& Near)
 	{
 		Far = depthFieldFar;
 		Near = depthFieldNear;
@@ -165,11 +166,11 @@ protected:
 	FVec3	vertical;    // film y
 	FVec3	u, v, w;
 	FPlane	object_plane;
-	double	lens_radius;
-	double	time0;
-	double	time1;
+	FReal	lens_radius;
+	FReal	time0;
+	FReal	time1;
 
 	// depth of field
-	double	depthFieldFar;
-	double  depthFieldNear;
+	FReal	depthFieldFar;
+	FReal  depthFieldNear;
 };
@@ -5,7 +5,7 @@
 #include "color.h"
 
 
-void write_color(std::ostream& out, FColor3& pixel_color, int samples_per_pixel, double gamma)
+void write_color(std::ostream& out, const FColor3& pixel_color, int samples_per_pixel, FReal gamma)
 {
 	auto r = pixel_color.x();
 	auto g = pixel_color.y();
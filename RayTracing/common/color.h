@@ -8,5 +8,11 @@
 #include "vec3.h"
 
 
-void write_color(std::ostream& out, FColor3& pixel_color, int samples_per_pixel, double gamma = 1.0);
+void write_color(std::ostream& out, const FColor3& pixel_color, int samples_per_pixel, FReal gamma = 1.0);
+
+// rec. 709 luminance of a linear color
+inline FReal luminance(const FColor3& c)
+{
+	return 0.2126 * c.x() + 0.7152 * c.y() + 0.0722 * c.z();
+}
 
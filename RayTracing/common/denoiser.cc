@@ -0,0 +1,190 @@
+// denoiser
+//
+//
+
+#include "denoiser.h"
+#include <algorithm>
+#include <cmath>
+#include "parallel.h"
+
+
+// albedo below this is not divided out, the illumination would only blow up noise
+static const FReal kMinAlbedo = 0.01;
+
+// 5 taps of the b3-spline
+static const FReal kKernel[5] = { 1.0 / 16, 1.0 / 4, 3.0 / 8, 1.0 / 4, 1.0 / 16 };
+
+void FDenoiseBuffers::resize(int w, int h)
+{
+	width = w;
+	height = h;
+	const size_t n = (size_t)w * h;
+	color.assign(n, FColor3(0, 0, 0));
+	luminance2.assign(n, 0);
+	albedo.assign(n, FColor3(0, 0, 0));
+	normal.assign(n, FVec3(0, 0, 0));
+	depth.assign(n, 0);
+}
+
+static FColor3 demodulate(const FColor3& c, const FColor3& albedo)
+{
+	FColor3 out;
+	for (int k = 0; k < 3; k++) out[k] = albedo[k] > kMinAlbedo ? c[k] / albedo[k] : c[k];
+	return out;
+}
+
+static FColor3 remodulate(const FColor3& c, const FColor3& albedo)
+{
+	FColor3 out;
+	for (int k = 0; k < 3; k++) out[k] = albedo[k] > kMinAlbedo ? c[k] * albedo[k] : c[k];
+	return out;
+}
+
+// rows of the image split over threads, row j goes to thread j % threads
+template<typename Fn>
+static void parallel_rows(int height, int threads, const Fn& fn)
+{
+	parallel_for(threads, [&](int t) {
+		for (int j = t; j < height; j += threads) fn(j);
+	});
+}
+
+void denoise(const FDenoiseBuffers& buffers, int samples_per_pixel, const FDenoiseSettings& settings, std::vector<FColor3>& out)
+{
+	const int width = buffers.width;
+	const int height = buffers.height;
+	const size_t n = (size_t)width * height;
+	const int threads = std::min(settings.threads > 0 ? settings.threads : hardware_threads(), std::max(height, 1));
+	const FReal inv_spp = 1.0 / samples_per_pixel;
+
+	// pixel means: illumination and its variance, and the guides
+	std::vector<FColor3> illumination(n), albedo(n);
+	std::vector<FVec3> normal(n);
+	std::vector<FReal> depth(n), variance(n), gradient(n);
+	for (size_t p = 0; p < n; p++)
+	{
+		const FColor3 c = buffers.color[p] * inv_spp;
+		albedo[p] = buffers.albedo[p] * inv_spp;
+		illumination[p] = demodulate(c, albedo[p]);
+
+		const FReal length = buffers.normal[p].length();
+		normal[p] = length > 0 ? buffers.normal[p] / length : FVec3(0, 0, 0);
+		depth[p] = buffers.depth[p] * inv_spp;
+
+		// variance of the mean, scaled like the illumination
+		const FReal y = luminance(c);
+		const FReal sample_variance = std::max<FReal>(0, buffers.luminance2[p] * inv_spp - y * y);
+		const FReal a = std::max(luminance(albedo[p]), kMinAlbedo);
+		variance[p] = sample_variance * inv_spp / (a * a);
+	}
+
+	// depth change per pixel, the smaller one-sided difference on each axis so
+	// a silhouette next to the pixel does not count
+	for (int j = 0; j < height; j++)
+	{
+		for (int i = 0; i < width; i++)
+		{
+			const FReal z = depth[j * width + i];
+			FReal g = 0;
+			if (z > 0)
+			{
+				FReal gx = kInfinity, gy = kInfinity;
+				if (i > 0 && depth[j * width + i - 1] > 0) gx = std::min(gx, std::fabs(depth[j * width + i - 1] - z));
+				if (i + 1 < width && depth[j * width + i + 1] > 0) gx = std::min(gx, std::fabs(depth[j * width + i + 1] - z));
+				if (j > 0 && depth[(j - 1) * width + i] > 0) gy = std::min(gy, std::fabs(depth[(j - 1) * width + i] - z));
+				if (j + 1 < height && depth[(j + 1) * width + i] > 0) gy = std::min(gy, std::fabs(depth[(j + 1) * width + i] - z));
+				g = std::max(gx < kInfinity ? gx : 0, gy < kInfinity ? gy : 0);
+			}
+			gradient[j * width + i] = g;
+		}
+	}
+
+	std::vector<FColor3> next_illumination(n);
+	std::vector<FReal> next_variance(n), blurred_variance(n);
+	for (int iteration = 0; iteration < settings.iterations; iteration++)
+	{
+		const int step = 1 << iteration;
+
+		// 3x3 gaussian of the variance, a single pixel estimate is too noisy to trust
+		parallel_rows(height, threads, [&](int j) {
+			for (int i = 0; i < width; i++)
+			{
+				FReal sum = 0, weight = 0;
+				for (int dy = -1; dy <= 1; dy++)
+				{
+					for (int dx = -1; dx <= 1; dx++)
+					{
+						const int x = i + dx, y = j + dy;
+						if (x < 0 || x >= width || y < 0 || y >= height)
+							continue;
+						const FReal w = (dx == 0 ? 0.5 : 0.25) * (dy == 0 ? 0.5 : 0.25);
+						sum += w * variance[y * width + x];
+						weight += w;
+					}
+				}
+				blurred_variance[j * width + i] = sum / weight;
+			}
+		});
+
+		parallel_rows(height, threads, [&](int j) {
+			for (int i = 0; i < width; i++)
+			{
+				const size_t p = (size_t)j * width + i;
+				const FVec3& np = normal[p];
+				const bool miss_p = depth[p] <= 0;
+				const FReal zp = depth[p];
+				const FReal lp = luminance(illumination[p]);
+				const FReal luminance_scale = settings.sigma_luminance * std::sqrt(blurred_variance[p]) + 1e-8;
+
+				const FReal center = kKernel[2] * kKernel[2];
+				FColor3 sum = center * illumination[p];
+				FReal weight = center;
+				FReal sum_variance = center * center * variance[p];
+				for (int ky = -2; ky <= 2; ky++)
+				{
+					for (int kx = -2; kx <= 2; kx++)
+					{
+						const int x = i + kx * step, y = j + ky * step;
+						if ((kx == 0 && ky == 0) || x < 0 || x >= width || y < 0 || y >= height)
+							continue;
+
+						const size_t q = (size_t)y * width + x;
+						const FReal zq = depth[q];
+						FReal w_normal;
+						if (miss_p || zq <= 0)
+						{
+							w_normal = (miss_p && zq <= 0) ? 1 : 0;
+						}
+						else
+						{
+							w_normal = std::pow(std::max<FReal>(0, dot(np, normal[q])), settings.sigma_normal);
+						}
+						if (w_normal <= 0)
+							continue;
+
+						const FReal expected_dz = settings.sigma_depth * gradient[p] * step * (std::abs(kx) + std::abs(ky));
+						const FReal e_depth = std::fabs(zp - zq) / (expected_dz + 1e-3 * std::max(zp, zq) + 1e-8);
+						const FReal e_luminance = std::fabs(lp - luminance(illumination[q])) / luminance_scale;
+
+						const FReal w = kKernel[kx + 2] * kKernel[ky + 2] * w_normal * std::exp(-(e_depth + e_luminance));
+						sum += w * illumination[q];
+						weight += w;
+						sum_variance += w * w * variance[q];
+					}
+				}
+
+				next_illumination[p] = sum / weight;
+				next_variance[p] = sum_variance / (weight * weight);
+			}
+		});
+
+		illumination.swap(next_illumination);
+		variance.swap(next_variance);
+	}
+
+	out.resize(n);
+	for (size_t p = 0; p < n; p++)
+	{
+		out[p] = remodulate(illumination[p], albedo[p]);
+	}
+}
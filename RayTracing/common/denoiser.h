@@ -0,0 +1,57 @@
+// denoiser
+// edge-avoiding a-trous wavelet filter (dammertz et al. 2010) with the
+// variance guided luminance weight of svgf (schied et al. 2017), spatial only.
+// the image is divided by the first-hit albedo, the illumination left is
+// filtered with 5x5 b3-spline kernels spread 1, 2, 4, ... pixels apart, and
+// multiplied back. every tap is weighted down by the differences of normal,
+// depth and luminance to the center pixel, so edges and texture survive.
+//
+// deterministic: each pass reads the previous one only, the result does not
+// depend on the number of threads.
+//
+
+#pragma once
+
+#include <vector>
+#include "basic.h"
+#include "vec3.h"
+#include "color.h"
+
+
+// per pixel sums of the samples and of their guides, row j at j * width
+struct FDenoiseBuffers
+{
+	int width = 0;
+	int height = 0;
+	std::vector<FColor3> color;
+	std::vector<FReal>	luminance2;  // squared sample luminance, for the variance
+	std::vector<FColor3> albedo;
+	std::vector<FVec3>	normal;
+	std::vector<FReal>	depth;
+
+	void resize(int w, int h);
+
+	// one sample and the guides where its primary ray hit: albedo, normal
+	// facing the ray and distance, normal and depth are zero on a miss
+	void add(int pixel, const FColor3& sample, const FColor3& hit_albedo, const FVec3& hit_normal, FReal hit_depth)
+	{
+		const FReal y = luminance(sample);
+		color[pixel] += sample;
+		luminance2[pixel] += y * y;
+		albedo[pixel] += hit_albedo;
+		normal[pixel] += hit_normal;
+		depth[pixel] += hit_depth;
+	}
+};
+
+struct FDenoiseSettings
+{
+	int		iterations = 5;         // kernel spread 2^iterations pixels
+	FReal	sigma_luminance = 4;    // in standard deviations of the luminance
+	FReal	sigma_normal = 128;     // exponent of the normal cosine
+	FReal	sigma_depth = 1;        // in steps of the local depth gradient
+	int		threads = 0;            // 0: all hardware threads
+};
+
+// denoised mean color of every pixel from buffers holding samples_per_pixel samples each
+void denoise(const FDenoiseBuffers& buffers, int samples_per_pixel, const FDenoiseSettings& settings, std::vector<FColor3>& out);
@@ -0,0 +1,100 @@
+// discrete distributions
+//
+//
+
+#include "distribution.h"
+#include <algorithm>
+#include <limits>
+
+
+FAliasTable::FAliasTable(const std::vector<FReal>& weights)
+{
+	const size_t n = weights.size();
+	bins.resize(n);
+	probabilities.resize(n);
+	if (n == 0)
+		return;
+
+	double sum = 0.0;
+	for (FReal w : weights) sum += std::max<FReal>(w, 0);
+	for (size_t i = 0; i < n; i++)
+		probabilities[i] = sum > 0 ? FReal(std::max<FReal>(weights[i], 0) / sum) : FReal(1) / n;
+
+	// scaled to a mean of 1, bins below 1 are topped up by one above
+	std::vector<double> scaled(n);
+	std::vector<uint32_t> small, large;
+	for (size_t i = 0; i < n; i++)
+	{
+		scaled[i] = double(probabilities[i]) * n;
+		(scaled[i] < 1.0 ? small : large).push_back(uint32_t(i));
+	}
+
+	while (!small.empty() && !large.empty())
+	{
+		const uint32_t s = small.back(); small.pop_back();
+		const uint32_t l = large.back(); large.pop_back();
+		bins[s].threshold = FReal(scaled[s]);
+		bins[s].alias = l;
+
+		scaled[l] -= 1.0 - scaled[s];
+		(scaled[l] < 1.0 ? small : large).push_back(l);
+	}
+
+	// what is left is 1 up to rounding
+	for (uint32_t i : large) { bins[i].threshold = 1; bins[i].alias = i; }
+	for (uint32_t i : small) { bins[i].threshold = 1; bins[i].alias = i; }
+}
+
+FDistribution1D::FDistribution1D(const FReal* f, size_t n)
+	: func(f, f + n), cdf(n + 1)
+{
+	const FReal width = FReal(1) / n;
+	cdf[0] = 0;
+	for (size_t i = 0; i < n; i++)
+		cdf[i + 1] = cdf[i] + func[i] * width;
+	func_integral = cdf[n];
+
+	for (size_t i = 1; i <= n; i++)
+		cdf[i] = func_integral > 0 ? cdf[i] / func_integral : FReal(i) / n;
+	cdf[n] = 1;
+}
+
+FReal FDistribution1D::sample(FReal u, FReal& pdf, size_t& bin) const
+{
+	// last entry of cdf not above u
+	const size_t n = func.size();
+	bin = std::min(size_t(std::upper_bound(cdf.begin(), cdf.end(), u) - cdf.begin()), n) - 1;
+
+	const FReal span = cdf[bin + 1] - cdf[bin];
+	const FReal du = span > 0 ? (u - cdf[bin]) / span : FReal(0);
+	pdf = this->pdf(bin);
+	return std::min((bin + du) / n, FReal(1) - std::numeric_limits<FReal>::epsilon());
+}
+
+FDistribution2D::FDistribution2D(const FReal* f, size_t nu, size_t nv)
+{
+	rows.reserve(nv);
+	std::vector<FReal> row_integrals(nv);
+	for (size_t v = 0; v < nv; v++)
+	{
+		rows.emplace_back(f + v * nu, nu);
+		row_integrals[v] = rows[v].integral();
+	}
+	marginal = FDistribution1D(row_integrals.data(), nv);
+}
+
+void FDistribution2D::sample(FReal u0, FReal u1, FReal& u, FReal& v, FReal& pdf) const
+{
+	FReal pdf_v, pdf_u;
+	size_t row, column;
+	v = marginal.sample(u1, pdf_v, row);
+	u = rows[row].sample(u0, pdf_u, column);
+	pdf = pdf_v * pdf_u;
+}
+
+FReal FDistribution2D::pdf(FReal u, FReal v) const
+{
+	const size_t row = std::min(size_t(v * rows.size()), rows.size() - 1);
+	const size_t column = std::min(size_t(u * rows[row].size()), rows[row].size() - 1);
+	return marginal.pdf(row) * rows[row].pdf(column);
+}
@@ -0,0 +1,85 @@
+// discrete distributions
+//
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "basic.h"
+
+
+// alias table (walker, built with vose's method): draws index i with
+// probability weight[i] / sum in constant time from one random number
+class FAliasTable
+{
+public:
+	FAliasTable() {}
+	// negative weights count as 0, all zero falls back to uniform
+	explicit FAliasTable(const std::vector<FReal>& weights);
+
+	size_t size() const { return bins.size(); }
+
+	// u in [0, 1)
+	size_t sample(FReal u, FReal& pdf) const
+	{
+		const FReal x = u * bins.size();
+		const size_t i = std::min(static_cast<size_t>(x), bins.size() - 1);
+		const size_t k = (x - i) < bins[i].threshold ? i : bins[i].alias;
+		pdf = probabilities[k];
+		return k;
+	}
+
+	FReal pdf(size_t i) const { return probabilities[i]; }
+
+private:
+	struct FBin
+	{
+		FReal		threshold = 1;  // keep i below, take alias above
+		uint32_t	alias = 0;
+	};
+
+	std::vector<FBin> bins;
+	std::vector<FReal> probabilities;
+};
+
+// piecewise constant density on [0, 1) over equal bins, sampled by inverting
+// its cdf: unlike the alias table it keeps stratified numbers stratified
+class FDistribution1D
+{
+public:
+	FDistribution1D() {}
+	// f must not be negative, all zero falls back to uniform
+	FDistribution1D(const FReal* f, size_t n);
+
+	size_t size() const { return func.size(); }
+	// mean of f over [0, 1)
+	FReal integral() const { return func_integral; }
+
+	// x in [0, 1) from u in [0, 1), with its density and its bin
+	FReal sample(FReal u, FReal& pdf, size_t& bin) const;
+	// density of x in bin
+	FReal pdf(size_t bin) const { return func_integral > 0 ? func[bin] / func_integral : FReal(1); }
+
+private:
+	std::vector<FReal> func;
+	std::vector<FReal> cdf;  // size() + 1 entries, 0 to 1
+	FReal func_integral = 0;
+};
+
+// piecewise constant density on [0, 1)^2 over nu x nv cells: v from the
+// marginal of the rows, then u from the row
+class FDistribution2D
+{
+public:
+	FDistribution2D() {}
+	// row v starts at f + v * nu
+	FDistribution2D(const FReal* f, size_t nu, size_t nv);
+
+	void sample(FReal u0, FReal u1, FReal& u, FReal& v, FReal& pdf) const;
+	FReal pdf(FReal u, FReal v) const;
+
+private:
+	std::vector<FDistribution1D> rows;
+	FDistribution1D marginal;
+};
@@ -0,0 +1,99 @@
+// openexr writer
+//
+//
+
+#include "exr.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+
+// little endian byte writer
+struct FExrBytes
+{
+	std::vector<char> data;
+
+	void bytes(const void* p, size_t n) { data.insert(data.end(), (const char*)p, (const char*)p + n); }
+	void u8(uint8_t v) { data.push_back((char)v); }
+	void i32(int32_t v) { for (int k = 0; k < 4; k++) u8((uint8_t)(uint32_t(v) >> (8 * k))); }
+	void u64(uint64_t v) { for (int k = 0; k < 8; k++) u8((uint8_t)(v >> (8 * k))); }
+	void f32(float v) { uint32_t u; memcpy(&u, &v, 4); i32((int32_t)u); }
+	void str(const char* s) { bytes(s, strlen(s) + 1); }
+
+	// attribute header: name, type name, size of the value
+	void attribute(const char* name, const char* type, int size)
+	{
+		str(name);
+		str(type);
+		i32(size);
+	}
+};
+
+bool write_exr(const char* filename, int width, int height, const std::vector<FExrChannel>& channels)
+{
+	const int kFloat = 2;  // pixel type
+
+	std::vector<const FExrChannel*> sorted;
+	for (const FExrChannel& channel : channels) sorted.push_back(&channel);
+	std::sort(sorted.begin(), sorted.end(), [](const FExrChannel* a, const FExrChannel* b) { return a->name < b->name; });
+
+	FExrBytes out;
+	out.i32(20000630);  // magic
+	out.i32(2);         // version 2, single part scanline
+
+	int chlist_size = 1;
+	for (const FExrChannel* channel : sorted) chlist_size += int(channel->name.size()) + 1 + 16;
+	out.attribute("channels", "chlist", chlist_size);
+	for (const FExrChannel* channel : sorted)
+	{
+		out.str(channel->name.c_str());
+		out.i32(kFloat);
+		out.u8(0);  // pLinear
+		out.u8(0); out.u8(0); out.u8(0);
+		out.i32(1);  // x sampling
+		out.i32(1);  // y sampling
+	}
+	out.u8(0);
+
+	out.attribute("compression", "compression", 1);
+	out.u8(0);  // none
+	out.attribute("dataWindow", "box2i", 16);
+	out.i32(0); out.i32(0); out.i32(width - 1); out.i32(height - 1);
+	out.attribute("displayWindow", "box2i", 16);
+	out.i32(0); out.i32(0); out.i32(width - 1); out.i32(height - 1);
+	out.attribute("lineOrder", "lineOrder", 1);
+	out.u8(0);  // increasing y
+	out.attribute("pixelAspectRatio", "float", 4);
+	out.f32(1.0f);
+	out.attribute("screenWindowCenter", "v2f", 8);
+	out.f32(0.0f); out.f32(0.0f);
+	out.attribute("screenWindowWidth", "float", 4);
+	out.f32(1.0f);
+	out.u8(0);  // end of header
+
+	// uncompressed files hold one scanline per chunk: y, byte count, then
+	// the row of every channel in turn
+	const int line_bytes = width * 4 * int(sorted.size());
+	const uint64_t first_line = out.data.size() + uint64_t(height) * 8;
+	for (int y = 0; y < height; y++)
+	{
+		out.u64(first_line + uint64_t(y) * (8 + line_bytes));
+	}
+	for (int y = 0; y < height; y++)
+	{
+		out.i32(y);
+		out.i32(line_bytes);
+		for (const FExrChannel* channel : sorted)
+		{
+			for (int x = 0; x < width; x++) out.f32(channel->pixels[size_t(y) * width + x]);
+		}
+	}
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file)
+		return false;
+
+	file.write(out.data.data(), out.data.size());
+	return bool(file);
+}
@@ -0,0 +1,19 @@
+// openexr writer
+// single part scanline file, uncompressed 32 bit float channels. enough for
+// compositing tools to read the render and its aovs, nothing else of the
+// format is supported
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+
+struct FExrChannel
+{
+	std::string	name;  // "R", "albedo.G", ... channels are written in name order
+	std::vector<float> pixels;  // width * height, top row first
+};
+
+bool write_exr(const char* filename, int width, int height, const std::vector<FExrChannel>& channels);
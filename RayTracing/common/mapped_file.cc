@@ -0,0 +1,116 @@
+// read-only memory mapped file
+//
+//
+
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+#ifdef _WIN32
+
+FMappedFile::FMappedFile()
+	: _data(nullptr), _size(0), _file(INVALID_HANDLE_VALUE), _mapping(nullptr)
+{}
+
+bool FMappedFile::open(const char* filename)
+{
+	close();
+
+	_file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (_file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(_file, &file_size) || file_size.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+
+	_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!_mapping)
+	{
+		close();
+		return false;
+	}
+
+	_data = static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!_data)
+	{
+		close();
+		return false;
+	}
+
+	_size = static_cast<size_t>(file_size.QuadPart);
+	return true;
+}
+
+void FMappedFile::close()
+{
+	if (_data) UnmapViewOfFile(_data);
+	if (_mapping) CloseHandle(_mapping);
+	if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);
+
+	_data = nullptr;
+	_size = 0;
+	_mapping = nullptr;
+	_file = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+FMappedFile::FMappedFile()
+	: _data(nullptr), _size(0), _fd(-1)
+{}
+
+bool FMappedFile::open(const char* filename)
+{
+	close();
+
+	_fd = ::open(filename, O_RDONLY);
+	if (_fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(_fd, &st) != 0 || st.st_size == 0)
+	{
+		close();
+		return false;
+	}
+
+	void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, _fd, 0);
+	if (addr == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+
+	_data = static_cast<const char*>(addr);
+	_size = static_cast<size_t>(st.st_size);
+	return true;
+}
+
+void FMappedFile::close()
+{
+	if (_data) munmap(const_cast<char*>(_data), _size);
+	if (_fd >= 0) ::close(_fd);
+
+	_data = nullptr;
+	_size = 0;
+	_fd = -1;
+}
+
+#endif
+
+FMappedFile::~FMappedFile()
+{
+	close();
+}
@@ -0,0 +1,34 @@
+// read-only memory mapped file
+//
+//
+
+#pragma once
+
+#include <cstddef>
+
+
+class FMappedFile
+{
+public:
+	FMappedFile();
+	~FMappedFile();
+
+	FMappedFile(const FMappedFile&) = delete;
+	FMappedFile& operator=(const FMappedFile&) = delete;
+
+	bool open(const char* filename);
+	void close();
+
+	const char* data() const { return _data; }
+	size_t size() const { return _size; }
+
+private:
+	const char* _data;
+	size_t _size;
+#ifdef _WIN32
+	void* _file;
+	void* _mapping;
+#else
+	int _fd;
+#endif
+};
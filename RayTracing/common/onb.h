@@ -0,0 +1,43 @@
+// orthonormal basis
+//
+//
+
+#pragma once
+
+#include "basic.h"
+#include "vec3.h"
+#include "sampler.h"
+
+
+// right-handed basis with w along a given direction
+class FOnb
+{
+public:
+	explicit FOnb(const FVec3& n)
+	{
+		w = unit_vector(n);
+		const FVec3 a = fabs(w.x()) > 0.9 ? FVec3(0, 1, 0) : FVec3(1, 0, 0);
+		v = unit_vector(cross(w, a));
+		u = cross(w, v);
+	}
+
+	// basis coordinates to world
+	FVec3 local(FReal a, FReal b, FReal c) const { return a * u + b * v + c * w; }
+	FVec3 local(const FVec3& a) const { return local(a.x(), a.y(), a.z()); }
+	// world to basis coordinates
+	FVec3 project(const FVec3& a) const { return FVec3(dot(a, u), dot(a, v), dot(a, w)); }
+
+public:
+	FVec3 u, v, w;
+};
+
+// direction around +z with pdf cos(theta) / pi
+inline FVec3 random_cosine_direction()
+{
+	FReal r1, r2;
+	sample_2d(r1, r2);
+	const FReal phi = kTwoPi * r1;
+	const FReal r = sqrt(r2);
+
+	return FVec3(cos(phi) * r, sin(phi) * r, sqrt(1 - r2));
+}
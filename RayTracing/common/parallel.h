@@ -0,0 +1,32 @@
+// threads
+// fork-join helpers, no pool: every call starts its threads and joins them
+//
+
+#pragma once
+
+#include <thread>
+#include <vector>
+
+
+// hardware threads, at least 1
+inline int hardware_threads()
+{
+	unsigned int n = std::thread::hardware_concurrency();
+	return n > 0 ? static_cast<int>(n) : 1;
+}
+
+// run fn(0..count-1) on count threads
+template<typename Fn>
+inline void parallel_for(int count, const Fn& fn)
+{
+	std::vector<std::thread> workers;
+	for (int i = 1; i < count; i++)
+	{
+		workers.emplace_back(fn, i);
+	}
+	fn(0);
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+}
@@ -45,5 +45,5 @@ public:
 
 private:
 	FVec3	N;
-	double	d;
+	FReal	d;
 };
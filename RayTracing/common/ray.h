@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <cstdint>
+#include <cstring>
 #include "vec3.h"
 
 
@@ -16,21 +18,55 @@ public:
 		: orig(origin), dir(direction), tm(0)
 	{}
 
-	FRay(const FPoint3& origin, const FVec3& direction, double time)
+	FRay(const FPoint3& origin, const FVec3& direction, FReal time)
 		: orig(origin), dir(direction), tm(time)
 	{}
 
 	inline const FPoint3& Origin() const { return orig; }
 	inline const FVec3& Direction() const { return dir; }
-	inline double Time() const { return tm; }
+	inline FReal Time() const { return tm; }
 
 
-	inline FPoint3 At(double t) const {
+	inline FPoint3 At(FReal t) const {
 		return orig + t * dir;
 	}
 
 public:
 	FPoint3	orig;
 	FVec3	dir;
-	double tm;
-};
\ No newline at end of file
+	FReal tm;
+};
+
+// moves p, a point on a surface with geometric normal n, off the surface by a
+// few ulps of its coordinates so a ray spawned from it does not hit the same
+// surface again. near the origin, where ulps get tiny, a fixed epsilon is used.
+// "A Fast and Robust Method for Avoiding Self-Intersection", Ray Tracing Gems ch. 6
+inline FPoint3 offset_ray_origin(const FPoint3& p, const FVec3& n)
+{
+#ifdef RT_SCALAR_FLOAT
+	typedef int32_t FRealBits;
+	const FReal kOrigin = 1.0f / 32.0f;
+	const FReal kFloatScale = 1.0f / 65536.0f;
+	const FReal kIntScale = 256.0f;
+#else
+	typedef int64_t FRealBits;
+	const FReal kOrigin = 1.0 / 32.0;
+	const FReal kFloatScale = 1.0 / 17592186044416.0;  // 2^-44, as many ulps of 1.0 as 2^-16 in float
+	const FReal kIntScale = 256.0;
+#endif
+
+	FPoint3 result;
+	for (int i = 0; i < 3; i++)
+	{
+		const FRealBits offset = static_cast<FRealBits>(kIntScale * n[i]);
+
+		FRealBits bits;
+		memcpy(&bits, &p.e[i], sizeof(bits));
+		bits += (p[i] < 0) ? -offset : offset;
+
+		FReal p_offset;
+		memcpy(&p_offset, &bits, sizeof(bits));
+		result[i] = (fabs(p[i]) < kOrigin) ? p[i] + kFloatScale * n[i] : p_offset;
+	}
+	return result;
+}
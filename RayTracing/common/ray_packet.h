@@ -0,0 +1,104 @@
+// ray packet
+// a small group of coherent rays (neighbouring camera rays) traced together.
+// interval bounds over the packet let a BVH node reject a box for all rays
+// with one conservative test.
+//
+
+#pragma once
+
+#include <cstdint>
+#include "basic.h"
+#include "vec3.h"
+#include "ray.h"
+#include "aabb.h"
+
+
+// rays per packet
+const int kPacketSize = 8;
+
+struct FRayPacket
+{
+	FRay	rays[kPacketSize];
+	int		count = 0;
+
+	// structure-of-arrays copy for simd primitive tests, unused lanes repeat ray 0
+	alignas(32) FReal ox[kPacketSize], oy[kPacketSize], oz[kPacketSize];
+	alignas(32) FReal dx[kPacketSize], dy[kPacketSize], dz[kPacketSize];
+
+	// interval bounds of origins and inverse directions
+	FVec3	origin_min, origin_max;
+	FVec3	inv_dir_min, inv_dir_max;
+	// direction signs agree on every axis and no component is zero, the
+	// interval test is only valid then
+	bool	coherent = false;
+
+	void add(const FRay& ray) { rays[count++] = ray; }
+
+	// fills the simd arrays and bounds, call after the last add()
+	void finalize()
+	{
+		coherent = true;
+		for (int a = 0; a < 3; a++)
+		{
+			origin_min[a] = origin_max[a] = rays[0].Origin()[a];
+			inv_dir_min[a] = inv_dir_max[a] = 1.0 / rays[0].Direction()[a];
+		}
+
+		for (int i = 0; i < kPacketSize; i++)
+		{
+			const FRay& ray = rays[i < count ? i : 0];
+			ox[i] = ray.Origin().x(); oy[i] = ray.Origin().y(); oz[i] = ray.Origin().z();
+			dx[i] = ray.Direction().x(); dy[i] = ray.Direction().y(); dz[i] = ray.Direction().z();
+
+			for (int a = 0; a < 3; a++)
+			{
+				const FReal inv_dir = 1.0 / ray.Direction()[a];
+				origin_min[a] = fmin(origin_min[a], ray.Origin()[a]);
+				origin_max[a] = fmax(origin_max[a], ray.Origin()[a]);
+				inv_dir_min[a] = fmin(inv_dir_min[a], inv_dir);
+				inv_dir_max[a] = fmax(inv_dir_max[a], inv_dir);
+			}
+		}
+
+		for (int a = 0; a < 3; a++)
+		{
+			const bool same_sign = (inv_dir_min[a] > 0) == (inv_dir_max[a] > 0);
+			const bool finite = std::isfinite(inv_dir_min[a]) && std::isfinite(inv_dir_max[a]);
+			coherent = coherent && same_sign && finite;
+		}
+	}
+
+	// false only when no ray of the packet can hit box inside [t_min, t_max[i]]
+	bool hit_box(const FAABB& box, FReal t_min, const FReal* t_max) const
+	{
+		FReal packet_t_max = t_max[0];
+		for (int i = 1; i < count; i++) packet_t_max = fmax(packet_t_max, t_max[i]);
+
+		FReal enter = t_min;
+		FReal leave = packet_t_max;
+		for (int a = 0; a < 3; a++)
+		{
+			const bool positive = inv_dir_min[a] > 0;
+			const FReal near_plane = positive ? box.min()[a] : box.max()[a];
+			const FReal far_plane = positive ? box.max()[a] : box.min()[a];
+
+			// earliest entry and latest exit over the intervals
+			enter = fmax(enter, interval_mul_min(near_plane - origin_max[a], near_plane - origin_min[a], inv_dir_min[a], inv_dir_max[a]));
+			leave = fmin(leave, interval_mul_max(far_plane - origin_max[a], far_plane - origin_min[a], inv_dir_min[a], inv_dir_max[a]));
+		}
+
+		// single rays divide by the direction, allow for the rounding of the reciprocal
+		return enter <= leave + fabs(leave) * (4 * std::numeric_limits<FReal>::epsilon());
+	}
+
+private:
+	static FReal interval_mul_min(FReal a0, FReal a1, FReal b0, FReal b1)
+	{
+		return fmin(fmin(a0 * b0, a0 * b1), fmin(a1 * b0, a1 * b1));
+	}
+
+	static FReal interval_mul_max(FReal a0, FReal a1, FReal b0, FReal b1)
+	{
+		return fmax(fmax(a0 * b0, a0 * b1), fmax(a1 * b0, a1 * b1));
+	}
+};
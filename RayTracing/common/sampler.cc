@@ -0,0 +1,404 @@
+// samplers
+//
+//
+
+#include <cstring>
+#include "sampler.h"
+
+
+thread_local FSampler* active_sampler = nullptr;
+
+// bits to [0, 1), rounding to float may reach 1
+static inline FReal to_unit(uint32_t bits)
+{
+	const FReal r = static_cast<FReal>(bits * (1.0 / 4294967296.0));
+	return r < FReal(1) ? r : FReal(1) - std::numeric_limits<FReal>::epsilon() * FReal(0.5);
+}
+
+static inline uint32_t hash_u32(uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+static inline uint32_t hash_pixel(int x, int y)
+{
+	return hash_u32(static_cast<uint32_t>(x) ^ hash_u32(static_cast<uint32_t>(y) + 0x9e3779b9u));
+}
+
+static inline uint32_t hash_dimension(uint32_t seed, int dim)
+{
+	return hash_u32(seed ^ (static_cast<uint32_t>(dim) * 0x9e3779b9u + 0x85ebca6bu));
+}
+
+static inline uint32_t reverse_bits(uint32_t x)
+{
+	x = (x << 16) | (x >> 16);
+	x = ((x & 0x00ff00ffu) << 8) | ((x & 0xff00ff00u) >> 8);
+	x = ((x & 0x0f0f0f0fu) << 4) | ((x & 0xf0f0f0f0u) >> 4);
+	x = ((x & 0x33333333u) << 2) | ((x & 0xccccccccu) >> 2);
+	x = ((x & 0x55555555u) << 1) | ((x & 0xaaaaaaaau) >> 1);
+	return x;
+}
+
+// owen scrambling of the bits of x, most significant first: every bit is
+// flipped by a hash of the bits above it.
+// "Practical Hash-based Owen Scrambling", Burley 2020
+static inline uint32_t owen_scramble(uint32_t x, uint32_t seed)
+{
+	x = reverse_bits(x);
+	x += seed;
+	x ^= x * 0x6c50b47cu;
+	x ^= x * 0xb82f1e52u;
+	x ^= x * 0xc7afe638u;
+	x ^= x * 0x8d22f6e6u;
+	return reverse_bits(x);
+}
+
+// first two sobol dimensions, a (0,2)-sequence: every power of two prefix
+// is stratified in all elementary intervals
+static inline uint32_t sobol_0(uint32_t index)
+{
+	return reverse_bits(index);
+}
+
+// the generator matrix is linear over the bits of index: the xor of the
+// columns of every set bit, looked up a byte at a time
+struct FSobol1Table
+{
+	uint32_t bytes[4][256];
+
+	FSobol1Table()
+	{
+		uint32_t column[32];
+		column[0] = 1u << 31;
+		for (int k = 1; k < 32; k++)
+			column[k] = column[k - 1] ^ (column[k - 1] >> 1);
+
+		for (int b = 0; b < 4; b++)
+		{
+			for (int value = 0; value < 256; value++)
+			{
+				uint32_t r = 0;
+				for (int k = 0; k < 8; k++)
+					if (value & (1 << k)) r ^= column[b * 8 + k];
+				bytes[b][value] = r;
+			}
+		}
+	}
+};
+
+static inline uint32_t sobol_1(uint32_t index)
+{
+	static const FSobol1Table table;
+	return table.bytes[0][index & 0xff] ^ table.bytes[1][(index >> 8) & 0xff]
+		^ table.bytes[2][(index >> 16) & 0xff] ^ table.bytes[3][index >> 24];
+}
+
+
+// halton
+
+// element i of a random permutation of [0, l) picked by p, cycle walking hash.
+// "Correlated Multi-Jittered Sampling", Kensler 2013
+static inline uint32_t permutation_element(uint32_t i, uint32_t l, uint32_t p)
+{
+	uint32_t w = l - 1;
+	w |= w >> 1;
+	w |= w >> 2;
+	w |= w >> 4;
+	w |= w >> 8;
+	w |= w >> 16;
+	do
+	{
+		i ^= p;
+		i *= 0xe170893d;
+		i ^= p >> 16;
+		i ^= (i & w) >> 4;
+		i ^= p >> 8;
+		i *= 0x0929eb3f;
+		i ^= p >> 23;
+		i ^= (i & w) >> 1;
+		i *= 1 | p >> 27;
+		i *= 0x6935fa69;
+		i ^= (i & w) >> 11;
+		i *= 0x74dcb303;
+		i ^= (i & w) >> 2;
+		i *= 0x9e501cc3;
+		i ^= (i & w) >> 2;
+		i *= 0xc860a3df;
+		i &= w;
+		i ^= i >> 5;
+	} while (i >= l);
+	return (i + p) % l;
+}
+
+static const int kHaltonPrimes[] = {
+	2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53,
+	59, 61, 67, 71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131,
+	137, 139, 149, 151, 157, 163, 167, 173, 179, 181, 191, 193, 197, 199, 211, 223,
+	227, 229, 233, 239, 241, 251, 257, 263, 269, 271, 277, 281, 283, 293, 307, 311,
+};
+static const int kHaltonDimensions = sizeof(kHaltonPrimes) / sizeof(kHaltonPrimes[0]);
+
+void FHaltonSampler::start_pixel_sample(int x, int y, uint32_t index)
+{
+	FSampler::start_pixel_sample(x, y, index);
+	pixel_seed = hash_pixel(x, y);
+}
+
+FReal FHaltonSampler::radical_inverse(int dim) const
+{
+	// deeper dimensions of long paths are plain random numbers
+	if (dim >= kHaltonDimensions)
+		return random_double();
+
+	// owen scrambled digits: every digit goes through a permutation picked by
+	// a hash of the digits before it. with a plain rotation the few samples
+	// of two large bases would fall on a line
+	const uint32_t base = kHaltonPrimes[dim];
+	const double inv_base = 1.0 / base;
+	uint32_t h = hash_dimension(pixel_seed, dim);
+	uint32_t i = sample_index;
+	double inv = inv_base;
+	double r = 0.0;
+	do
+	{
+		const uint32_t digit = i % base;
+		i /= base;
+		r += permutation_element(digit, base, h) * inv;
+		h = hash_u32(h ^ (digit + 1));
+		inv *= inv_base;
+	} while (i);
+
+	// the permuted zero digits below are uniform in the last digit's interval
+	r += to_unit(h) * inv * base;
+	return to_unit(static_cast<uint32_t>(r * 4294967296.0));
+}
+
+FReal FHaltonSampler::get_1d()
+{
+	return radical_inverse(dimension++);
+}
+
+void FHaltonSampler::get_2d(FReal& u, FReal& v)
+{
+	u = radical_inverse(dimension);
+	v = radical_inverse(dimension + 1);
+	dimension += 2;
+}
+
+
+// sobol
+
+void FSobolSampler::start_pixel_sample(int x, int y, uint32_t index)
+{
+	FSampler::start_pixel_sample(x, y, index);
+	pixel_seed = hash_pixel(x, y);
+}
+
+FReal FSobolSampler::get_1d()
+{
+	const uint32_t seed = hash_dimension(pixel_seed, dimension++);
+	const uint32_t index = owen_scramble(sample_index, seed);
+	return to_unit(owen_scramble(sobol_0(index), hash_u32(seed ^ 0xa511e9b3u)));
+}
+
+void FSobolSampler::get_2d(FReal& u, FReal& v)
+{
+	// every pair gets the (0,2) points in its own order, the padding keeps
+	// the pairs of a path uncorrelated
+	const uint32_t seed = hash_dimension(pixel_seed, dimension);
+	dimension += 2;
+
+	const uint32_t index = owen_scramble(sample_index, seed);
+	u = to_unit(owen_scramble(sobol_0(index), hash_u32(seed ^ 0xa511e9b3u)));
+	v = to_unit(owen_scramble(sobol_1(index), hash_u32(seed ^ 0x63d83595u)));
+}
+
+
+// blue noise
+
+const int kBlueNoiseSize = 64;  // power of two
+
+// blue noise dither mask of kBlueNoiseSize^2 ranks in [0, 1), void and cluster.
+// "The void-and-cluster method for dither array generation", Ulichney 1993
+static std::vector<FReal> void_and_cluster()
+{
+	const int size = kBlueNoiseSize;
+	const int n = size * size;
+	const double sigma = 1.5;
+
+	// toroidal gaussian energy of a point at the origin
+	std::vector<double> kernel(n);
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			const int dx = std::min(x, size - x);
+			const int dy = std::min(y, size - y);
+			kernel[y * size + x] = exp(-(dx * dx + dy * dy) / (2 * sigma * sigma));
+		}
+	}
+
+	std::vector<char> pattern(n, 0);
+	std::vector<double> energy(n, 0.0);
+	auto toggle = [&](int p, bool on) {
+		pattern[p] = on;
+		const int px = p % size, py = p / size;
+		const double sign = on ? 1.0 : -1.0;
+		for (int y = 0; y < size; y++)
+			for (int x = 0; x < size; x++)
+				energy[y * size + x] += sign * kernel[((y - py) & (size - 1)) * size + ((x - px) & (size - 1))];
+	};
+	// densest point of the pattern, emptiest spot outside it
+	auto tightest_cluster = [&]() {
+		int best = -1;
+		for (int p = 0; p < n; p++)
+			if (pattern[p] && (best < 0 || energy[p] > energy[best])) best = p;
+		return best;
+	};
+	auto largest_void = [&]() {
+		int best = -1;
+		for (int p = 0; p < n; p++)
+			if (!pattern[p] && (best < 0 || energy[p] < energy[best])) best = p;
+		return best;
+	};
+
+	// initial pattern of n / 10 points, own generator so rand() is left alone
+	uint32_t state = 1;
+	int ones = 0;
+	while (ones < n / 10)
+	{
+		state = hash_u32(state + 0x9e3779b9u);
+		const int p = state % n;
+		if (!pattern[p])
+		{
+			toggle(p, true);
+			ones++;
+		}
+	}
+
+	// move points from clusters to voids until it is even
+	for (int step = 0; step < n; step++)
+	{
+		const int cluster = tightest_cluster();
+		toggle(cluster, false);
+		const int hole = largest_void();
+		toggle(hole, true);
+		if (hole == cluster)
+			break;
+	}
+
+	std::vector<int> rank(n);
+	const std::vector<char> initial_pattern = pattern;
+	const std::vector<double> initial_energy = energy;
+
+	// ranks below the initial pattern: remove its points densest first
+	for (int r = ones - 1; r >= 0; r--)
+	{
+		const int cluster = tightest_cluster();
+		toggle(cluster, false);
+		rank[cluster] = r;
+	}
+
+	// ranks above: fill the largest voids. past half the mask this is the
+	// tightest cluster of the empty pixels, the energies of both sum to a constant
+	pattern = initial_pattern;
+	energy = initial_energy;
+	for (int r = ones; r < n; r++)
+	{
+		const int hole = largest_void();
+		toggle(hole, true);
+		rank[hole] = r;
+	}
+
+	std::vector<FReal> mask(n);
+	for (int p = 0; p < n; p++)
+		mask[p] = (rank[p] + 0.5) / n;
+	return mask;
+}
+
+static const std::vector<FReal>& blue_noise_mask()
+{
+	static const std::vector<FReal> mask = void_and_cluster();
+	return mask;
+}
+
+FBlueNoiseSampler::FBlueNoiseSampler()
+	: mask(blue_noise_mask())
+{}
+
+FReal FBlueNoiseSampler::rotation(int dim) const
+{
+	const uint32_t h = hash_dimension(0x5bd1e995u, dim);
+	const int x = (pixel_x + static_cast<int>(h & 0xff)) & (kBlueNoiseSize - 1);
+	const int y = (pixel_y + static_cast<int>((h >> 8) & 0xff)) & (kBlueNoiseSize - 1);
+	return mask[y * kBlueNoiseSize + x];
+}
+
+// every pixel walks the same scrambled sequence, shifted by the mask: neighbours
+// get well spread offsets and their errors differ, which reads as blue noise.
+// the index is shuffled per dimension but not per pixel
+static inline FReal rotate(uint32_t bits, FReal shift)
+{
+	const FReal r = to_unit(bits) + shift;
+	return r < 1 ? r : r - 1;
+}
+
+FReal FBlueNoiseSampler::get_1d()
+{
+	const uint32_t seed = hash_dimension(0x27d4eb2fu, dimension);
+	const uint32_t index = owen_scramble(sample_index, seed);
+	const FReal r = rotate(owen_scramble(sobol_0(index), hash_u32(seed ^ 0xa511e9b3u)), rotation(dimension));
+	dimension++;
+	return r;
+}
+
+void FBlueNoiseSampler::get_2d(FReal& u, FReal& v)
+{
+	const uint32_t seed = hash_dimension(0x27d4eb2fu, dimension);
+	const uint32_t index = owen_scramble(sample_index, seed);
+	u = rotate(owen_scramble(sobol_0(index), hash_u32(seed ^ 0xa511e9b3u)), rotation(dimension));
+	v = rotate(owen_scramble(sobol_1(index), hash_u32(seed ^ 0x63d83595u)), rotation(dimension + 1));
+	dimension += 2;
+}
+
+
+shared_ptr<FSampler> make_sampler(ESamplerType type)
+{
+	switch (type)
+	{
+	case ESamplerType::Halton:		return make_shared<FHaltonSampler>();
+	case ESamplerType::Sobol:		return make_shared<FSobolSampler>();
+	case ESamplerType::BlueNoise:	return make_shared<FBlueNoiseSampler>();
+	default:						return make_shared<FRandomSampler>();
+	}
+}
+
+const char* sampler_name(ESamplerType type)
+{
+	switch (type)
+	{
+	case ESamplerType::Halton:		return "halton";
+	case ESamplerType::Sobol:		return "sobol";
+	case ESamplerType::BlueNoise:	return "bluenoise";
+	default:						return "random";
+	}
+}
+
+bool find_sampler(const char* name, ESamplerType& type)
+{
+	for (int t = 0; t < (int)ESamplerType::Count; t++)
+	{
+		if (strcmp(name, sampler_name((ESamplerType)t)) == 0)
+		{
+			type = (ESamplerType)t;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,213 @@
+// samplers
+// the random numbers of a path come from a sampler instead of independent
+// random_double() calls. a sampler hands out the dimensions of one pixel
+// sample in order: the camera takes the first kCameraDimensions (pixel, time,
+// lens), every bounce then starts a block of kBounceDimensions (medium, bsdf,
+// light, roulette), so the same decision of different samples of a pixel
+// draws from the same dimension of a low-discrepancy sequence. media are met
+// during traversal, as many as the ray reaches, so the medium dimension is
+// drawn up front and only the first medium of a bounce gets it.
+//
+// sample_1d() / sample_2d() draw from the active sampler of the thread, or
+// from random_double() when none is set (wavefront and packet renderers).
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "basic.h"
+#include "vec3.h"
+
+
+const int kCameraDimensions = 5;
+const int kBounceDimensions = 8;
+
+enum class ESamplerType
+{
+	Random,
+	Halton,     // radical inverse in prime bases, digits scrambled per pixel
+	Sobol,      // owen scrambled sobol (0,2) pairs, shuffled per pixel and dimension
+	BlueNoise,  // one owen scrambled sobol sequence, rotated per pixel by a blue noise mask
+	Count,
+};
+
+class FSampler
+{
+public:
+	virtual ~FSampler() {}
+
+	// starts sample index of pixel (x, y), dimensions restart at 0
+	virtual void start_pixel_sample(int x, int y, uint32_t index)
+	{
+		pixel_x = x;
+		pixel_y = y;
+		sample_index = index;
+		dimension = 0;
+		medium_pending = false;
+	}
+
+	// skips to dimension dim, dimensions already drawn are never handed out twice
+	void start_dimension(int dim) { dimension = std::max(dimension, dim); }
+
+	// skips to the block of bounce and draws its medium dimension
+	void start_bounce(int bounce)
+	{
+		start_dimension(kCameraDimensions + bounce * kBounceDimensions);
+		medium_u = get_1d();
+		medium_pending = true;
+	}
+
+	// the medium dimension of the bounce on the first call, random_double() after it
+	FReal medium_1d()
+	{
+		if (!medium_pending)
+			return random_double();
+		medium_pending = false;
+		return medium_u;
+	}
+
+	virtual FReal get_1d() = 0;
+	virtual void get_2d(FReal& u, FReal& v) = 0;
+
+	virtual const char* name() const = 0;
+
+protected:
+	int pixel_x = 0;
+	int pixel_y = 0;
+	uint32_t sample_index = 0;
+	int dimension = 0;
+	FReal medium_u = 0;
+	bool medium_pending = false;
+};
+
+class FRandomSampler : public FSampler
+{
+public:
+	virtual FReal get_1d() { dimension++; return random_double(); }
+	virtual void get_2d(FReal& u, FReal& v) { dimension += 2; u = random_double(); v = random_double(); }
+	virtual const char* name() const { return "random"; }
+};
+
+class FHaltonSampler : public FSampler
+{
+public:
+	virtual void start_pixel_sample(int x, int y, uint32_t index);
+	virtual FReal get_1d();
+	virtual void get_2d(FReal& u, FReal& v);
+	virtual const char* name() const { return "halton"; }
+
+private:
+	FReal radical_inverse(int dim) const;
+
+	uint32_t pixel_seed = 0;
+};
+
+class FSobolSampler : public FSampler
+{
+public:
+	virtual void start_pixel_sample(int x, int y, uint32_t index);
+	virtual FReal get_1d();
+	virtual void get_2d(FReal& u, FReal& v);
+	virtual const char* name() const { return "sobol"; }
+
+private:
+	uint32_t pixel_seed = 0;
+};
+
+class FBlueNoiseSampler : public FSampler
+{
+public:
+	FBlueNoiseSampler();
+
+	virtual FReal get_1d();
+	virtual void get_2d(FReal& u, FReal& v);
+	virtual const char* name() const { return "bluenoise"; }
+
+private:
+	// toroidal shift of the pixel in [0, 1), a different mask offset per dimension
+	FReal rotation(int dim) const;
+
+	const std::vector<FReal>& mask;
+};
+
+shared_ptr<FSampler> make_sampler(ESamplerType type);
+const char* sampler_name(ESamplerType type);
+// type named name (random, halton, sobol, bluenoise), false when unknown
+bool find_sampler(const char* name, ESamplerType& type);
+
+// the sampler sample_1d() and sample_2d() draw from on this thread, nullptr for random_double()
+extern thread_local FSampler* active_sampler;
+
+inline FReal sample_1d()
+{
+	return active_sampler ? active_sampler->get_1d() : random_double();
+}
+
+inline void sample_2d(FReal& u, FReal& v)
+{
+	if (active_sampler)
+	{
+		active_sampler->get_2d(u, v);
+		return;
+	}
+	u = random_double();
+	v = random_double();
+}
+
+// first dimension of bounce, called by the integrators before each bounce ray is traced
+inline void start_bounce_dimensions(int bounce)
+{
+	if (active_sampler)
+		active_sampler->start_bounce(bounce);
+}
+
+// free-flight distance sample of a medium the bounce ray reaches
+inline FReal sample_medium_1d()
+{
+	return active_sampler ? active_sampler->medium_1d() : random_double();
+}
+
+// warps of sample_2d(), no rejection so every call takes a fixed number of dimensions
+
+// point in the unit disk (z = 0), concentric mapping
+inline FVec3 sample_unit_disk()
+{
+	FReal u, v;
+	sample_2d(u, v);
+	const FReal a = 2 * u - 1;
+	const FReal b = 2 * v - 1;
+	if (a == 0 && b == 0)
+		return FVec3(0, 0, 0);
+
+	FReal r, phi;
+	if (fabs(a) > fabs(b))
+	{
+		r = a;
+		phi = (kPi / 4) * (b / a);
+	}
+	else
+	{
+		r = b;
+		phi = kHalfPi - (kPi / 4) * (a / b);
+	}
+	return FVec3(r * cos(phi), r * sin(phi), 0);
+}
+
+// uniform direction
+inline FVec3 sample_unit_vector()
+{
+	FReal u, v;
+	sample_2d(u, v);
+	const FReal z = 1 - 2 * u;
+	const FReal r = sqrt(std::max<FReal>(0, 1 - z * z));
+	const FReal phi = kTwoPi * v;
+	return FVec3(r * cos(phi), r * sin(phi), z);
+}
+
+// uniform point in the unit ball
+inline FVec3 sample_in_unit_sphere()
+{
+	const FVec3 dir = sample_unit_vector();
+	return cbrt(sample_1d()) * dir;
+}
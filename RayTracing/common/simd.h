@@ -0,0 +1,137 @@
+// simd lanes
+// a thin wrapper over AVX intrinsics with a scalar fallback, so the batch
+// primitives are written once and run on every target. a register holds 4
+// doubles, or 8 floats with RT_SCALAR_FLOAT.
+//
+
+#pragma once
+
+#include "basic.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define RT_SIMD_AVX	1
+#else
+#define RT_SIMD_AVX	0
+#endif
+
+
+// lanes per simd register
+#ifdef RT_SCALAR_FLOAT
+const int kSimdWidth = 8;
+#else
+const int kSimdWidth = 4;
+#endif
+
+// packed reals
+struct FSimdReal
+{
+#if RT_SIMD_AVX && defined(RT_SCALAR_FLOAT)
+	__m256 v;
+#elif RT_SIMD_AVX
+	__m256d v;
+#else
+	FReal e[kSimdWidth];
+#endif
+};
+
+// packed lane mask
+struct FSimdMask
+{
+#if RT_SIMD_AVX && defined(RT_SCALAR_FLOAT)
+	__m256 v;
+#elif RT_SIMD_AVX
+	__m256d v;
+#else
+	bool e[kSimdWidth];
+#endif
+};
+
+
+#if RT_SIMD_AVX && defined(RT_SCALAR_FLOAT)
+
+inline FSimdReal simd_load(const float* p) { return { _mm256_loadu_ps(p) }; }
+inline FSimdReal simd_set1(float x) { return { _mm256_set1_ps(x) }; }
+
+inline FSimdReal operator +(const FSimdReal& a, const FSimdReal& b) { return { _mm256_add_ps(a.v, b.v) }; }
+inline FSimdReal operator -(const FSimdReal& a, const FSimdReal& b) { return { _mm256_sub_ps(a.v, b.v) }; }
+inline FSimdReal operator *(const FSimdReal& a, const FSimdReal& b) { return { _mm256_mul_ps(a.v, b.v) }; }
+inline FSimdReal operator /(const FSimdReal& a, const FSimdReal& b) { return { _mm256_div_ps(a.v, b.v) }; }
+inline FSimdReal operator -(const FSimdReal& a) { return { _mm256_sub_ps(_mm256_setzero_ps(), a.v) }; }
+inline FSimdReal simd_sqrt(const FSimdReal& a) { return { _mm256_sqrt_ps(a.v) }; }
+
+inline FSimdMask simd_gt(const FSimdReal& a, const FSimdReal& b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+inline FSimdMask simd_lt(const FSimdReal& a, const FSimdReal& b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+inline FSimdMask operator &(const FSimdMask& a, const FSimdMask& b) { return { _mm256_and_ps(a.v, b.v) }; }
+inline FSimdMask operator |(const FSimdMask& a, const FSimdMask& b) { return { _mm256_or_ps(a.v, b.v) }; }
+// a & ~b
+inline FSimdMask simd_andnot(const FSimdMask& a, const FSimdMask& b) { return { _mm256_andnot_ps(b.v, a.v) }; }
+
+// mask ? a : b
+inline FSimdReal simd_select(const FSimdMask& mask, const FSimdReal& a, const FSimdReal& b) { return { _mm256_blendv_ps(b.v, a.v, mask.v) }; }
+// bit i is set when lane i is set
+inline int simd_movemask(const FSimdMask& mask) { return _mm256_movemask_ps(mask.v); }
+
+inline void simd_store(float* p, const FSimdReal& a) { _mm256_storeu_ps(p, a.v); }
+
+inline void simd_end() { _mm256_zeroupper(); }
+
+#elif RT_SIMD_AVX
+
+inline FSimdReal simd_load(const double* p) { return { _mm256_loadu_pd(p) }; }
+inline FSimdReal simd_set1(double x) { return { _mm256_set1_pd(x) }; }
+
+inline FSimdReal operator +(const FSimdReal& a, const FSimdReal& b) { return { _mm256_add_pd(a.v, b.v) }; }
+inline FSimdReal operator -(const FSimdReal& a, const FSimdReal& b) { return { _mm256_sub_pd(a.v, b.v) }; }
+inline FSimdReal operator *(const FSimdReal& a, const FSimdReal& b) { return { _mm256_mul_pd(a.v, b.v) }; }
+inline FSimdReal operator /(const FSimdReal& a, const FSimdReal& b) { return { _mm256_div_pd(a.v, b.v) }; }
+inline FSimdReal operator -(const FSimdReal& a) { return { _mm256_sub_pd(_mm256_setzero_pd(), a.v) }; }
+inline FSimdReal simd_sqrt(const FSimdReal& a) { return { _mm256_sqrt_pd(a.v) }; }
+
+inline FSimdMask simd_gt(const FSimdReal& a, const FSimdReal& b) { return { _mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ) }; }
+inline FSimdMask simd_lt(const FSimdReal& a, const FSimdReal& b) { return { _mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ) }; }
+inline FSimdMask operator &(const FSimdMask& a, const FSimdMask& b) { return { _mm256_and_pd(a.v, b.v) }; }
+inline FSimdMask operator |(const FSimdMask& a, const FSimdMask& b) { return { _mm256_or_pd(a.v, b.v) }; }
+// a & ~b
+inline FSimdMask simd_andnot(const FSimdMask& a, const FSimdMask& b) { return { _mm256_andnot_pd(b.v, a.v) }; }
+
+// mask ? a : b
+inline FSimdReal simd_select(const FSimdMask& mask, const FSimdReal& a, const FSimdReal& b) { return { _mm256_blendv_pd(b.v, a.v, mask.v) }; }
+// bit i is set when lane i is set
+inline int simd_movemask(const FSimdMask& mask) { return _mm256_movemask_pd(mask.v); }
+
+inline void simd_store(double* p, const FSimdReal& a) { _mm256_storeu_pd(p, a.v); }
+
+// call after a simd loop, before scalar library code runs again. a dirty upper
+// ymm state makes every following SSE instruction pay a transition penalty.
+inline void simd_end() { _mm256_zeroupper(); }
+
+#else
+
+inline FSimdReal simd_load(const FReal* p) { FSimdReal r; for (int i = 0; i < kSimdWidth; ++i) r.e[i] = p[i]; return r; }
+inline FSimdReal simd_set1(FReal x) { FSimdReal r; for (int i = 0; i < kSimdWidth; ++i) r.e[i] = x; return r; }
+
+inline FSimdReal operator +(const FSimdReal& a, const FSimdReal& b) { FSimdReal r; for (int i = 0; i < kSimdWidth; ++i) r.e[i] = a.e[i] + b.e[i]; return r; }
+inline FSimdReal operator -(const FSimdReal& a, const FSimdReal& b) { FSimdReal r; for (int i = 0; i < kSimdWidth; ++i) r.e[i] = a.e[i] - b.e[i]; return r; }
+inline FSimdReal operator *(const FSimdReal& a, const FSimdReal& b) { FSimdReal r; for (int i = 0; i < kSimdWidth; ++i) r.e[i] = a.e[i] * b.e[i]; return r; }
+inline FSimdReal operator /(const FSimdReal& a, const FSimdReal& b) { FSimdReal r; for (int i = 0; i < kSimdWidth; ++i) r.e[i] = a.e[i] / b.e[i]; return r; }
+inline FSimdReal operator -(const FSimdReal& a) { FSimdReal r; for (int i = 0; i < kSimdWidth; ++i) r.e[i] = -a.e[i]; return r; }
+inline FSimdReal simd_sqrt(const FSimdReal& a) { FSimdReal r; for (int i = 0; i < kSimdWidth; ++i) r.e[i] = sqrt(a.e[i]); return r; }
+
+inline FSimdMask simd_gt(const FSimdReal& a, const FSimdReal& b) { FSimdMask r; for (int i = 0; i < kSimdWidth; ++i) r.e[i] = a.e[i] > b.e[i]; return r; }
+inline FSimdMask simd_lt(const FSimdReal& a, const FSimdReal& b) { FSimdMask r; for (int i = 0; i < kSimdWidth; ++i) r.e[i] = a.e[i] < b.e[i]; return r; }
+inline FSimdMask operator &(const FSimdMask& a, const FSimdMask& b) { FSimdMask r; for (int i = 0; i < kSimdWidth; ++i) r.e[i] = a.e[i] && b.e[i]; return r; }
+inline FSimdMask operator |(const FSimdMask& a, const FSimdMask& b) { FSimdMask r; for (int i = 0; i < kSimdWidth; ++i) r.e[i] = a.e[i] || b.e[i]; return r; }
+// a & ~b
+inline FSimdMask simd_andnot(const FSimdMask& a, const FSimdMask& b) { FSimdMask r; for (int i = 0; i < kSimdWidth; ++i) r.e[i] = a.e[i] && !b.e[i]; return r; }
+
+// mask ? a : b
+inline FSimdReal simd_select(const FSimdMask& mask, const FSimdReal& a, const FSimdReal& b) { FSimdReal r; for (int i = 0; i < kSimdWidth; ++i) r.e[i] = mask.e[i] ? a.e[i] : b.e[i]; return r; }
+// bit i is set when lane i is set
+inline int simd_movemask(const FSimdMask& mask) { int bits = 0; for (int i = 0; i < kSimdWidth; ++i) bits |= (mask.e[i] ? 1 : 0) << i; return bits; }
+
+inline void simd_store(FReal* p, const FSimdReal& a) { for (int i = 0; i < kSimdWidth; ++i) p[i] = a.e[i]; }
+
+inline void simd_end() {}
+
+#endif
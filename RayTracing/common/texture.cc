@@ -6,7 +6,7 @@
 #include "rtw_stb_image.h"
 
 // checker
-FColor3 FCheckerTexture::value(double u, double v, const FPoint3& p) const
+FColor3 FCheckerTexture::value(FReal u, FReal v, const FPoint3& p) const
 {
 	auto sines = sin(10 * p.x()) * sin(10 * p.y()) * sin(10 * p.z());
 	if (sines < 0.0) {
@@ -18,7 +18,7 @@ FColor3 FCheckerTexture::value(double u, double v, const FPoint3& p) const
 }
 
 // noise texture
-FColor3 FNoiseTexture::value(double u, double v, const FPoint3& p) const
+FColor3 FNoiseTexture::value(FReal u, FReal v, const FPoint3& p) const
 {
 	switch (effectType)
 	{
@@ -30,6 +30,8 @@ FColor3 FNoiseTexture::value(double u, double v, const FPoint3& p) const
 		return wood_effect(p);
 	case NOISE_EFFECT_WORLEY:
 		return worley_effect(p);
+	case NOISE_EFFECT_SMOKE:
+		return smoke_effect(p);
 	default:
 		break;
 	}
@@ -42,8 +44,8 @@ FColor3 FNoiseTexture::sun_surface_effect(const FPoint3& p) const
 	static const FColor3 color1(0.8, 0.7, 0.0);
 	static const FColor3 color2(0.6, 0.1, 0.0);
 
-	double noiseval = (simplex.fractal(5, (float)p.x(), (float)p.y(), (float)p.z()) + 1.0) * 0.5;
-	double intensity = abs(noiseval - 0.25) +
+	FReal noiseval = (simplex.fractal(5, (float)p.x(), (float)p.y(), (float)p.z()) + 1.0) * 0.5;
+	FReal intensity = abs(noiseval - 0.25) +
 		abs(noiseval - 0.125) +
 		abs(noiseval - 0.0625) +
 		abs(noiseval - 0.03125);
@@ -71,7 +73,7 @@ FColor3 FNoiseTexture::marble_effect(const FPoint3& p) const
 		amplitude *= persistence;
 	}
 
-	double sineval = (sin(((float)p.x() + noiseval * 100.f) * 2 * kPi / 200.f) + 1) * 0.5f;
+	FReal sineval = (sin(((float)p.x() + noiseval * 100.f) * 2 * kPi / 200.f) + 1) * 0.5f;
 	FColor3 color = lerp(color1, color2, sineval);
 	return color;
 }
@@ -89,13 +91,13 @@ FColor3 FNoiseTexture::wood_effect(const FPoint3& p) const
 	static const float GrainScale = 27.0;
 
 	FPoint3 sp = NoiseScale * p;
-	double noiseval = (simplex.fractal(5, (float)sp.x(), (float)sp.y(), (float)sp.z()) + 1.0) * 0.5;
+	FReal noiseval = (simplex.fractal(5, (float)sp.x(), (float)sp.y(), (float)sp.z()) + 1.0) * 0.5;
 	FVec3 noiseVec = Noisiness * FVec3(noiseval, noiseval, noiseval);
 	FVec3 location = p + noiseVec;
-	double dist = sqrt(location.x() * location.x() + location.z() * location.z());
+	FReal dist = sqrt(location.x() * location.x() + location.z() * location.z());
 	dist *= RingFreq;
 
-	double r = fract(dist + noiseVec[0] + noiseVec[1] + noiseVec[2]) * 2.0;
+	FReal r = fract(dist + noiseVec[0] + noiseVec[1] + noiseVec[2]) * 2.0;
 	if (r > 1.0) { r = 2.0 - r; }
 
 	FVec3 color = lerp(LightWood, DarkWood, r);
@@ -113,12 +115,23 @@ FColor3 FNoiseTexture::worley_effect(const FPoint3& p) const
 {
 	static const FColor3 color(1.0, 1.0, 1.0);
 
-	double val = worley.noise((float)p.x(), (float)p.y(), (float)p.z());
+	FReal val = worley.noise((float)p.x(), (float)p.y(), (float)p.z());
 	val = clamp(val, 0.0, 1.0);
 
 	return val * color;
 }
 
+FColor3 FNoiseTexture::smoke_effect(const FPoint3& p) const
+{
+	const FReal frequency = 3.0;
+	FReal noiseval = simplex.fractal(4, (float)(p.x() * frequency), (float)(p.y() * frequency), (float)(p.z() * frequency));
+
+	// empty below a threshold, dense cores
+	FReal val = clamp((noiseval - 0.15) * 2.5, 0.0, 1.0);
+	val = val * val;
+	return FColor3(val, val, val);
+}
+
 // image texture
 FImageTexture::FImageTexture(const char* filename)
 {
@@ -134,7 +147,7 @@ FImageTexture::FImageTexture(const char* filename)
 	bytes_per_scanline = bytes_per_pixel * width;
 }
 
-FColor3 FImageTexture::value(double u, double v, const FPoint3& p) const
+FColor3 FImageTexture::value(FReal u, FReal v, const FPoint3& p) const
 {
 	// if we have no texture data, then return solid cyan as a debugging aid
 	if (data == nullptr) {
@@ -16,7 +16,7 @@
 class FTexture
 {
 public:
-	virtual FColor3 value(double u, double v, const FPoint3 &p) const = 0;
+	virtual FColor3 value(FReal u, FReal v, const FPoint3 &p) const = 0;
 };
 
 
@@ -26,11 +26,11 @@ class FSolidColor : public FTexture
 public:
 	FSolidColor() {}
 	FSolidColor(const FColor3& c) : color(c) {}
-	FSolidColor(double r, double g, double b)
+	FSolidColor(FReal r, FReal g, FReal b)
 		: color(r,g,b)
 	{}
 
-	virtual FColor3 value(double u, double v, const FPoint3& p) const override
+	virtual FColor3 value(FReal u, FReal v, const FPoint3& p) const override
 	{
 		return color;
 	}
@@ -46,7 +46,7 @@ public:
 	FCheckerTexture() {}
 	FCheckerTexture(const shared_ptr<FTexture>& t0, const shared_ptr<FTexture>& t1) : odd(t0), even(t1) {}
 
-	virtual FColor3 value(double u, double v, const FPoint3& p) const override;
+	virtual FColor3 value(FReal u, FReal v, const FPoint3& p) const override;
 
 public:
 	shared_ptr<FTexture> odd;
@@ -58,6 +58,7 @@ public:
 #define NOISE_EFFECT_MARBLE		 1
 #define NOISE_EFFECT_WOOD		 2
 #define NOISE_EFFECT_WORLEY		 3
+#define NOISE_EFFECT_SMOKE		 4   // billows in [0, 1], a few across the unit cube, for media
 
 class FNoiseTexture : public FTexture
 {
@@ -65,13 +66,14 @@ public:
 	FNoiseTexture() : effectType(NOISE_EFFECT_WOOD) {}
 	FNoiseTexture(int effect) : effectType(effect) {}
 
-	virtual FColor3 value(double u, double v, const FPoint3& p) const override;
+	virtual FColor3 value(FReal u, FReal v, const FPoint3& p) const override;
 
 protected:
 	FColor3 sun_surface_effect(const FPoint3& p) const;
 	FColor3 marble_effect(const FPoint3& p) const;
 	FColor3 wood_effect(const FPoint3& p) const;
 	FColor3 worley_effect(const FPoint3 &p) const;
+	FColor3 smoke_effect(const FPoint3& p) const;
 
 protected:
 	int			 effectType;
@@ -96,7 +98,7 @@ public:
 		delete data;
 	}
 
-	virtual FColor3 value(double u, double v, const FPoint3& p) const override;
+	virtual FColor3 value(FReal u, FReal v, const FPoint3& p) const override;
 
 private:
 	unsigned char* data;
@@ -1,5 +1,7 @@
 // vector 3d
-//
+// stored in one simd register (AVX for double, SSE for float) with the 4th lane
+// unused, operators map onto packed instructions. define RT_VEC3_SCALAR to
+// build the plain scalar version.
 //
 
 #pragma once
@@ -7,20 +9,144 @@
 #include <iostream>
 #include "basic.h"
 
+#if !defined(RT_VEC3_SCALAR) && !defined(RT_SCALAR_FLOAT) && defined(__AVX__)
+#include <immintrin.h>
+#define RT_VEC3_SIMD	1
+typedef __m256d FVec3Reg;
+#elif !defined(RT_VEC3_SCALAR) && defined(RT_SCALAR_FLOAT) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#include <xmmintrin.h>
+#define RT_VEC3_SIMD	1
+typedef __m128 FVec3Reg;
+#else
+#define RT_VEC3_SIMD	0
+#endif
+
+#if RT_VEC3_SIMD && !defined(RT_SCALAR_FLOAT)
+
+inline FVec3Reg vec3_set(FReal x, FReal y, FReal z) { return _mm256_set_pd(0.0, z, y, x); }
+inline FVec3Reg vec3_set1(FReal t) { return _mm256_set1_pd(t); }
+inline FVec3Reg vec3_add(FVec3Reg a, FVec3Reg b) { return _mm256_add_pd(a, b); }
+inline FVec3Reg vec3_sub(FVec3Reg a, FVec3Reg b) { return _mm256_sub_pd(a, b); }
+inline FVec3Reg vec3_mul(FVec3Reg a, FVec3Reg b) { return _mm256_mul_pd(a, b); }
+inline FVec3Reg vec3_neg(FVec3Reg a) { return _mm256_xor_pd(a, _mm256_set1_pd(-0.0)); }
+// (x + y) + z, in scalar order
+inline FReal vec3_hsum(FVec3Reg a)
+{
+	const __m128d xy = _mm256_castpd256_pd128(a);
+	const __m128d z = _mm256_extractf128_pd(a, 1);
+	return _mm_cvtsd_f64(_mm_add_sd(_mm_add_sd(xy, _mm_unpackhi_pd(xy, xy)), z));
+}
+#if defined(__AVX2__)
+#define RT_VEC3_SHUFFLE	1
+// (y, z, x) and (z, x, y)
+inline FVec3Reg vec3_yzx(FVec3Reg a) { return _mm256_permute4x64_pd(a, _MM_SHUFFLE(3, 0, 2, 1)); }
+inline FVec3Reg vec3_zxy(FVec3Reg a) { return _mm256_permute4x64_pd(a, _MM_SHUFFLE(3, 1, 0, 2)); }
+#endif
+
+#elif RT_VEC3_SIMD
+
+inline FVec3Reg vec3_set(FReal x, FReal y, FReal z) { return _mm_set_ps(0.0f, z, y, x); }
+inline FVec3Reg vec3_set1(FReal t) { return _mm_set1_ps(t); }
+inline FVec3Reg vec3_add(FVec3Reg a, FVec3Reg b) { return _mm_add_ps(a, b); }
+inline FVec3Reg vec3_sub(FVec3Reg a, FVec3Reg b) { return _mm_sub_ps(a, b); }
+inline FVec3Reg vec3_mul(FVec3Reg a, FVec3Reg b) { return _mm_mul_ps(a, b); }
+inline FVec3Reg vec3_neg(FVec3Reg a) { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+inline FReal vec3_hsum(FVec3Reg a)
+{
+	const __m128 y = _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1));
+	const __m128 z = _mm_movehl_ps(a, a);
+	return _mm_cvtss_f32(_mm_add_ss(_mm_add_ss(a, y), z));
+}
+#define RT_VEC3_SHUFFLE	1
+inline FVec3Reg vec3_yzx(FVec3Reg a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)); }
+inline FVec3Reg vec3_zxy(FVec3Reg a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2)); }
+
+#endif
+
+
+#if RT_VEC3_SIMD
+
+class FVec3
+{
+public:
+	FVec3() : v(vec3_set1(0.0)) {}
+	FVec3(FReal e0, FReal e1, FReal e2) : v(vec3_set(e0, e1, e2)) {}
+	explicit FVec3(FVec3Reg r) : v(r) {}
+
+	inline FReal x() const { return e[0]; }
+	inline FReal y() const { return e[1]; }
+	inline FReal z() const { return e[2]; }
+
+	inline FVec3 operator-() const { return FVec3(vec3_neg(v)); }
+	inline FReal operator[](int i) const { return e[i]; }
+	inline FReal& operator[](int i) { return e[i]; }
+
+	FVec3& operator +=(const FVec3& rhs)
+	{
+		v = vec3_add(v, rhs.v);
+		return *this;
+	}
+
+	FVec3& operator -=(const FVec3& rhs)
+	{
+		v = vec3_sub(v, rhs.v);
+		return *this;
+	}
+
+	FVec3& operator *=(const FReal t)
+	{
+		v = vec3_mul(v, vec3_set1(t));
+		return *this;
+	}
+
+	FVec3& operator /=(const FReal t)
+	{
+		return *this *= 1.0 / t;
+	}
+
+	inline FReal length() const
+	{
+		return sqrt(length2());
+	}
+
+	inline FReal length2() const
+	{
+		return vec3_hsum(vec3_mul(v, v));
+	}
+
+	inline static FVec3 random()
+	{
+		return FVec3(random_double(), random_double(), random_double());
+	}
+
+	inline static FVec3 random(FReal min, FReal max)
+	{
+		return FVec3(random_double(min, max), random_double(min, max), random_double(min, max));
+	}
+
+public:
+	union
+	{
+		FVec3Reg v;
+		FReal e[4];	// e[3] is padding
+	};
+};
+
+#else
 
 class FVec3 
 {
 public:
 	FVec3() : e{ 0.0, 0.0, 0.0 } {}
-	FVec3(double e0, double e1, double e2) : e{ e0, e1, e2 } {}
+	FVec3(FReal e0, FReal e1, FReal e2) : e{ e0, e1, e2 } {}
 
-	inline double x() const { return e[0]; }
-	inline double y() const { return e[1]; }
-	inline double z() const { return e[2]; }
+	inline FReal x() const { return e[0]; }
+	inline FReal y() const { return e[1]; }
+	inline FReal z() const { return e[2]; }
 
 	inline FVec3 operator-() const { return FVec3(-e[0], -e[1], -e[2]); }
-	inline double operator[](int i) const { return e[i]; }
-	inline double& operator[](int i) { return e[i]; }
+	inline FReal operator[](int i) const { return e[i]; }
+	inline FReal& operator[](int i) { return e[i]; }
 
 	FVec3& operator +=(const FVec3& v)
 	{
@@ -40,7 +166,7 @@ public:
 		return *this;
 	}
 
-	FVec3& operator *=(const double t)
+	FVec3& operator *=(const FReal t)
 	{
 		e[0] *= t;
 		e[1] *= t;
@@ -48,17 +174,17 @@ public:
 		return *this;
 	}
 
-	FVec3& operator /=(const double t)
+	FVec3& operator /=(const FReal t)
 	{
 		return *this *= 1.0 / t;
 	}
 
-	inline double length() const 
+	inline FReal length() const 
 	{
 		return sqrt(length2());
 	}
 
-	inline double length2() const
+	inline FReal length2() const
 	{
 		return e[0] * e[0] + e[1] * e[1] + e[2] * e[2];
 	}
@@ -68,15 +194,17 @@ public:
 		return FVec3(random_double(), random_double(), random_double());
 	}
 
-	inline static FVec3 random(double min, double max)
+	inline static FVec3 random(FReal min, FReal max)
 	{
 		return FVec3(random_double(min, max), random_double(min, max), random_double(min, max));
 	}
 
 public:
-	double e[3];
+	FReal e[3];
 };
 
+#endif
+
 // type aliases for FVec3
 using FPoint3 = FVec3;
 using FColor3 = FVec3;
@@ -87,6 +215,60 @@ inline std::ostream& operator<<(std::ostream &out, const FVec3 &v)
 	return out << v.e[0] << ' ' << v.e[1] << ' ' << v.e[2];
 }
 
+#if RT_VEC3_SIMD
+
+inline FVec3 operator +(const FVec3& lhs, const FVec3& rhs)
+{
+	return FVec3(vec3_add(lhs.v, rhs.v));
+}
+
+inline FVec3 operator -(const FVec3& lhs, const FVec3& rhs)
+{
+	return FVec3(vec3_sub(lhs.v, rhs.v));
+}
+
+inline FVec3 operator *(const FVec3& lhs, const FVec3& rhs)
+{
+	return FVec3(vec3_mul(lhs.v, rhs.v));
+}
+
+inline FVec3 operator *(FReal t, const FVec3& v)
+{
+	return FVec3(vec3_mul(vec3_set1(t), v.v));
+}
+
+inline FVec3 operator *(const FVec3& v, FReal t)
+{
+	return t * v;
+}
+
+inline FVec3 operator /(const FVec3& v, FReal t)
+{
+	return (1.0 / t) * v;
+}
+
+inline FReal dot(const FVec3& lhs, const FVec3& rhs)
+{
+	return vec3_hsum(vec3_mul(lhs.v, rhs.v));
+}
+
+#if defined(RT_VEC3_SHUFFLE)
+inline FVec3 cross(const FVec3& lhs, const FVec3& rhs)
+{
+	return FVec3(vec3_sub(vec3_mul(vec3_yzx(lhs.v), vec3_zxy(rhs.v)),
+						  vec3_mul(vec3_zxy(lhs.v), vec3_yzx(rhs.v))));
+}
+#else
+inline FVec3 cross(const FVec3& lhs, const FVec3& rhs)
+{
+	return FVec3(lhs.e[1] * rhs.e[2] - lhs.e[2] * rhs.e[1],
+				 lhs.e[2] * rhs.e[0] - lhs.e[0] * rhs.e[2],
+				 lhs.e[0] * rhs.e[1] - lhs.e[1] * rhs.e[0]);
+}
+#endif
+
+#else
+
 inline FVec3 operator +(const FVec3& lhs, const FVec3& rhs)
 {
 	return FVec3(lhs.e[0] + rhs.e[0], lhs.e[1] + rhs.e[1], lhs.e[2] + rhs.e[2]);
@@ -102,22 +284,22 @@ inline FVec3 operator *(const FVec3& lhs, const FVec3& rhs)
 	return FVec3(lhs.e[0] * rhs.e[0], lhs.e[1] * rhs.e[1], lhs.e[2] * rhs.e[2]);
 }
 
-inline FVec3 operator *(double t, const FVec3& v)
+inline FVec3 operator *(FReal t, const FVec3& v)
 {
 	return FVec3(t * v.e[0], t * v.e[1], t * v.e[2]);
 }
 
-inline FVec3 operator *(const FVec3& v, double t)
+inline FVec3 operator *(const FVec3& v, FReal t)
 {
 	return t * v;
 }
 
-inline FVec3 operator /(const FVec3& v, double t)
+inline FVec3 operator /(const FVec3& v, FReal t)
 {
 	return (1.0 / t) * v;
 }
 
-inline double dot(const FVec3& lhs, const FVec3& rhs)
+inline FReal dot(const FVec3& lhs, const FVec3& rhs)
 {
 	return lhs.e[0] * rhs.e[0]
 		+ lhs.e[1] * rhs.e[1]
@@ -131,6 +313,7 @@ inline FVec3 cross(const FVec3& lhs, const FVec3& rhs)
 				 lhs.e[0] * rhs.e[1] - lhs.e[1] * rhs.e[0]);
 }
 
+#endif
 
 inline FVec3 unit_vector(const FVec3& v)
 {
@@ -190,7 +373,7 @@ inline FVec3 reflect(const FVec3& v, const FVec3& n)
 //               | \     eta'
 //               |  R'
 //
-inline FVec3 refract(const FVec3& uv, const FVec3& n, double etai_over_etat)
+inline FVec3 refract(const FVec3& uv, const FVec3& n, FReal etai_over_etat)
 {
 	auto cos_theta = dot(-uv, n);
 	FVec3 r_out_parallel = etai_over_etat * (uv + cos_theta * n);
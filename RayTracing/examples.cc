@@ -4,17 +4,21 @@
 
 #include <iostream>
 #include "timer.h"
+#include "examples.h"
 #include "hittable.h"
 #include "hittable_list.h"
 #include "sphere.h"
 #include "moving_sphere.h"
 #include "aarect.h"
 #include "box.h"
+#include "triangle_mesh.h"
 #include "color.h"
 #include "camera.h"
 #include "material.h"
 #include "bvh.h"
 #include "constantmedium.h"
+#include "medium.h"
+#include "scene_arena.h"
 
 
 shared_ptr<FHittable> sample_random_scene(shared_ptr<FRayCamera>& OutCamera, FColor3& background)
@@ -28,14 +32,15 @@ shared_ptr<FHittable> sample_random_scene(shared_ptr<FRayCamera>& OutCamera, FCo
 	auto film_focus = 10.0;
 	OutCamera = make_shared<FPinholeCamera>(lookfrom, lookat, vup, vfov, aspect_ratio, film_focus, 0.0, 0.0);
 	background = FColor3(0.70, 0.80, 1.00);
+	shared_ptr<FSceneArena> arena = make_shared<FSceneArena>();
 
-	shared_ptr<FHittableList> world = make_shared<FHittableList>();
+	shared_ptr<FHittableList> world = arena->make<FHittableList>();
 
-	auto checker = make_shared<FCheckerTexture>(
-		make_shared<FSolidColor>(FColor3(0.2, 0.3, 0.1)),
-		make_shared<FSolidColor>(FColor3(0.9, 0.9, 0.9)));
-	shared_ptr<FMaterial> ground_material = make_shared<FLambertian>(checker);
-	world->add(make_shared<FSphere>(FPoint3(0, -1000, 0), 1000, ground_material));
+	auto checker = arena->make<FCheckerTexture>(
+		arena->make<FSolidColor>(FColor3(0.2, 0.3, 0.1)),
+		arena->make<FSolidColor>(FColor3(0.9, 0.9, 0.9)));
+	shared_ptr<FMaterial> ground_material = arena->make<FLambertian>(checker);
+	world->add(arena->make<FSphere>(FPoint3(0, -1000, 0), 1000, ground_material));
 
 	const int count = 11;
 	for (int a = -count; a < count; a++) {
@@ -49,38 +54,38 @@ shared_ptr<FHittable> sample_random_scene(shared_ptr<FRayCamera>& OutCamera, FCo
 				if (choose_mat < 0.8) {
 					// diffuse
 					auto albedo = FColor3::random() * FColor3::random();
-					sphere_material = make_shared<FLambertian>(make_shared<FSolidColor>(albedo));
+					sphere_material = arena->make<FLambertian>(arena->make<FSolidColor>(albedo));
 
 					auto center2 = center + FVec3(0, random_double(0, 0.5), 0);
-					world->add(make_shared<FMovingSphere>(FPositionTrackKey(center, 0.0), FPositionTrackKey(center2, 1.0), 0.2, sphere_material));
+					world->add(arena->make<FMovingSphere>(FPositionTrackKey(center, 0.0), FPositionTrackKey(center2, 1.0), 0.2, sphere_material));
 				}
 				else if (choose_mat < 0.95) {
 					// metal
 					auto albedo = FColor3::random(0.5, 1);
 					auto fuzz = random_double(0, 0.5);
-					sphere_material = make_shared<FMetal>(albedo, fuzz);
-					world->add(make_shared<FSphere>(center, 0.2, sphere_material));
+					sphere_material = arena->make<FMetal>(albedo, fuzz);
+					world->add(arena->make<FSphere>(center, 0.2, sphere_material));
 				}
 				else {
 					// glass
-					sphere_material = make_shared<FDielectric>(1.5);
-					world->add(make_shared<FSphere>(center, 0.2, sphere_material));
+					sphere_material = arena->make<FDielectric>(1.5);
+					world->add(arena->make<FSphere>(center, 0.2, sphere_material));
 				}
 			}
 		}
 	}
 
-	auto material1 = make_shared<FDielectric>(1.5);
-	world->add(make_shared<FSphere>(FPoint3(0, 1, 0), 1.0, material1));
+	auto material1 = arena->make<FDielectric>(1.5);
+	world->add(arena->make<FSphere>(FPoint3(0, 1, 0), 1.0, material1));
 
-	auto material2 = make_shared<FLambertian>(make_shared<FSolidColor>(FColor3(0.4, 0.2, 0.1)));
-	world->add(make_shared<FSphere>(FPoint3(-4, 1, 0), 1.0, material2));
+	auto material2 = arena->make<FLambertian>(arena->make<FSolidColor>(FColor3(0.4, 0.2, 0.1)));
+	world->add(arena->make<FSphere>(FPoint3(-4, 1, 0), 1.0, material2));
 
-	auto material3 = make_shared<FMetal>(FColor3(0.7, 0.6, 0.5), 0.0);
-	world->add(make_shared<FSphere>(FPoint3(4, 1, 0), 1.0, material3));
+	auto material3 = arena->make<FMetal>(FColor3(0.7, 0.6, 0.5), 0.0);
+	world->add(arena->make<FSphere>(FPoint3(4, 1, 0), 1.0, material3));
 
 	// use bvh
-	shared_ptr<FBVH_Node> bvh = make_shared<FBVH_Node>(*world, 0.0, 1.0);
+	shared_ptr<FBVH_Node> bvh = arena->make<FBVH_Node>(*world, 0.0, 1.0);
 	return bvh;
 }
 
@@ -95,18 +100,19 @@ shared_ptr<FHittable> sample_two_spheres(shared_ptr<FRayCamera>& OutCamera, FCol
 	auto film_focus = 10.0;
 	OutCamera = make_shared<FPinholeCamera>(lookfrom, lookat, vup, vfov, aspect_ratio, film_focus, 0.0, 0.0);
 	background = FColor3(0.70, 0.80, 1.00);
+	shared_ptr<FSceneArena> arena = make_shared<FSceneArena>();
 
 
-	shared_ptr<FHittableList> world = make_shared<FHittableList>();
+	shared_ptr<FHittableList> world = arena->make<FHittableList>();
 
-	auto checker = make_shared<FCheckerTexture>(
-		make_shared<FSolidColor>(FColor3(0.2, 0.3, 0.1)),
-		make_shared<FSolidColor>(FColor3(0.9, 0.9, 0.9)));
+	auto checker = arena->make<FCheckerTexture>(
+		arena->make<FSolidColor>(FColor3(0.2, 0.3, 0.1)),
+		arena->make<FSolidColor>(FColor3(0.9, 0.9, 0.9)));
 
-	shared_ptr<FMaterial> ground_material = make_shared<FLambertian>(checker);
+	shared_ptr<FMaterial> ground_material = arena->make<FLambertian>(checker);
 
-	world->add(make_shared<FSphere>(FPoint3(0, -10, 0), 10, ground_material));
-	world->add(make_shared<FSphere>(FPoint3(0, +10, 0), 10, ground_material));
+	world->add(arena->make<FSphere>(FPoint3(0, -10, 0), 10, ground_material));
+	world->add(arena->make<FSphere>(FPoint3(0, +10, 0), 10, ground_material));
 
 	return world;
 }
@@ -122,18 +128,19 @@ shared_ptr<FHittable> sample_two_perlin_spheres(shared_ptr<FRayCamera>& OutCamer
 	auto film_focus = 10.0;
 	OutCamera = make_shared<FPinholeCamera>(lookfrom, lookat, vup, vfov, aspect_ratio, film_focus, 0.0, 0.0);
 	background = FColor3(0.70, 0.80, 1.00);
+	shared_ptr<FSceneArena> arena = make_shared<FSceneArena>();
 
 
-	shared_ptr<FHittableList> world = make_shared<FHittableList>();
+	shared_ptr<FHittableList> world = arena->make<FHittableList>();
 
-	auto noise_texture1 = make_shared<FNoiseTexture>(NOISE_EFFECT_WOOD);
-	shared_ptr<FMaterial> ground_material = make_shared<FLambertian>(noise_texture1);
+	auto noise_texture1 = arena->make<FNoiseTexture>(NOISE_EFFECT_WOOD);
+	shared_ptr<FMaterial> ground_material = arena->make<FLambertian>(noise_texture1);
 
-	auto noise_texture2 = make_shared<FNoiseTexture>(NOISE_EFFECT_MARBLE);
-	shared_ptr<FMaterial> ground_material2 = make_shared<FLambertian>(noise_texture2);
+	auto noise_texture2 = arena->make<FNoiseTexture>(NOISE_EFFECT_MARBLE);
+	shared_ptr<FMaterial> ground_material2 = arena->make<FLambertian>(noise_texture2);
 
-	world->add(make_shared<FSphere>(FPoint3(0, -1000, 0), 1000, ground_material2));
-	world->add(make_shared<FSphere>(FPoint3(0, 2, 0), 2, ground_material));
+	world->add(arena->make<FSphere>(FPoint3(0, -1000, 0), 1000, ground_material2));
+	world->add(arena->make<FSphere>(FPoint3(0, 2, 0), 2, ground_material));
 
 	return world;
 }
@@ -149,15 +156,16 @@ shared_ptr<FHittable> sample_two_worley_spheres(shared_ptr<FRayCamera>& OutCamer
 	auto film_focus = 10.0;
 	OutCamera = make_shared<FPinholeCamera>(lookfrom, lookat, vup, vfov, aspect_ratio, film_focus, 0.0, 0.0);
 	background = FColor3(0.70, 0.80, 1.00);
+	shared_ptr<FSceneArena> arena = make_shared<FSceneArena>();
 
 
-	shared_ptr<FHittableList> world = make_shared<FHittableList>();
+	shared_ptr<FHittableList> world = arena->make<FHittableList>();
 
-	auto noise_texture = make_shared<FNoiseTexture>(NOISE_EFFECT_WORLEY);
-	shared_ptr<FMaterial> ground_material = make_shared<FLambertian>(noise_texture);
+	auto noise_texture = arena->make<FNoiseTexture>(NOISE_EFFECT_WORLEY);
+	shared_ptr<FMaterial> ground_material = arena->make<FLambertian>(noise_texture);
 
-	world->add(make_shared<FSphere>(FPoint3(0, -1000, 0), 1000, ground_material));
-	world->add(make_shared<FSphere>(FPoint3(0, 4, 0), 4, ground_material));
+	world->add(arena->make<FSphere>(FPoint3(0, -1000, 0), 1000, ground_material));
+	world->add(arena->make<FSphere>(FPoint3(0, 4, 0), 4, ground_material));
 
 	return world;
 }
@@ -173,13 +181,14 @@ shared_ptr<FHittable> sample_earth(shared_ptr<FRayCamera>& OutCamera, FColor3& b
 	auto film_focus = 10.0;
 	OutCamera = make_shared<FPinholeCamera>(lookfrom, lookat, vup, vfov, aspect_ratio, film_focus, 0.0, 0.0);
 	background = FColor3(0.70, 0.80, 1.00);
+	shared_ptr<FSceneArena> arena = make_shared<FSceneArena>();
 
 
-	shared_ptr<FHittableList> world = make_shared<FHittableList>();
+	shared_ptr<FHittableList> world = arena->make<FHittableList>();
 
-	auto earth_texture = make_shared<FImageTexture>("earthmap.jpg");
-	shared_ptr<FMaterial> ground_material = make_shared<FLambertian>(earth_texture);
-	world->add(make_shared<FSphere>(FPoint3(0, 0, 0), 2, ground_material));
+	auto earth_texture = arena->make<FImageTexture>("earthmap.jpg");
+	shared_ptr<FMaterial> ground_material = arena->make<FLambertian>(earth_texture);
+	world->add(arena->make<FSphere>(FPoint3(0, 0, 0), 2, ground_material));
 
 	return world;
 }
@@ -195,19 +204,20 @@ shared_ptr<FHittable> sample_simple_light(shared_ptr<FRayCamera>& OutCamera, FCo
 	auto film_focus = 10.0;
 	OutCamera = make_shared<FPinholeCamera>(lookfrom, lookat, vup, vfov, aspect_ratio, film_focus, 0.0, 0.0);
 	background = FColor3(0, 0, 0);
+	shared_ptr<FSceneArena> arena = make_shared<FSceneArena>();
 
 
-	shared_ptr<FHittableList> world = make_shared<FHittableList>();
+	shared_ptr<FHittableList> world = arena->make<FHittableList>();
 
-	auto noise_texture = make_shared<FNoiseTexture>();
-	shared_ptr<FMaterial> ground_material = make_shared<FLambertian>(noise_texture);
+	auto noise_texture = arena->make<FNoiseTexture>();
+	shared_ptr<FMaterial> ground_material = arena->make<FLambertian>(noise_texture);
 
-	world->add(make_shared<FSphere>(FPoint3(0, -1000, 0), 1000, ground_material));
-	world->add(make_shared<FSphere>(FPoint3(0, 2, 0), 2, ground_material));
+	world->add(arena->make<FSphere>(FPoint3(0, -1000, 0), 1000, ground_material));
+	world->add(arena->make<FSphere>(FPoint3(0, 2, 0), 2, ground_material));
 
-	auto difflight = make_shared<FDiffuseLight>(make_shared<FSolidColor>(4, 4, 4));
-	world->add(make_shared<FSphere>(FPoint3(0, 7, 0), 2, difflight));
-	world->add(make_shared<FXYRect>(3, 5, 1, 3, -2, difflight));
+	auto difflight = arena->make<FDiffuseLight>(arena->make<FSolidColor>(4, 4, 4));
+	world->add(arena->make<FSphere>(FPoint3(0, 7, 0), 2, difflight));
+	world->add(arena->make<FXYRect>(3, 5, 1, 3, -2, difflight));
 
 	return world;
 }
@@ -223,30 +233,31 @@ shared_ptr<FHittable> sample_cornell_box(shared_ptr<FRayCamera>& OutCamera, FCol
 	auto film_focus = 10.0;
 	OutCamera = make_shared<FPinholeCamera>(lookfrom, lookat, vup, vfov, aspect_ratio, film_focus, 0.0, 0.0);
 	background = FColor3(0, 0, 0);
+	shared_ptr<FSceneArena> arena = make_shared<FSceneArena>();
 
 
-	shared_ptr<FHittableList> world = make_shared<FHittableList>();
+	shared_ptr<FHittableList> world = arena->make<FHittableList>();
 
-	auto red = make_shared<FLambertian>(make_shared<FSolidColor>(.65, .05, .05));
-	auto white = make_shared<FLambertian>(make_shared<FSolidColor>(.73, .73, .73));
-	auto green = make_shared<FLambertian>(make_shared<FSolidColor>(.12, .45, .15));
-	auto light = make_shared<FDiffuseLight>(make_shared<FSolidColor>(15, 15, 15));
+	auto red = arena->make<FLambertian>(arena->make<FSolidColor>(.65, .05, .05));
+	auto white = arena->make<FLambertian>(arena->make<FSolidColor>(.73, .73, .73));
+	auto green = arena->make<FLambertian>(arena->make<FSolidColor>(.12, .45, .15));
+	auto light = arena->make<FDiffuseLight>(arena->make<FSolidColor>(15, 15, 15));
 
-	world->add(make_shared<FFlipFace>(make_shared<FYZRect>(0, 555, 0, 555, 555, green)));
-	world->add(make_shared<FYZRect>(0, 555, 0, 555, 0, red));
-	world->add(make_shared<FXZRect>(213, 343, 227, 332, 554, light));
-	world->add(make_shared<FFlipFace>(make_shared<FXZRect>(0, 555, 0, 555, 555, white)));
-	world->add(make_shared<FXZRect>(0, 555, 0, 555, 0, white));
-	world->add(make_shared<FFlipFace>(make_shared<FXYRect>(0, 555, 0, 555, 555, white)));
+	world->add(arena->make<FFlipFace>(arena->make<FYZRect>(0, 555, 0, 555, 555, green)));
+	world->add(arena->make<FYZRect>(0, 555, 0, 555, 0, red));
+	world->add(arena->make<FXZRect>(213, 343, 227, 332, 554, light));
+	world->add(arena->make<FFlipFace>(arena->make<FXZRect>(0, 555, 0, 555, 555, white)));
+	world->add(arena->make<FXZRect>(0, 555, 0, 555, 0, white));
+	world->add(arena->make<FFlipFace>(arena->make<FXYRect>(0, 555, 0, 555, 555, white)));
 
-	shared_ptr<FHittable> box1 = make_shared<FBox>(FPoint3(0, 0, 0), FPoint3(165, 330, 165), white);
-	box1 = make_shared<FRotateY>(box1, 15);
-	box1 = make_shared<FTranslate>(box1, FVec3(265, 0, 295));
+	shared_ptr<FHittable> box1 = arena->make<FBox>(FPoint3(0, 0, 0), FPoint3(165, 330, 165), white);
+	box1 = arena->make<FRotateY>(box1, 15);
+	box1 = arena->make<FTranslate>(box1, FVec3(265, 0, 295));
 	world->add(box1);
 
-	shared_ptr<FHittable> box2 = make_shared<FBox>(FPoint3(0, 0, 0), FPoint3(165, 165, 165), white);
-	box2 = make_shared<FRotateY>(box2, -18);
-	box2 = make_shared<FTranslate>(box2, FVec3(130, 0, 65));
+	shared_ptr<FHittable> box2 = arena->make<FBox>(FPoint3(0, 0, 0), FPoint3(165, 165, 165), white);
+	box2 = arena->make<FRotateY>(box2, -18);
+	box2 = arena->make<FTranslate>(box2, FVec3(130, 0, 65));
 	world->add(box2);
 
 	return world;
@@ -263,29 +274,30 @@ shared_ptr<FHittable> sample_cornell_ball(shared_ptr<FRayCamera>& OutCamera, FCo
 	auto film_focus = 10.0;
 	OutCamera = make_shared<FPinholeCamera>(lookfrom, lookat, vup, vfov, aspect_ratio, film_focus, 0.0, 0.0);
 	background = FColor3(0, 0, 0);
+	shared_ptr<FSceneArena> arena = make_shared<FSceneArena>();
 
 
-	shared_ptr<FHittableList> world = make_shared<FHittableList>();
+	shared_ptr<FHittableList> world = arena->make<FHittableList>();
 
-	auto red = make_shared<FLambertian>(make_shared<FSolidColor>(.65, .05, .05));
-	auto white = make_shared<FLambertian>(make_shared<FSolidColor>(.73, .73, .73));
-	auto green = make_shared<FLambertian>(make_shared<FSolidColor>(.12, .45, .15));
-	auto light = make_shared<FDiffuseLight>(make_shared<FSolidColor>(5, 5, 5));
+	auto red = arena->make<FLambertian>(arena->make<FSolidColor>(.65, .05, .05));
+	auto white = arena->make<FLambertian>(arena->make<FSolidColor>(.73, .73, .73));
+	auto green = arena->make<FLambertian>(arena->make<FSolidColor>(.12, .45, .15));
+	auto light = arena->make<FDiffuseLight>(arena->make<FSolidColor>(5, 5, 5));
 
-	world->add(make_shared<FFlipFace>(make_shared<FYZRect>(0, 555, 0, 555, 555, green)));
-	world->add(make_shared<FYZRect>(0, 555, 0, 555, 0, red));
-	world->add(make_shared<FXZRect>(113, 443, 127, 432, 554, light));
-	world->add(make_shared<FFlipFace>(make_shared<FXZRect>(0, 555, 0, 555, 555, white)));
-	world->add(make_shared<FXZRect>(0, 555, 0, 555, 0, white));
-	world->add(make_shared<FFlipFace>(make_shared<FXYRect>(0, 555, 0, 555, 555, white)));
+	world->add(arena->make<FFlipFace>(arena->make<FYZRect>(0, 555, 0, 555, 555, green)));
+	world->add(arena->make<FYZRect>(0, 555, 0, 555, 0, red));
+	world->add(arena->make<FXZRect>(113, 443, 127, 432, 554, light));
+	world->add(arena->make<FFlipFace>(arena->make<FXZRect>(0, 555, 0, 555, 555, white)));
+	world->add(arena->make<FXZRect>(0, 555, 0, 555, 0, white));
+	world->add(arena->make<FFlipFace>(arena->make<FXYRect>(0, 555, 0, 555, 555, white)));
 
-	auto boundary = make_shared<FSphere>(FPoint3(160, 100, 145), 100, make_shared<FDielectric>(1.5));
+	auto boundary = arena->make<FSphere>(FPoint3(160, 100, 145), 100, arena->make<FDielectric>(1.5));
 	world->add(boundary);
-	world->add(make_shared<FConstantMedium>(boundary, 0.1, make_shared<FSolidColor>(1, 1, 1)));
+	world->add(arena->make<FConstantMedium>(boundary, 0.1, arena->make<FSolidColor>(1, 1, 1)));
 
-	shared_ptr<FHittable> box1 = make_shared<FBox>(FPoint3(0, 0, 0), FPoint3(165, 330, 165), white);
-	box1 = make_shared<FRotateY>(box1, 15);
-	box1 = make_shared<FTranslate>(box1, FVec3(265, 0, 295));
+	shared_ptr<FHittable> box1 = arena->make<FBox>(FPoint3(0, 0, 0), FPoint3(165, 330, 165), white);
+	box1 = arena->make<FRotateY>(box1, 15);
+	box1 = arena->make<FTranslate>(box1, FVec3(265, 0, 295));
 	world->add(box1);
 
 	return world;
@@ -302,31 +314,32 @@ shared_ptr<FHittable> sample_cornell_smoke(shared_ptr<FRayCamera>& OutCamera, FC
 	auto film_focus = 10.0;
 	OutCamera = make_shared<FPinholeCamera>(lookfrom, lookat, vup, vfov, aspect_ratio, film_focus, 0.0, 0.0);
 	background = FColor3(0, 0, 0);
+	shared_ptr<FSceneArena> arena = make_shared<FSceneArena>();
 
-	shared_ptr<FHittableList> world = make_shared<FHittableList>();
+	shared_ptr<FHittableList> world = arena->make<FHittableList>();
 
-	auto red = make_shared<FLambertian>(make_shared<FSolidColor>(.65, .05, .05));
-	auto white = make_shared<FLambertian>(make_shared<FSolidColor>(.73, .73, .73));
-	auto green = make_shared<FLambertian>(make_shared<FSolidColor>(.12, .45, .15));
-	auto light = make_shared<FDiffuseLight>(make_shared<FSolidColor>(7, 7, 7));
+	auto red = arena->make<FLambertian>(arena->make<FSolidColor>(.65, .05, .05));
+	auto white = arena->make<FLambertian>(arena->make<FSolidColor>(.73, .73, .73));
+	auto green = arena->make<FLambertian>(arena->make<FSolidColor>(.12, .45, .15));
+	auto light = arena->make<FDiffuseLight>(arena->make<FSolidColor>(7, 7, 7));
 
-	world->add(make_shared<FFlipFace>(make_shared<FYZRect>(0, 555, 0, 555, 555, green)));
-	world->add(make_shared<FYZRect>(0, 555, 0, 555, 0, red));
-	world->add(make_shared<FXZRect>(113, 443, 127, 432, 554, light));
-	world->add(make_shared<FFlipFace>(make_shared<FXZRect>(0, 555, 0, 555, 555, white)));
-	world->add(make_shared<FXZRect>(0, 555, 0, 555, 0, white));
-	world->add(make_shared<FFlipFace>(make_shared<FXYRect>(0, 555, 0, 555, 555, white)));
+	world->add(arena->make<FFlipFace>(arena->make<FYZRect>(0, 555, 0, 555, 555, green)));
+	world->add(arena->make<FYZRect>(0, 555, 0, 555, 0, red));
+	world->add(arena->make<FXZRect>(113, 443, 127, 432, 554, light));
+	world->add(arena->make<FFlipFace>(arena->make<FXZRect>(0, 555, 0, 555, 555, white)));
+	world->add(arena->make<FXZRect>(0, 555, 0, 555, 0, white));
+	world->add(arena->make<FFlipFace>(arena->make<FXYRect>(0, 555, 0, 555, 555, white)));
 
-	shared_ptr<FHittable> box1 = make_shared<FBox>(FPoint3(0, 0, 0), FPoint3(165, 330, 165), white);
-	box1 = make_shared<FRotateY>(box1, 15);
-	box1 = make_shared<FTranslate>(box1, FVec3(265, 0, 295));
+	shared_ptr<FHittable> box1 = arena->make<FBox>(FPoint3(0, 0, 0), FPoint3(165, 330, 165), white);
+	box1 = arena->make<FRotateY>(box1, 15);
+	box1 = arena->make<FTranslate>(box1, FVec3(265, 0, 295));
 
-	shared_ptr<FHittable> box2 = make_shared<FBox>(FPoint3(0, 0, 0), FPoint3(165, 165, 165), white);
-	box2 = make_shared<FRotateY>(box2, -18);
-	box2 = make_shared<FTranslate>(box2, FVec3(130, 0, 65));
+	shared_ptr<FHittable> box2 = arena->make<FBox>(FPoint3(0, 0, 0), FPoint3(165, 165, 165), white);
+	box2 = arena->make<FRotateY>(box2, -18);
+	box2 = arena->make<FTranslate>(box2, FVec3(130, 0, 65));
 
-	world->add(make_shared<FConstantMedium>(box1, 0.01, make_shared<FSolidColor>(0, 0, 0)));
-	world->add(make_shared<FConstantMedium>(box2, 0.01, make_shared<FSolidColor>(1, 1, 1)));
+	world->add(arena->make<FConstantMedium>(box1, 0.01, arena->make<FSolidColor>(0, 0, 0)));
+	world->add(arena->make<FConstantMedium>(box2, 0.01, arena->make<FSolidColor>(1, 1, 1)));
 
 	return world;
 }
@@ -342,35 +355,36 @@ shared_ptr<FHittable> sample_cornell_final(shared_ptr<FRayCamera>& OutCamera, FC
 	auto film_focus = 10.0;
 	OutCamera = make_shared<FPinholeCamera>(lookfrom, lookat, vup, vfov, aspect_ratio, film_focus, 0.0, 0.0);
 	background = FColor3(0, 0, 0);
+	shared_ptr<FSceneArena> arena = make_shared<FSceneArena>();
 
 
-	shared_ptr<FHittableList> world = make_shared<FHittableList>();
+	shared_ptr<FHittableList> world = arena->make<FHittableList>();
 
-	auto pertext = make_shared<FNoiseTexture>();
+	auto pertext = arena->make<FNoiseTexture>();
 
-	auto mat = make_shared<FLambertian>(make_shared<FImageTexture>("earthmap.jpg"));
+	auto mat = arena->make<FLambertian>(arena->make<FImageTexture>("earthmap.jpg"));
 
-	auto red = make_shared<FLambertian>(make_shared<FSolidColor>(.65, .05, .05));
-	auto white = make_shared<FLambertian>(make_shared<FSolidColor>(.73, .73, .73));
-	auto green = make_shared<FLambertian>(make_shared<FSolidColor>(.12, .45, .15));
-	auto light = make_shared<FDiffuseLight>(make_shared<FSolidColor>(7, 7, 7));
+	auto red = arena->make<FLambertian>(arena->make<FSolidColor>(.65, .05, .05));
+	auto white = arena->make<FLambertian>(arena->make<FSolidColor>(.73, .73, .73));
+	auto green = arena->make<FLambertian>(arena->make<FSolidColor>(.12, .45, .15));
+	auto light = arena->make<FDiffuseLight>(arena->make<FSolidColor>(7, 7, 7));
 
-	world->add(make_shared<FFlipFace>(make_shared<FYZRect>(0, 555, 0, 555, 555, green)));
-	world->add(make_shared<FYZRect>(0, 555, 0, 555, 0, red));
-	world->add(make_shared<FXZRect>(123, 423, 147, 412, 554, light));
-	world->add(make_shared<FFlipFace>(make_shared<FXZRect>(0, 555, 0, 555, 555, white)));
-	world->add(make_shared<FXZRect>(0, 555, 0, 555, 0, white));
-	world->add(make_shared<FFlipFace>(make_shared<FXYRect>(0, 555, 0, 555, 555, white)));
+	world->add(arena->make<FFlipFace>(arena->make<FYZRect>(0, 555, 0, 555, 555, green)));
+	world->add(arena->make<FYZRect>(0, 555, 0, 555, 0, red));
+	world->add(arena->make<FXZRect>(123, 423, 147, 412, 554, light));
+	world->add(arena->make<FFlipFace>(arena->make<FXZRect>(0, 555, 0, 555, 555, white)));
+	world->add(arena->make<FXZRect>(0, 555, 0, 555, 0, white));
+	world->add(arena->make<FFlipFace>(arena->make<FXYRect>(0, 555, 0, 555, 555, white)));
 
 	shared_ptr<FHittable> boundary2 =
-		make_shared<FBox>(FPoint3(0, 0, 0), FPoint3(165, 165, 165), make_shared<FDielectric>(1.5));
-	boundary2 = make_shared<FRotateY>(boundary2, -18);
-	boundary2 = make_shared<FTranslate>(boundary2, FVec3(130, 0, 65));
+		arena->make<FBox>(FPoint3(0, 0, 0), FPoint3(165, 165, 165), arena->make<FDielectric>(1.5));
+	boundary2 = arena->make<FRotateY>(boundary2, -18);
+	boundary2 = arena->make<FTranslate>(boundary2, FVec3(130, 0, 65));
 
-	auto tex = make_shared<FSolidColor>(0.9, 0.9, 0.9);
+	auto tex = arena->make<FSolidColor>(0.9, 0.9, 0.9);
 
 	world->add(boundary2);
-	world->add(make_shared<FConstantMedium>(boundary2, 0.2, tex));
+	world->add(arena->make<FConstantMedium>(boundary2, 0.2, tex));
 
 	return world;
 }
@@ -386,15 +400,16 @@ shared_ptr<FHittable> sample_final_scene(shared_ptr<FRayCamera>& OutCamera, FCol
 	auto film_focus = 10.0;
 	OutCamera = make_shared<FPinholeCamera>(lookfrom, lookat, vup, vfov, aspect_ratio, film_focus, 0.0, 0.0);
 	background = FColor3(0, 0, 0);
+	shared_ptr<FSceneArena> arena = make_shared<FSceneArena>();
 
 
-	shared_ptr<FHittableList> world = make_shared<FHittableList>();
+	shared_ptr<FHittableList> world = arena->make<FHittableList>();
 
-	auto light = make_shared<FDiffuseLight>(make_shared<FSolidColor>(7, 7, 7));
-	world->add(make_shared<FXZRect>(123, 423, 147, 412, 554, light));
+	auto light = arena->make<FDiffuseLight>(arena->make<FSolidColor>(7, 7, 7));
+	world->add(arena->make<FXZRect>(123, 423, 147, 412, 554, light));
 
 	FHittableList boxes1;
-	auto ground = make_shared<FLambertian>(make_shared<FSolidColor>(0.48, 0.83, 0.53));
+	auto ground = arena->make<FLambertian>(arena->make<FSolidColor>(0.48, 0.83, 0.53));
 
 	const int boxes_per_side = 20;
 	for (int i = 0; i < boxes_per_side; i++) {
@@ -407,48 +422,49 @@ shared_ptr<FHittable> sample_final_scene(shared_ptr<FRayCamera>& OutCamera, FCol
 			auto y1 = random_double(1, 101);
 			auto z1 = z0 + w;
 
-			boxes1.add(make_shared<FBox>(FPoint3(x0, y0, z0), FPoint3(x1, y1, z1), ground));
+			boxes1.add(arena->make<FBox>(FPoint3(x0, y0, z0), FPoint3(x1, y1, z1), ground));
 		}
 	}
 
-	world->add(make_shared<FBVH_Node>(boxes1, 0, 1));
+	world->add(arena->make<FBVH_Node>(boxes1, 0, 1));
 
 	auto center1 = FPoint3(400, 400, 200);
 	auto center2 = center1 + FVec3(30, 0, 0);
 	auto moving_sphere_material =
-		make_shared<FLambertian>(make_shared<FSolidColor>(0.7, 0.3, 0.1));
-	world->add(make_shared<FMovingSphere>(FPositionTrackKey(center1, 0), FPositionTrackKey(center2, 1), 50, moving_sphere_material));
+		arena->make<FLambertian>(arena->make<FSolidColor>(0.7, 0.3, 0.1));
+	world->add(arena->make<FMovingSphere>(FPositionTrackKey(center1, 0), FPositionTrackKey(center2, 1), 50, moving_sphere_material));
 
-	world->add(make_shared<FSphere>(FPoint3(260, 150, 45), 50, make_shared<FDielectric>(1.5)));
-	world->add(make_shared<FSphere>(
-		FPoint3(0, 150, 145), 50, make_shared<FMetal>(FColor3(0.8, 0.8, 0.9), 10.0)
+	world->add(arena->make<FSphere>(FPoint3(260, 150, 45), 50, arena->make<FDielectric>(1.5)));
+	world->add(arena->make<FSphere>(
+		FPoint3(0, 150, 145), 50, arena->make<FMetal>(FColor3(0.8, 0.8, 0.9), 10.0)
 		));
 
-	auto boundary = make_shared<FSphere>(FPoint3(360, 150, 145), 70, make_shared<FDielectric>(1.5));
+	auto boundary = arena->make<FSphere>(FPoint3(360, 150, 145), 70, arena->make<FDielectric>(1.5));
 	world->add(boundary);
-	world->add(make_shared<FConstantMedium>(
-		boundary, 0.2, make_shared<FSolidColor>(0.2, 0.4, 0.9)
+	world->add(arena->make<FConstantMedium>(
+		boundary, 0.2, arena->make<FSolidColor>(0.2, 0.4, 0.9)
 		));
-	boundary = make_shared<FSphere>(FPoint3(0, 0, 0), 5000, make_shared<FDielectric>(1.5));
-	world->add(make_shared<FConstantMedium>(boundary, .0001, make_shared<FSolidColor>(1, 1, 1)));
+	boundary = arena->make<FSphere>(FPoint3(0, 0, 0), 5000, arena->make<FDielectric>(1.5));
+	world->add(arena->make<FConstantMedium>(boundary, .0001, arena->make<FSolidColor>(1, 1, 1)));
 
 
-	auto emat = make_shared<FLambertian>(make_shared<FImageTexture>("earthmap.jpg"));
-	world->add(make_shared<FSphere>(FPoint3(400, 200, 400), 100, emat));
+	auto emat = arena->make<FLambertian>(arena->make<FImageTexture>("earthmap.jpg"));
+	world->add(arena->make<FSphere>(FPoint3(400, 200, 400), 100, emat));
 
-	auto pertext = make_shared<FNoiseTexture>();
-	world->add(make_shared<FSphere>(FPoint3(220, 280, 300), 80, make_shared<FLambertian>(pertext)));
+	auto pertext = arena->make<FNoiseTexture>();
+	world->add(arena->make<FSphere>(FPoint3(220, 280, 300), 80, arena->make<FLambertian>(pertext)));
 
 	FHittableList boxes2;
-	auto white = make_shared<FLambertian>(make_shared<FSolidColor>(.73, .73, .73));
+	auto white = arena->make<FLambertian>(arena->make<FSolidColor>(.73, .73, .73));
 	int ns = 1000;
 	for (int j = 0; j < ns; j++) {
-		boxes2.add(make_shared<FSphere>(FPoint3::random(0, 165), 10, white));
+		boxes2.add(arena->make<FSphere>(FPoint3::random(0, 165), 10, white));
 	}
 
-	world->add(make_shared<FTranslate>(
-		make_shared<FRotateY>(
-			make_shared<FBVH_Node>(boxes2, 0.0, 1.0), 15),
+	// the sphere cluster is built lazily, subtrees no ray enters are never split
+	world->add(arena->make<FTranslate>(
+		arena->make<FRotateY>(
+			arena->make<FLazyBVH_Node>(boxes2, 0.0, 1.0), 15),
 		FVec3(-100, 270, 395)
 		)
 	);
@@ -467,43 +483,44 @@ shared_ptr<FHittable> sample_pbr_sphere_scene(shared_ptr<FRayCamera>& OutCamera,
 	auto film_focus = 10.0;
 	OutCamera = make_shared<FPinholeCamera>(lookfrom, lookat, vup, vfov, aspect_ratio, film_focus, 0.0, 0.0);
 	background = FColor3(0, 0, 0);
+	shared_ptr<FSceneArena> arena = make_shared<FSceneArena>();
 
 
-	shared_ptr<FHittableList> world = make_shared<FHittableList>();
+	shared_ptr<FHittableList> world = arena->make<FHittableList>();
 
-	auto red = make_shared<FLambertian>(make_shared<FSolidColor>(.65, .05, .05));
-	auto white = make_shared<FLambertian>(make_shared<FSolidColor>(.73, .73, .73));
-	auto green = make_shared<FLambertian>(make_shared<FSolidColor>(.12, .45, .15));
-	auto light = make_shared<FDiffuseLight>(make_shared<FSolidColor>(5, 5, 5));
+	auto red = arena->make<FLambertian>(arena->make<FSolidColor>(.65, .05, .05));
+	auto white = arena->make<FLambertian>(arena->make<FSolidColor>(.73, .73, .73));
+	auto green = arena->make<FLambertian>(arena->make<FSolidColor>(.12, .45, .15));
+	auto light = arena->make<FDiffuseLight>(arena->make<FSolidColor>(5, 5, 5));
 
-	world->add(make_shared<FFlipFace>(make_shared<FYZRect>(0, 555, 0, 555, 555, green)));
-	world->add(make_shared<FYZRect>(0, 555, 0, 555, 0, red));
-	world->add(make_shared<FXZRect>(113, 443, 127, 432, 554, light));
-	world->add(make_shared<FFlipFace>(make_shared<FXZRect>(0, 555, 0, 555, 555, white)));
-	world->add(make_shared<FXZRect>(0, 555, 0, 555, 0, white));
-	world->add(make_shared<FFlipFace>(make_shared<FXYRect>(0, 555, 0, 555, 555, white)));
+	world->add(arena->make<FFlipFace>(arena->make<FYZRect>(0, 555, 0, 555, 555, green)));
+	world->add(arena->make<FYZRect>(0, 555, 0, 555, 0, red));
+	world->add(arena->make<FXZRect>(113, 443, 127, 432, 554, light));
+	world->add(arena->make<FFlipFace>(arena->make<FXZRect>(0, 555, 0, 555, 555, white)));
+	world->add(arena->make<FXZRect>(0, 555, 0, 555, 0, white));
+	world->add(arena->make<FFlipFace>(arena->make<FXYRect>(0, 555, 0, 555, 555, white)));
 
 	// plastic
 	{
-		auto albedo = make_shared<FImageTexture>("Resource/plastic/albedo.png");
-		auto metallic = make_shared<FImageTexture>("Resource/plastic/metallic.png");
-		auto roughness = make_shared<FImageTexture>("Resource/plastic/roughness.png");
+		auto albedo = arena->make<FImageTexture>("Resource/plastic/albedo.png");
+		auto metallic = arena->make<FImageTexture>("Resource/plastic/metallic.png");
+		auto roughness = arena->make<FImageTexture>("Resource/plastic/roughness.png");
 
-		auto pbrmaterial = make_shared<FPbrMaterial>(albedo, metallic, roughness);
+		auto pbrmaterial = arena->make<FPbrMaterial>(albedo, metallic, roughness);
 
-		world->add(make_shared<FSphere>(FPoint3(160, 100, 145), 100, pbrmaterial));
+		world->add(arena->make<FSphere>(FPoint3(160, 100, 145), 100, pbrmaterial));
 
 	}
 
 	// iron
 	{
-		auto albedo = make_shared<FImageTexture>("Resource/rusted_iron/albedo.png");
-		auto metallic = make_shared<FImageTexture>("Resource/rusted_iron/metallic.png");
-		auto roughness = make_shared<FImageTexture>("Resource/rusted_iron/roughness.png");
+		auto albedo = arena->make<FImageTexture>("Resource/rusted_iron/albedo.png");
+		auto metallic = arena->make<FImageTexture>("Resource/rusted_iron/metallic.png");
+		auto roughness = arena->make<FImageTexture>("Resource/rusted_iron/roughness.png");
 
-		auto pbrmaterial = make_shared<FPbrMaterial>(albedo, metallic, roughness);
+		auto pbrmaterial = arena->make<FPbrMaterial>(albedo, metallic, roughness);
 
-		world->add(make_shared<FSphere>(FPoint3(350, 150, 295), 100, pbrmaterial));
+		world->add(arena->make<FSphere>(FPoint3(350, 150, 295), 100, pbrmaterial));
 	}
 
 	return world;
@@ -520,33 +537,293 @@ shared_ptr<FHittable> sample_pbr_metallic_scene(shared_ptr<FRayCamera>& OutCamer
 	auto film_focus = 10.0;
 	OutCamera = make_shared<FPinholeCamera>(lookfrom, lookat, vup, vfov, aspect_ratio, film_focus, 0.0, 0.0);
 	background = FColor3(0.70, 0.80, 1.00);
+	shared_ptr<FSceneArena> arena = make_shared<FSceneArena>();
 
-	shared_ptr<FHittableList> world = make_shared<FHittableList>();
+	shared_ptr<FHittableList> world = arena->make<FHittableList>();
 
-	auto checker = make_shared<FCheckerTexture>(
-		make_shared<FSolidColor>(FColor3(0.2, 0.3, 0.1)),
-		make_shared<FSolidColor>(FColor3(0.9, 0.9, 0.9)));
-	shared_ptr<FMaterial> ground_material = make_shared<FLambertian>(checker);
-	world->add(make_shared<FSphere>(FPoint3(0, -1000, 0), 1000, ground_material));
+	auto checker = arena->make<FCheckerTexture>(
+		arena->make<FSolidColor>(FColor3(0.2, 0.3, 0.1)),
+		arena->make<FSolidColor>(FColor3(0.9, 0.9, 0.9)));
+	shared_ptr<FMaterial> ground_material = arena->make<FLambertian>(checker);
+	world->add(arena->make<FSphere>(FPoint3(0, -1000, 0), 1000, ground_material));
 
 	const int count = 5;
 	for (int a = 0; a < count; a++) 
 	{
 		FVec3 center(0, 0.2, -0.6 * a + 3.0);
 
-		double metal = (double)a / (double)count;
-		double rough = 0.25; // (double)a / (double)count;
+		FReal metal = (FReal)a / (FReal)count;
+		FReal rough = 0.25; // (FReal)a / (FReal)count;
 
-		auto albedo = make_shared<FSolidColor>(FColor3(1.0, 0.78, 0.34));
-		auto metallic = make_shared<FSolidColor>(FColor3(metal, metal, metal));
-		auto roughness = make_shared<FSolidColor>(FColor3(rough, rough, rough));
+		auto albedo = arena->make<FSolidColor>(FColor3(1.0, 0.78, 0.34));
+		auto metallic = arena->make<FSolidColor>(FColor3(metal, metal, metal));
+		auto roughness = arena->make<FSolidColor>(FColor3(rough, rough, rough));
 
-		auto pbrmaterial = make_shared<FPbrMaterial>(albedo, metallic, roughness);
-		world->add(make_shared<FSphere>(center, 0.2, pbrmaterial));
+		auto pbrmaterial = arena->make<FPbrMaterial>(albedo, metallic, roughness);
+		world->add(arena->make<FSphere>(center, 0.2, pbrmaterial));
 	}
 
 	// use bvh
-	shared_ptr<FBVH_Node> bvh = make_shared<FBVH_Node>(*world, 0.0, 1.0);
+	shared_ptr<FBVH_Node> bvh = arena->make<FBVH_Node>(*world, 0.0, 1.0);
 	return bvh;
 }
 
+shared_ptr<FHittable> sample_cornell_mesh(shared_ptr<FRayCamera>& OutCamera, FColor3& background)
+{
+	const auto aspect_ratio = 1.0 / 1.0;
+	const FPoint3 lookfrom(278, 278, -800);
+	const FPoint3 lookat(278, 278, 0);
+	const FVec3 vup(0, 1, 0);
+	auto vfov = 40.0;
+	auto film_focus = 10.0;
+	OutCamera = make_shared<FPinholeCamera>(lookfrom, lookat, vup, vfov, aspect_ratio, film_focus, 0.0, 0.0);
+	background = FColor3(0, 0, 0);
+	shared_ptr<FSceneArena> arena = make_shared<FSceneArena>();
+
+
+	shared_ptr<FHittableList> world = arena->make<FHittableList>();
+
+	auto red = arena->make<FLambertian>(arena->make<FSolidColor>(.65, .05, .05));
+	auto white = arena->make<FLambertian>(arena->make<FSolidColor>(.73, .73, .73));
+	auto green = arena->make<FLambertian>(arena->make<FSolidColor>(.12, .45, .15));
+	auto light = arena->make<FDiffuseLight>(arena->make<FSolidColor>(15, 15, 15));
+
+	world->add(arena->make<FFlipFace>(arena->make<FYZRect>(0, 555, 0, 555, 555, green)));
+	world->add(arena->make<FYZRect>(0, 555, 0, 555, 0, red));
+	world->add(arena->make<FXZRect>(213, 343, 227, 332, 554, light));
+	world->add(arena->make<FFlipFace>(arena->make<FXZRect>(0, 555, 0, 555, 555, white)));
+	world->add(arena->make<FXZRect>(0, 555, 0, 555, 0, white));
+	world->add(arena->make<FFlipFace>(arena->make<FXYRect>(0, 555, 0, 555, 555, white)));
+
+	// torus mesh with shared vertices
+	{
+		const int rings = 64;
+		const int sides = 32;
+		const FReal major_radius = 150;
+		const FReal minor_radius = 60;
+		const FPoint3 center(278, 200, 278);
+
+		auto mesh = arena->make<FTriangleMesh>(arena->make<FLambertian>(arena->make<FImageTexture>("earthmap.jpg")));
+		for (int i = 0; i <= rings; i++) {
+			FReal u = (FReal)i / rings;
+			FReal phi = u * kTwoPi;
+			for (int j = 0; j <= sides; j++) {
+				FReal v = (FReal)j / sides;
+				FReal theta = v * kTwoPi;
+
+				FVec3 normal(cos(phi) * cos(theta), sin(theta), sin(phi) * cos(theta));
+				FVec3 ring(cos(phi) * major_radius, 0, sin(phi) * major_radius);
+				mesh->positions.push_back(center + ring + minor_radius * normal);
+				mesh->normals.push_back(normal);
+				mesh->uvs.push_back(u);
+				mesh->uvs.push_back(v);
+			}
+		}
+
+		for (int i = 0; i < rings; i++) {
+			for (int j = 0; j < sides; j++) {
+				uint32_t a = i * (sides + 1) + j;
+				uint32_t b = a + sides + 1;
+				mesh->indices.insert(mesh->indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+			}
+		}
+		mesh->build();
+
+		world->add(mesh);
+	}
+
+	return world;
+}
+
+// spheres of decreasing roughness reflecting lights of decreasing size and
+// equal power: small lights on rough spheres favour light sampling, large
+// lights on smooth spheres favour bsdf sampling (Veach's mis test)
+shared_ptr<FHittable> sample_glossy_lights(shared_ptr<FRayCamera>& OutCamera, FColor3& background)
+{
+	const auto aspect_ratio = 1.0 / 1.0;
+	const FPoint3 lookfrom(0, 2, 12);
+	const FPoint3 lookat(0, 1, 0);
+	const FVec3 vup(0, 1, 0);
+	auto vfov = 45.0;
+	auto film_focus = 10.0;
+	OutCamera = make_shared<FPinholeCamera>(lookfrom, lookat, vup, vfov, aspect_ratio, film_focus, 0.0, 0.0);
+	background = FColor3(0, 0, 0);
+	shared_ptr<FSceneArena> arena = make_shared<FSceneArena>();
+
+	shared_ptr<FHittableList> world = arena->make<FHittableList>();
+
+	auto ground = arena->make<FLambertian>(arena->make<FSolidColor>(0.4, 0.4, 0.4));
+	world->add(arena->make<FSphere>(FPoint3(0, -1000, 0), 1000, ground));
+
+	const int count = 4;
+	const FReal roughness[count] = { 0.6, 0.3, 0.15, 0.05 };
+	const FReal light_radius[count] = { 0.05, 0.15, 0.45, 1.2 };
+	for (int a = 0; a < count; a++)
+	{
+		const FReal x = 2.4 * (a - (count - 1) * 0.5);
+
+		auto albedo = arena->make<FSolidColor>(FColor3(0.95, 0.95, 0.95));
+		auto metallic = arena->make<FSolidColor>(FColor3(1, 1, 1));
+		auto rough = arena->make<FSolidColor>(FColor3(roughness[a], roughness[a], roughness[a]));
+		world->add(arena->make<FSphere>(FPoint3(x, 1, 0), 1, arena->make<FPbrMaterial>(albedo, metallic, rough)));
+
+		// radiance falls with the area, every light emits the same power
+		const FReal radiance = 1.0 / (light_radius[a] * light_radius[a]);
+		auto light = arena->make<FDiffuseLight>(arena->make<FSolidColor>(radiance, radiance, radiance));
+		world->add(arena->make<FSphere>(FPoint3(x, 7, 6), light_radius[a], light));
+	}
+
+	return world;
+}
+
+// simple light with its two lights replaced by a field of small lamps whose
+// power spans three orders of magnitude, most of them far from the camera
+shared_ptr<FHittable> sample_many_lights(shared_ptr<FRayCamera>& OutCamera, FColor3& background)
+{
+	const auto aspect_ratio = 1.0 / 1.0;
+	const FPoint3 lookfrom(26, 5, 6);
+	const FPoint3 lookat(0, 1, 0);
+	const FVec3 vup(0, 1, 0);
+	auto vfov = 30.0;
+	auto film_focus = 10.0;
+	OutCamera = make_shared<FPinholeCamera>(lookfrom, lookat, vup, vfov, aspect_ratio, film_focus, 0.0, 0.0);
+	background = FColor3(0, 0, 0);
+	shared_ptr<FSceneArena> arena = make_shared<FSceneArena>();
+
+	shared_ptr<FHittableList> world = arena->make<FHittableList>();
+
+	auto noise_texture = arena->make<FNoiseTexture>();
+	shared_ptr<FMaterial> ground_material = arena->make<FLambertian>(noise_texture);
+
+	world->add(arena->make<FSphere>(FPoint3(0, -1000, 0), 1000, ground_material));
+	world->add(arena->make<FSphere>(FPoint3(0, 2, 0), 2, ground_material));
+
+	const int grid = 16;
+	const FReal spacing = 3.2;
+	for (int a = 0; a < grid; a++)
+	{
+		for (int b = 0; b < grid; b++)
+		{
+			const FPoint3 center(spacing * (a - (grid - 1) * 0.5) + random_double(-1, 1), random_double(0.3, 1.5),
+				spacing * (b - (grid - 1) * 0.5) + random_double(-1, 1));
+			if ((center - FPoint3(0, 2, 0)).length() < 2.5)
+				continue;
+
+			// cubed: a few bright lights among many dim ones
+			const FReal u = random_double();
+			const FReal radiance = 2 + 2000 * u * u * u;
+			const FColor3 tint(random_double(0.5, 1), random_double(0.5, 1), random_double(0.5, 1));
+			auto light = arena->make<FDiffuseLight>(arena->make<FSolidColor>(tint * radiance));
+			world->add(arena->make<FXZRect>(center.x() - 0.1, center.x() + 0.1, center.z() - 0.1, center.z() + 0.1, center.y(), light));
+		}
+	}
+
+	shared_ptr<FBVH_Node> bvh = arena->make<FBVH_Node>(*world, 0.0, 1.0);
+	return bvh;
+}
+
+// cornell smoke with a cloud of varying density in place of the two boxes
+shared_ptr<FHittable> sample_cornell_noise_smoke(shared_ptr<FRayCamera>& OutCamera, FColor3& background)
+{
+	return make_cornell_noise_smoke(OutCamera, background, 16);
+}
+
+shared_ptr<FHittable> make_cornell_noise_smoke(shared_ptr<FRayCamera>& OutCamera, FColor3& background, int grid_resolution)
+{
+	const auto aspect_ratio = 1.0 / 1.0;
+	const FPoint3 lookfrom(278, 278, -800);
+	const FPoint3 lookat(278, 278, 0);
+	const FVec3 vup(0, 1, 0);
+	auto vfov = 40.0;
+	auto film_focus = 10.0;
+	OutCamera = make_shared<FPinholeCamera>(lookfrom, lookat, vup, vfov, aspect_ratio, film_focus, 0.0, 0.0);
+	background = FColor3(0, 0, 0);
+	shared_ptr<FSceneArena> arena = make_shared<FSceneArena>();
+
+	shared_ptr<FHittableList> world = arena->make<FHittableList>();
+
+	auto red = arena->make<FLambertian>(arena->make<FSolidColor>(.65, .05, .05));
+	auto white = arena->make<FLambertian>(arena->make<FSolidColor>(.73, .73, .73));
+	auto green = arena->make<FLambertian>(arena->make<FSolidColor>(.12, .45, .15));
+	auto light = arena->make<FDiffuseLight>(arena->make<FSolidColor>(7, 7, 7));
+
+	world->add(arena->make<FFlipFace>(arena->make<FYZRect>(0, 555, 0, 555, 555, green)));
+	world->add(arena->make<FYZRect>(0, 555, 0, 555, 0, red));
+	world->add(arena->make<FXZRect>(113, 443, 127, 432, 554, light));
+	world->add(arena->make<FFlipFace>(arena->make<FXZRect>(0, 555, 0, 555, 555, white)));
+	world->add(arena->make<FXZRect>(0, 555, 0, 555, 0, white));
+	world->add(arena->make<FFlipFace>(arena->make<FXYRect>(0, 555, 0, 555, 555, white)));
+
+	// optical depth up to about 10 across the densest cores, thin elsewhere
+	const FAABB cloud(FPoint3(40, 0, 40), FPoint3(515, 480, 515));
+	world->add(arena->make<FHeterogeneousMedium>(cloud, arena->make<FNoiseTexture>(NOISE_EFFECT_SMOKE), 0.05,
+		arena->make<FSolidColor>(0.9, 0.9, 0.9), grid_resolution));
+
+	return world;
+}
+
+// small emissive spheres mixed into a field of diffuse ones under a bvh,
+// whose leaves pack the diffuse ones into sphere sets
+shared_ptr<FHittable> sample_sphere_lights(shared_ptr<FRayCamera>& OutCamera, FColor3& background)
+{
+	const auto aspect_ratio = 1.0 / 1.0;
+	const FPoint3 lookfrom(13, 4, 3);
+	const FPoint3 lookat(0, 0.5, 0);
+	const FVec3 vup(0, 1, 0);
+	auto vfov = 30.0;
+	auto film_focus = 10.0;
+	OutCamera = make_shared<FPinholeCamera>(lookfrom, lookat, vup, vfov, aspect_ratio, film_focus, 0.0, 0.0);
+	background = FColor3(0, 0, 0);
+	shared_ptr<FSceneArena> arena = make_shared<FSceneArena>();
+
+	shared_ptr<FHittableList> world = arena->make<FHittableList>();
+
+	auto ground = arena->make<FLambertian>(arena->make<FSolidColor>(0.5, 0.5, 0.5));
+	world->add(arena->make<FSphere>(FPoint3(0, -1000, 0), 1000, ground));
+
+	for (int a = -5; a < 5; a++)
+	{
+		for (int b = -5; b < 5; b++)
+		{
+			const FPoint3 center(a + 0.9 * random_double(), 0.2, b + 0.9 * random_double());
+			if ((a + b) % 4 == 0)
+			{
+				const FColor3 tint(random_double(0.5, 1), random_double(0.5, 1), random_double(0.5, 1));
+				auto light = arena->make<FDiffuseLight>(arena->make<FSolidColor>(tint * 20));
+				world->add(arena->make<FSphere>(center + FVec3(0, 0.4, 0), 0.08, light));
+			}
+			else
+			{
+				auto albedo = arena->make<FSolidColor>(FColor3::random() * FColor3::random());
+				world->add(arena->make<FSphere>(center, 0.2, arena->make<FLambertian>(albedo)));
+			}
+		}
+	}
+
+	shared_ptr<FBVH_Node> bvh = arena->make<FBVH_Node>(*world, 0.0, 1.0);
+	return bvh;
+}
+
+// all examples
+FExampleDesc examples[] = {
+	{ "random scen", sample_random_scene},
+	{ "two spheres", sample_two_spheres},
+	{ "perlin spheres", sample_two_perlin_spheres},
+	{ "worley spheres", sample_two_worley_spheres},
+	{ "earth", sample_earth },
+	{ "simple light", sample_simple_light},
+	{ "cornell box", sample_cornell_box },
+	{ "cornell ball", sample_cornell_ball },
+	{ "cornell smoke", sample_cornell_smoke },
+	{ "cornell final", sample_cornell_final },
+	{ "final scene", sample_final_scene },
+	{ "pbr sphere scene", sample_pbr_sphere_scene },
+	{ "pbr metallic scene", sample_pbr_metallic_scene},
+	{ "cornell mesh", sample_cornell_mesh },
+	{ "glossy lights", sample_glossy_lights },
+	{ "many lights", sample_many_lights },
+	{ "cornell noise smoke", sample_cornell_noise_smoke },
+	{ "sphere lights", sample_sphere_lights }
+};
+
+const int num_examples = sizeof(examples) / sizeof(examples[0]);
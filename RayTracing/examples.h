@@ -24,4 +24,20 @@ shared_ptr<FHittable> sample_cornell_smoke(shared_ptr<FRayCamera>& OutCamera, FC
 shared_ptr<FHittable> sample_cornell_final(shared_ptr<FRayCamera>& OutCamera, FColor3& background);
 shared_ptr<FHittable> sample_final_scene(shared_ptr<FRayCamera>& OutCamera, FColor3& background);
 shared_ptr<FHittable> sample_pbr_sphere_scene(shared_ptr<FRayCamera>& OutCamera, FColor3& background);
-shared_ptr<FHittable> sample_pbr_metallic_scene(shared_ptr<FRayCamera>& OutCamera, FColor3& background);
\ No newline at end of file
+shared_ptr<FHittable> sample_pbr_metallic_scene(shared_ptr<FRayCamera>& OutCamera, FColor3& background);
+shared_ptr<FHittable> sample_cornell_mesh(shared_ptr<FRayCamera>& OutCamera, FColor3& background);
+shared_ptr<FHittable> sample_glossy_lights(shared_ptr<FRayCamera>& OutCamera, FColor3& background);
+shared_ptr<FHittable> sample_many_lights(shared_ptr<FRayCamera>& OutCamera, FColor3& background);
+shared_ptr<FHittable> sample_cornell_noise_smoke(shared_ptr<FRayCamera>& OutCamera, FColor3& background);
+shared_ptr<FHittable> sample_sphere_lights(shared_ptr<FRayCamera>& OutCamera, FColor3& background);
+// cornell noise smoke with the majorant grid of its medium at grid_resolution^3 cells
+shared_ptr<FHittable> make_cornell_noise_smoke(shared_ptr<FRayCamera>& OutCamera, FColor3& background, int grid_resolution);
+
+// all examples
+struct FExampleDesc{
+	const char* _name;
+	ExampleFuncPtr _funcptr;
+};
+
+extern FExampleDesc examples[];
+extern const int num_examples;
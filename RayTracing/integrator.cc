@@ -0,0 +1,650 @@
+// integrators
+//
+//
+
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+#include "integrator.h"
+#include "sampler.h"
+#include "material.h"
+#include "light_list.h"
+#include "environment.h"
+
+
+static FColor3 kBlack(0, 0, 0);
+static FColor3 kWhite(1, 1, 1);
+static FColor3 kSkyblue(0.5, 0.7, 1.0);
+
+// radiance leaving the hit rec along -ray, bounces on with ray_color
+static FColor3 shade(const FRay& ray, const FHitRecord& rec, const FBackground& background, FHittable& world, int depth)
+{
+	FRay scattered;
+	FColor3 attenuation;
+	FColor3 emitted = material_emitted(*rec.mat_ptr, rec.u, rec.v, rec.p);
+
+	if (!material_scatter(*rec.mat_ptr, ray, rec, attenuation, scattered))
+	{
+		return emitted;
+	}
+
+	return emitted + attenuation * ray_color(scattered, background, world, depth - 1);
+}
+
+// aovs of where the primary ray ends, rec is nullptr on a miss. prim is the
+// primitive hit, before instances resolved it
+static inline void record_first_hit(FPathAovs* aovs, const FRay& ray, const FHitRecord* rec, const FHittable* prim)
+{
+	if (!aovs)
+		return;
+
+	if (!rec)
+	{
+		*aovs = FPathAovs();
+		return;
+	}
+	aovs->albedo = rec->mat_ptr->base_color(*rec);
+	aovs->normal = rec->normal;
+	aovs->depth = rec->t * ray.Direction().length();
+	aovs->material = rec->mat_ptr;
+	aovs->object = prim;
+}
+
+FColor3 ray_color(const FRay& primary, const FBackground& background, FHittable& world, int depth, FBounceStats* stats, FPathAovs* aovs)
+{
+	// L = e0 + a0 * (e1 + a1 * (e2 + ...)), accumulated front to back
+	FColor3 radiance(0, 0, 0);
+	FColor3 throughput(1, 1, 1);
+	FRay ray = primary;
+
+	bool direct_recorded = false;
+
+	// after depth bounces no more light is gathered
+	for (int bounce = 0; ; bounce++)
+	{
+		// light found from the second bounce on is indirect
+		if (bounce == 2 && aovs)
+		{
+			aovs->direct = radiance;
+			direct_recorded = true;
+		}
+		if (bounce >= depth)
+		{
+			if (stats) stats->count(bounce, EPathEvent::MaxDepth);
+			break;
+		}
+		start_bounce_dimensions(bounce);
+
+		FHitRecord rec;
+		if (!world.intersect(ray, 0.001, kInfinity, rec))
+		{
+			if (stats) stats->count(bounce, EPathEvent::Miss);
+			if (bounce == 0) record_first_hit(aovs, ray, nullptr, nullptr);
+			radiance += throughput * background.eval(ray.Direction());
+			break;
+		}
+
+		const FHittable* prim = rec.obj_ptr;
+		FHittable::resolve_surface(ray, rec);
+		if (bounce == 0) record_first_hit(aovs, ray, &rec, prim);
+
+		FRay scattered;
+		FColor3 attenuation;
+		radiance += throughput * material_emitted(*rec.mat_ptr, rec.u, rec.v, rec.p);
+
+		if (!material_scatter(*rec.mat_ptr, ray, rec, attenuation, scattered))
+		{
+			if (stats) stats->count(bounce, EPathEvent::Absorbed);
+			break;
+		}
+
+		if (stats) stats->count(bounce, EPathEvent::Scattered);
+		throughput = throughput * attenuation;
+		ray = scattered;
+	}
+
+	if (aovs && !direct_recorded) aovs->direct = radiance;
+	return radiance;
+}
+
+// russian roulette after bounce: false ends the path, a surviving path is
+// weighted up by the survival probability
+static inline bool survive_roulette(const FRoulette& roulette, int bounce, FColor3& throughput)
+{
+	const FReal q = roulette.survival_probability(bounce, throughput);
+	if (q < 1 && sample_1d() >= q)
+		return false;
+
+	throughput = throughput / q;
+	return true;
+}
+
+// monte-carlo path from primary, primary_hit is its hit when a packet trace
+// found it already
+static FColor3 montecarlo_path(const FRay& primary, const FHitRecord* primary_hit, const FBackground& background, FHittable& world, const FRoulette& roulette, FBounceStats* stats, FPathAovs* aovs)
+{
+	FColor3 radiance(0, 0, 0);
+	FColor3 throughput(1, 1, 1);
+	FRay ray = primary;
+	bool direct_recorded = false;
+
+	for (int bounce = 0; ; bounce++)
+	{
+		// light found from the second bounce on is indirect
+		if (bounce == 2 && aovs)
+		{
+			aovs->direct = radiance;
+			direct_recorded = true;
+		}
+		if (bounce >= roulette.max_depth)
+		{
+			if (stats) stats->count(bounce, EPathEvent::MaxDepth);
+			break;
+		}
+		start_bounce_dimensions(bounce);
+
+		FHitRecord rec;
+		const FHittable* prim = nullptr;  // not known for a hit handed in
+		if (bounce == 0 && primary_hit)
+		{
+			rec = *primary_hit;
+		}
+		else if (world.intersect(ray, 0.001, kInfinity, rec))
+		{
+			prim = rec.obj_ptr;
+			FHittable::resolve_surface(ray, rec);
+		}
+		else
+		{
+			if (stats) stats->count(bounce, EPathEvent::Miss);
+			if (bounce == 0) record_first_hit(aovs, ray, nullptr, nullptr);
+			radiance += throughput * background.eval(ray.Direction());
+			break;
+		}
+		if (bounce == 0) record_first_hit(aovs, ray, &rec, prim);
+
+		FRay scattered;
+		FColor3 attenuation;
+		radiance += throughput * material_emitted(*rec.mat_ptr, rec.u, rec.v, rec.p);
+
+		if (!material_scatter(*rec.mat_ptr, ray, rec, attenuation, scattered))
+		{
+			if (stats) stats->count(bounce, EPathEvent::Absorbed);
+			break;
+		}
+
+		throughput = throughput * attenuation;
+		if (!survive_roulette(roulette, bounce, throughput))
+		{
+			if (stats) stats->count(bounce, EPathEvent::Roulette);
+			break;
+		}
+
+		if (stats) stats->count(bounce, EPathEvent::Scattered);
+		ray = scattered;
+	}
+
+	if (aovs && !direct_recorded) aovs->direct = radiance;
+	return radiance;
+}
+
+// monte-carlo path trace
+FColor3 ray_color_montecarlo(const FRay& primary, const FBackground& background, FHittable& world, const FRoulette& roulette, FBounceStats* stats, FPathAovs* aovs)
+{
+	return montecarlo_path(primary, nullptr, background, world, roulette, stats, aovs);
+}
+
+// power heuristic (beta = 2) weight of a sample drawn with pdf_a, against one strategy with pdf_b
+static inline FReal power_heuristic(FReal pdf_a, FReal pdf_b)
+{
+	const FReal a2 = pdf_a * pdf_a;
+	const FReal b2 = pdf_b * pdf_b;
+	return a2 / (a2 + b2);
+}
+
+// fraction of light passing shadow up to t_max: 0 behind anything opaque,
+// what the media in between let through otherwise
+static FReal shadow_transmittance(FHittable& world, const FRay& shadow, FReal t_max)
+{
+	FReal transmittance = 1;
+	return world.occluded(shadow, 0.001, t_max, transmittance) ? FReal(0) : transmittance;
+}
+
+// cosine of wi at the hit, 1 at a scattering point in a medium (zero normal)
+static FReal light_cosine(const FHitRecord& rec, const FVec3& wi)
+{
+	return rec.normal.length2() > 0 ? dot(rec.normal, wi) : FReal(1);
+}
+
+// sample_light() when the environment was picked, with pick_pdf
+static FColor3 sample_environment(const FRay& ray, const FHitRecord& rec, FHittable& world, const FEnvironment& environment, FReal pick_pdf, bool mis)
+{
+	FReal u0, u1;
+	sample_2d(u0, u1);
+	FReal environment_pdf;
+	const FVec3 wi = environment.sample(u0, u1, environment_pdf);
+	const FReal cosine = light_cosine(rec, wi);
+	const FReal light_pdf = environment_pdf * pick_pdf;
+	if (cosine <= 0 || light_pdf <= 0)
+		return kBlack;
+
+	// the environment lies beyond everything
+	const FRay shadow = rec.spawn_ray(wi, ray.Time());
+	const FReal transmittance = shadow_transmittance(world, shadow, kInfinity);
+	if (transmittance <= 0)
+		return kBlack;
+
+	const FColor3 Le = environment.eval(wi);
+	const FVec3 wo = -unit_vector(ray.Direction());
+	const FColor3 brdf = material_eval(*rec.mat_ptr, wo, wi, rec);
+	const FReal weight = mis ? power_heuristic(light_pdf, material_pdf(*rec.mat_ptr, wo, wi, rec)) : 1.0;
+	return brdf * Le * (cosine * weight * transmittance / light_pdf);
+}
+
+// direct light at a non-specular hit from one light picked by the list's strategy
+// mis: weight it against bsdf sampling of the same direction
+static FColor3 sample_light(const FRay& ray, const FHitRecord& rec, FHittable& world, const FLightList& lights, bool mis = false)
+{
+	FReal pick_pdf;
+	const FHittable* light = lights.pick(rec.p, rec.normal, pick_pdf);
+	if (!light)
+		return sample_environment(ray, rec, world, *lights.environment_light(), pick_pdf, mis);
+
+	const FVec3 dir = light->random(rec.p);
+	const FVec3 wi = unit_vector(dir);
+	const FReal cosine = light_cosine(rec, wi);
+	if (cosine <= 0)
+		return kBlack;
+
+	const FRay shadow = rec.spawn_ray(dir, ray.Time());
+	FHitRecord light_rec;
+	if (!light->intersect(shadow, 0.001, kInfinity, light_rec))
+		return kBlack;
+
+	const FReal light_pdf = light->pdf_value(shadow.Origin(), dir) * pick_pdf;
+	if (light_pdf <= 0)
+		return kBlack;
+
+	// anything in front of the light, which itself lies at light_rec.t
+	const FReal transmittance = shadow_transmittance(world, shadow, light_rec.t * (1 - 1e-4));
+	if (transmittance <= 0)
+		return kBlack;
+
+	FHittable::resolve_surface(shadow, light_rec);
+	const FColor3 Le = material_emitted(*light_rec.mat_ptr, light_rec.u, light_rec.v, light_rec.p);
+	const FVec3 wo = -unit_vector(ray.Direction());
+	const FColor3 brdf = material_eval(*rec.mat_ptr, wo, wi, rec);
+	const FReal weight = mis ? power_heuristic(light_pdf, material_pdf(*rec.mat_ptr, wo, wi, rec)) : 1.0;
+	return brdf * Le * (cosine * weight * transmittance / light_pdf);
+}
+
+FColor3 ray_color_nee(const FRay& primary, const FBackground& background, FHittable& world, const FLightList& lights, const FRoulette& roulette, FBounceStats* stats, FPathAovs* aovs)
+{
+	FColor3 radiance(0, 0, 0);
+	FColor3 throughput(1, 1, 1);
+	FRay ray = primary;
+	bool sampled_lights = false;  // the previous hit gathered direct light
+	bool direct_recorded = false;
+
+	for (int bounce = 0; ; bounce++)
+	{
+		if (bounce >= roulette.max_depth)
+		{
+			if (stats) stats->count(bounce, EPathEvent::MaxDepth);
+			break;
+		}
+		start_bounce_dimensions(bounce);
+
+		FHitRecord rec;
+		if (!world.intersect(ray, 0.001, kInfinity, rec))
+		{
+			if (stats) stats->count(bounce, EPathEvent::Miss);
+			if (bounce == 0) record_first_hit(aovs, ray, nullptr, nullptr);
+			// a sampled environment was gathered at the previous hit already
+			if (!(sampled_lights && lights.environment_light()))
+				radiance += throughput * background.eval(ray.Direction());
+			break;
+		}
+
+		const FHittable* prim = rec.obj_ptr;
+		FHittable::resolve_surface(ray, rec);
+		if (bounce == 0) record_first_hit(aovs, ray, &rec, prim);
+
+		// a listed light reached by a bounce ray was sampled at the previous hit already
+		if (!(sampled_lights && lights.contains(prim)))
+		{
+			radiance += throughput * material_emitted(*rec.mat_ptr, rec.u, rec.v, rec.p);
+		}
+
+		FBsdfSample bs;
+		if (!material_sample(*rec.mat_ptr, -unit_vector(ray.Direction()), rec, bs))
+		{
+			if (stats) stats->count(bounce, EPathEvent::Absorbed);
+			break;
+		}
+
+		// needs eval(), materials without a pdf are left to the bounce ray
+		sampled_lights = !lights.empty() && !bs.specular && bs.pdf > 0;
+		// light sampled from the second hit on is indirect
+		if (bounce == 1 && aovs)
+		{
+			aovs->direct = radiance;
+			direct_recorded = true;
+		}
+		if (sampled_lights)
+		{
+			radiance += throughput * sample_light(ray, rec, world, lights);
+		}
+
+		throughput = throughput * bs.weight;
+		if (!survive_roulette(roulette, bounce, throughput))
+		{
+			if (stats) stats->count(bounce, EPathEvent::Roulette);
+			break;
+		}
+
+		if (stats) stats->count(bounce, EPathEvent::Scattered);
+		ray = rec.spawn_ray(bs.wi, ray.Time());
+	}
+
+	if (aovs && !direct_recorded) aovs->direct = radiance;
+	return radiance;
+}
+
+FColor3 ray_color_mis(const FRay& primary, const FBackground& background, FHittable& world, const FLightList& lights, const FRoulette& roulette, FBounceStats* stats, FPathAovs* aovs)
+{
+	FColor3 radiance(0, 0, 0);
+	FColor3 throughput(1, 1, 1);
+	FRay ray = primary;
+	bool sampled_lights = false;  // the previous hit gathered direct light
+	bool direct_recorded = false;
+	FReal bsdf_pdf = 0;           // pdf of the bounce ray from the previous hit
+	FPoint3 prev_p;               // where the previous hit picked its light
+	FVec3 prev_normal;
+
+	for (int bounce = 0; ; bounce++)
+	{
+		if (bounce >= roulette.max_depth)
+		{
+			if (stats) stats->count(bounce, EPathEvent::MaxDepth);
+			break;
+		}
+		start_bounce_dimensions(bounce);
+
+		FHitRecord rec;
+		if (!world.intersect(ray, 0.001, kInfinity, rec))
+		{
+			if (stats) stats->count(bounce, EPathEvent::Miss);
+			if (bounce == 0) record_first_hit(aovs, ray, nullptr, nullptr);
+			if (sampled_lights && lights.environment_light())
+			{
+				const FReal light_pdf = lights.environment_light()->pdf(ray.Direction()) * lights.environment_pdf();
+				radiance += throughput * background.eval(ray.Direction()) * power_heuristic(bsdf_pdf, light_pdf);
+			}
+			else
+			{
+				radiance += throughput * background.eval(ray.Direction());
+			}
+			break;
+		}
+
+		const FHittable* prim = rec.obj_ptr;
+		FHittable::resolve_surface(ray, rec);
+		if (bounce == 0) record_first_hit(aovs, ray, &rec, prim);
+
+		// a listed light reached by a bounce ray could also have been sampled
+		// at the previous hit, each strategy keeps its share
+		const FColor3 emitted = material_emitted(*rec.mat_ptr, rec.u, rec.v, rec.p);
+		if (sampled_lights && lights.contains(prim))
+		{
+			const FReal light_pdf = prim->pdf_value(ray.Origin(), ray.Direction()) * lights.pick_pdf(prim, prev_p, prev_normal);
+			radiance += throughput * emitted * power_heuristic(bsdf_pdf, light_pdf);
+		}
+		else
+		{
+			radiance += throughput * emitted;
+		}
+
+		FBsdfSample bs;
+		if (!material_sample(*rec.mat_ptr, -unit_vector(ray.Direction()), rec, bs))
+		{
+			if (stats) stats->count(bounce, EPathEvent::Absorbed);
+			break;
+		}
+
+		sampled_lights = !lights.empty() && !bs.specular && bs.pdf > 0;
+		// light sampled from the second hit on is indirect
+		if (bounce == 1 && aovs)
+		{
+			aovs->direct = radiance;
+			direct_recorded = true;
+		}
+		if (sampled_lights)
+		{
+			radiance += throughput * sample_light(ray, rec, world, lights, true);
+		}
+
+		throughput = throughput * bs.weight;
+		if (!survive_roulette(roulette, bounce, throughput))
+		{
+			if (stats) stats->count(bounce, EPathEvent::Roulette);
+			break;
+		}
+
+		if (stats) stats->count(bounce, EPathEvent::Scattered);
+		bsdf_pdf = bs.pdf;
+		prev_p = rec.p;
+		prev_normal = rec.normal;
+		ray = rec.spawn_ray(bs.wi, ray.Time());
+	}
+
+	if (aovs && !direct_recorded) aovs->direct = radiance;
+	return radiance;
+}
+
+uint64_t FBounceStats::paths() const
+{
+	uint64_t n = 0;
+	for (int bounce = 0; bounce < kMaxBounces; bounce++)
+	{
+		n += events[bounce][(int)EPathEvent::Miss] + events[bounce][(int)EPathEvent::Absorbed]
+			+ events[bounce][(int)EPathEvent::Roulette] + events[bounce][(int)EPathEvent::MaxDepth];
+	}
+	return n;
+}
+
+void FBounceStats::path_length(double& mean, double& variance) const
+{
+	// a path ending at bounce b traced b + 1 rays, b when cut at the maximum depth
+	double sum = 0.0, sum2 = 0.0;
+	for (int bounce = 0; bounce < kMaxBounces; bounce++)
+	{
+		const double ended = double(events[bounce][(int)EPathEvent::Miss] + events[bounce][(int)EPathEvent::Absorbed]
+			+ events[bounce][(int)EPathEvent::Roulette]);
+		const double cut = double(events[bounce][(int)EPathEvent::MaxDepth]);
+		sum += ended * (bounce + 1) + cut * bounce;
+		sum2 += ended * (bounce + 1) * (bounce + 1) + cut * bounce * bounce;
+	}
+
+	const double n = double(paths());
+	mean = n > 0 ? sum / n : 0.0;
+	variance = n > 0 ? sum2 / n - mean * mean : 0.0;
+}
+
+void FBounceStats::print(std::ostream& out) const
+{
+	static const char* kEventNames[(int)EPathEvent::Count] = { "scattered", "miss", "absorbed", "roulette", "max depth" };
+
+	int last = kMaxBounces - 1;
+	while (last > 0)
+	{
+		uint64_t n = 0;
+		for (int e = 0; e < (int)EPathEvent::Count; e++) n += events[last][e];
+		if (n != 0)
+			break;
+		last--;
+	}
+
+	out << "bounce";
+	for (const char* name : kEventNames) out << "\t" << name;
+	out << "\n";
+	for (int bounce = 0; bounce <= last; bounce++)
+	{
+		out << bounce << (bounce == kMaxBounces - 1 ? "+" : "");
+		for (int e = 0; e < (int)EPathEvent::Count; e++) out << "\t" << events[bounce][e];
+		out << "\n";
+	}
+
+	double mean, variance;
+	path_length(mean, variance);
+	out << "paths " << paths() << ", rays per path: mean " << mean << ", variance " << variance << "\n";
+}
+
+// closest hits of the packet rays with their surfaces evaluated
+static uint32_t trace_packet(const FRayPacket& packet, FHittable& world, FHitRecord* recs)
+{
+	FReal t_max[kPacketSize];
+	for (int i = 0; i < kPacketSize; i++) t_max[i] = kInfinity;
+
+	const uint32_t hits = world.intersect_packet(packet, 0.001, t_max, recs);
+	for (int i = 0; i < packet.count; i++)
+	{
+		if (hits & (1u << i))
+		{
+			FHittable::resolve_surface(packet.rays[i], recs[i]);
+		}
+	}
+	return hits;
+}
+
+void ray_color_packet(const FRayPacket& packet, const FBackground& background, FHittable& world, int depth, FColor3* colors)
+{
+	if (depth <= 0)
+	{
+		for (int i = 0; i < packet.count; i++) colors[i] = kBlack;
+		return;
+	}
+
+	FHitRecord recs[kPacketSize];
+	const uint32_t hits = trace_packet(packet, world, recs);
+	for (int i = 0; i < packet.count; i++)
+	{
+		colors[i] = (hits & (1u << i)) ? shade(packet.rays[i], recs[i], background, world, depth) : background.eval(packet.rays[i].Direction());
+	}
+}
+
+void ray_color_montecarlo_packet(const FRayPacket& packet, const FBackground& background, FHittable& world, const FRoulette& roulette, FColor3* colors)
+{
+	FHitRecord recs[kPacketSize];
+	const uint32_t hits = trace_packet(packet, world, recs);
+	for (int i = 0; i < packet.count; i++)
+	{
+		colors[i] = (hits & (1u << i)) ? montecarlo_path(packet.rays[i], &recs[i], background, world, roulette, nullptr, nullptr) : background.eval(packet.rays[i].Direction());
+	}
+}
+
+// paths per wave
+static const size_t kWaveSize = 1 << 14;
+
+struct FPathState
+{
+	FRay	ray;
+	FColor3	throughput;
+	int		pixel;
+};
+
+void render_wavefront(const FRayCamera& camera, const FBackground& background, FHittable& world, int depth,
+	int width, int height, int samples_per_pixel, FColor3* framebuffer)
+{
+	const size_t num_paths = (size_t)width * height * samples_per_pixel;
+
+	std::vector<FPathState> paths, next_paths;
+	std::vector<FHitRecord> recs;
+	std::vector<uint32_t> order, keys, offsets, sorted;
+	std::unordered_map<const FMaterial*, uint32_t> material_slot;
+	paths.reserve(kWaveSize);
+	next_paths.reserve(kWaveSize);
+	recs.resize(kWaveSize);
+	order.reserve(kWaveSize);
+	sorted.reserve(kWaveSize);
+	keys.reserve(kWaveSize);
+
+	int reported_row = -1;
+	for (size_t first = 0; first < num_paths; first += kWaveSize)
+	{
+		const int row = (int)(first / ((size_t)width * samples_per_pixel));
+		if (row != reported_row)
+		{
+			std::cerr << "\rScanlines remaining: " << height - row << ' ' << std::flush;
+			reported_row = row;
+		}
+
+		// generate: consecutive paths are samples of the same pixel, scanline by scanline
+		const size_t last = std::min(first + kWaveSize, num_paths);
+		paths.clear();
+		for (size_t n = first; n < last; n++)
+		{
+			const int pixel = (int)(n / samples_per_pixel);
+			const int i = pixel % width;
+			const int j = pixel / width;
+			auto u = (i + random_double()) / (width - 1);
+			auto v = (j + random_double()) / (height - 1);
+
+			paths.push_back({ camera.castRay(u, v), FColor3(1, 1, 1), pixel });
+		}
+
+		for (int bounce = 0; bounce < depth && !paths.empty(); bounce++)
+		{
+			// intersect: misses see the background and end
+			order.clear();
+			for (uint32_t k = 0; k < paths.size(); k++)
+			{
+				FPathState& path = paths[k];
+				if (world.hit(path.ray, 0.001, kInfinity, recs[k]))
+				{
+					order.push_back(k);
+				}
+				else
+				{
+					framebuffer[path.pixel] += path.throughput * background.eval(path.ray.Direction());
+				}
+			}
+
+			// sort: counting sort on the material, hits on one material are
+			// shaded together and keep their path order
+			material_slot.clear();
+			keys.resize(order.size());
+			for (size_t n = 0; n < order.size(); n++)
+			{
+				auto slot = material_slot.emplace(recs[order[n]].mat_ptr, (uint32_t)material_slot.size());
+				keys[n] = slot.first->second;
+			}
+			offsets.assign(material_slot.size() + 1, 0);
+			for (uint32_t key : keys) offsets[key + 1]++;
+			for (size_t m = 1; m < offsets.size(); m++) offsets[m] += offsets[m - 1];
+			sorted.resize(order.size());
+			for (size_t n = 0; n < order.size(); n++)
+			{
+				sorted[offsets[keys[n]]++] = order[n];
+			}
+
+			// shade + compact: surviving paths are enqueued for the next bounce
+			next_paths.clear();
+			for (uint32_t k : sorted)
+			{
+				const FPathState& path = paths[k];
+				const FHitRecord& rec = recs[k];
+
+				FRay scattered;
+				FColor3 attenuation;
+				framebuffer[path.pixel] += path.throughput * material_emitted(*rec.mat_ptr, rec.u, rec.v, rec.p);
+				if (material_scatter(*rec.mat_ptr, path.ray, rec, attenuation, scattered))
+				{
+					next_paths.push_back({ scattered, path.throughput * attenuation, path.pixel });
+				}
+			}
+			std::swap(paths, next_paths);
+		}
+	}
+}
@@ -0,0 +1,106 @@
+// integrators
+//
+//
+
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include "basic.h"
+#include "vec3.h"
+#include "color.h"
+#include "ray.h"
+#include "hittable.h"
+#include "camera.h"
+#include "environment.h"
+#include "aov.h"
+
+class FLightList;
+
+
+// how a path segment ended
+enum class EPathEvent
+{
+	Scattered,  // the path continues
+	Miss,       // left the scene, background gathered
+	Absorbed,   // hit a surface that does not scatter (lights)
+	Roulette,   // killed by russian roulette
+	MaxDepth,   // cut at the maximum depth, counted at the bounce that is not traced
+	Count,
+};
+
+// per bounce path statistics of the integrators
+struct FBounceStats
+{
+	static const int kMaxBounces = 64;  // deeper bounces are counted in the last row
+
+	uint64_t events[kMaxBounces][(int)EPathEvent::Count] = {};
+
+	void count(int bounce, EPathEvent e)
+	{
+		events[bounce < kMaxBounces ? bounce : kMaxBounces - 1][(int)e]++;
+	}
+
+	// paths and their length in traced rays
+	uint64_t paths() const;
+	void path_length(double& mean, double& variance) const;
+
+	void print(std::ostream& out) const;
+};
+
+// russian roulette of the monte carlo integrators: the first min_depth
+// bounces always continue, later a path survives with the luminance of its
+// throughput, capped at survival, and is weighted up when it does. dim paths
+// stop early and bright ones keep going. no path is traced past max_depth
+// bounces, which cuts off the little energy left that deep
+struct FRoulette
+{
+	int		min_depth = 3;
+	int		max_depth = 64;
+	FReal	survival = 0.95;
+	bool	throughput = true;  // false: fixed survival probability from the first bounce
+
+	// probability q of continuing after bounce with the given throughput. at
+	// most 1: a path that always survives but is divided by q > 1 is darkened
+	FReal survival_probability(int bounce, const FColor3& path_throughput) const
+	{
+		if (!throughput)
+			return std::min<FReal>(survival, 1.0);
+		if (bounce < min_depth)
+			return 1.0;
+		return std::min<FReal>(std::min(survival, luminance(path_throughput)), 1.0);
+	}
+};
+
+// the path tracers below fill aovs when given one, the denoiser guides among them
+
+// ray tracing, stops after depth bounces
+// iterative: radiance and throughput are carried along the path
+FColor3 ray_color(const FRay& ray, const FBackground& background, FHittable& world, int depth, FBounceStats* stats = nullptr, FPathAovs* aovs = nullptr);
+
+// monte-carlo path trace, paths end by russian roulette
+FColor3 ray_color_montecarlo(const FRay& ray, const FBackground& background, FHittable& world, const FRoulette& roulette, FBounceStats* stats = nullptr, FPathAovs* aovs = nullptr);
+
+// monte-carlo path trace with next event estimation: every non-specular hit
+// also samples one light of lights through a shadow ray, and a listed light
+// reached by the bounce ray from such a hit is not counted again
+FColor3 ray_color_nee(const FRay& ray, const FBackground& background, FHittable& world, const FLightList& lights, const FRoulette& roulette, FBounceStats* stats = nullptr, FPathAovs* aovs = nullptr);
+
+// monte-carlo path trace combining light sampling and bsdf sampling with
+// multiple importance sampling (power heuristic): lights reachable from a
+// non-specular hit are sampled directly and found by the bounce ray, both
+// estimates are weighted by their pdfs. specular hits only use the bounce ray
+FColor3 ray_color_mis(const FRay& ray, const FBackground& background, FHittable& world, const FLightList& lights, const FRoulette& roulette, FBounceStats* stats = nullptr, FPathAovs* aovs = nullptr);
+
+// packet versions: the primary rays of the packet are traced together, every
+// path then continues on its own. colors has packet.count entries
+void ray_color_packet(const FRayPacket& packet, const FBackground& background, FHittable& world, int depth, FColor3* colors);
+void ray_color_montecarlo_packet(const FRayPacket& packet, const FBackground& background, FHittable& world, const FRoulette& roulette, FColor3* colors);
+
+// wavefront path trace, same estimator as ray_color
+// a wave of paths is advanced one bounce at a time: intersect all of them,
+// sort the hits by material, shade them in that order and compact the
+// surviving paths for the next bounce. adds samples_per_pixel samples per
+// pixel into framebuffer (row j at j * width)
+void render_wavefront(const FRayCamera& camera, const FBackground& background, FHittable& world, int depth,
+	int width, int height, int samples_per_pixel, FColor3* framebuffer);
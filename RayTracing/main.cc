@@ -3,105 +3,150 @@
 //
 
 #include <iostream>
+#include <cstring>
+#include <vector>
+#include <functional>
 #include "basic.h"
 #include "timer.h"
 #include "color.h"
 #include "hittable.h"
+#include "compiled_scene.h"
+#include "light_list.h"
+#include "environment.h"
+#include "sampler.h"
+#include "denoiser.h"
+#include "aov.h"
 #include "material.h"
 #include "examples.h"
+#include "integrator.h"
+#include "benchmarks.h"
 
 
-// all examples
-struct FExampleDesc{
-	const char* _name;
-	ExampleFuncPtr _funcptr;
-};
-
-FExampleDesc examples[] = {
-	{ "random scen", sample_random_scene},
-	{ "two spheres", sample_two_spheres},
-	{ "perlin spheres", sample_two_perlin_spheres},
-	{ "worley spheres", sample_two_worley_spheres},
-	{ "earth", sample_earth },
-	{ "simple light", sample_simple_light},
-	{ "cornell box", sample_cornell_box },
-	{ "cornell ball", sample_cornell_ball },
-	{ "cornell smoke", sample_cornell_smoke },
-	{ "cornell final", sample_cornell_final },
-	{ "final scene", sample_final_scene },
-	{ "pbr sphere scene", sample_pbr_sphere_scene },
-	{ "pbr metallic scene", sample_pbr_metallic_scene}
-};
-
-static FColor3 kBlack(0, 0, 0);
-static FColor3 kWhite(1, 1, 1);
-static FColor3 kSkyblue(0.5, 0.7, 1.0);
-
-FColor3 ray_color(const FRay& ray, const FColor3& background, FHittable& world, int depth)
+void display_usage()
 {
-	FHitRecord rec;
-
-	// if we have exceeded the ray bounce limit, no more light is gathered
-	if (depth <= 0)
+	std::cerr << "Usage:  program.exe sceneId  methodId > filename.ppm" << std::endl;
+	std::cerr << "   methodId: 0 recursive, 1 monte carlo, 2 wavefront, 3 monte carlo with light sampling," << std::endl;
+	std::cerr << "             4 monte carlo with light and bsdf sampling (mis)" << std::endl;
+	for (int i=0; i< num_examples; ++i)
 	{
-		return kBlack;
-	}
-
-	if (!world.hit(ray, 0.001, kInfinity, rec)) {
-		return background;
+		std::cerr << "   " << i << ". " << examples[i]._name << std::endl;
 	}
+	std::cerr << "   append -packets to trace primary rays in packets of 4x2 pixels" << std::endl;
+	std::cerr << "   append -compiled to render a compiled copy of the scene (static dispatch)" << std::endl;
+	std::cerr << "   append -stats to print per bounce path statistics (methods 0, 1, 3 and 4)" << std::endl;
+	std::cerr << "   append -sampler random|halton|sobol|bluenoise to pick the sampler of methods 0, 1, 3 and 4 (sobol)" << std::endl;
+	std::cerr << "   append -lights uniform|power|bvh to pick how methods 3 and 4 choose the light to sample (bvh)" << std::endl;
+	std::cerr << "   append -env file.hdr to light the scene with an equirectangular environment map instead of the background color," << std::endl;
+	std::cerr << "             methods 3 and 4 importance sample it" << std::endl;
+	std::cerr << "   append -spp N to override the samples per pixel of the method" << std::endl;
+	std::cerr << "   append -denoise to filter the image guided by first-hit albedo, normal and depth (methods 0, 1, 3 and 4)" << std::endl;
+	std::cerr << "   append -aov file.exr all|depth,normal,albedo,material,object,direct,indirect,samples to also write" << std::endl;
+	std::cerr << "             the image and the chosen aovs as float channels (methods 0, 1, 3 and 4)" << std::endl;
+	std::cerr << "   append -roulette minDepth maxDepth survival to set the russian roulette of methods 1, 3 and 4 (3 64 0.95)," << std::endl;
+	std::cerr << "             paths survive with min(survival, luminance of the throughput) after minDepth bounces," << std::endl;
+	std::cerr << "             survival in (0, 1], maxDepth not below minDepth" << std::endl;
+	display_benchmark_usage();
+}
 
-	FRay scattered;
-	FColor3 attenuation;
-	FColor3 emitted = rec.mat_ptr->emitted(rec.u, rec.v, rec.p);
-
-	if (!rec.mat_ptr->scatter(ray, rec, attenuation, scattered))
+// writes the image in scanline order, top row first
+void write_framebuffer(const std::vector<FColor3>& framebuffer, int image_with, int image_height, int samples_per_pixel)
+{
+	for (int j = image_height - 1; j >= 0; --j)
 	{
-		return emitted;
+		for (int i = 0; i < image_with; ++i)
+		{
+			write_color(std::cout, framebuffer[j * image_with + i], samples_per_pixel, 2.2);
+		}
 	}
-
-	return emitted + attenuation * ray_color(scattered, background, world, depth - 1);
 }
 
-// monte-carlo path trace
-// P_RR: Russian Roulette property
-FColor3 ray_color_montecarlo(const FRay& ray, const FColor3& background, FHittable& world, const double& P_RR)
+// renders tiles of 4x2 pixels, one ray packet per sample
+void render_packets(const FRayCamera& camera, int image_with, int image_height, int samples_per_pixel,
+	const std::function<void(const FRayPacket&, FColor3*)>& trace_packet)
 {
-	FHitRecord rec;
+	const int tile_w = 4;
+	const int tile_h = kPacketSize / tile_w;
 
+	std::vector<FColor3> framebuffer(image_with * image_height, FColor3(0, 0, 0));
 
-
-	if (!world.hit(ray, 0.001, kInfinity, rec)) {
-		return background;
-	}
-
-	FRay scattered;
-	FColor3 attenuation;
-	FColor3 emitted = rec.mat_ptr->emitted(rec.u, rec.v, rec.p);
-
-	if (!rec.mat_ptr->scatter(ray, rec, attenuation, scattered))
+	for (int tj = 0; tj < image_height; tj += tile_h)
 	{
-		return emitted;
-	}
+		std::cerr << "\rScanlines remaining: " << image_height - tj << ' ' << std::flush;
+		for (int ti = 0; ti < image_with; ti += tile_w)
+		{
+			for (int s = 0; s < samples_per_pixel; ++s)
+			{
+				FRayPacket packet;
+				int pixels[kPacketSize];
+				for (int j = tj; j < tj + tile_h && j < image_height; ++j)
+				{
+					for (int i = ti; i < ti + tile_w && i < image_with; ++i)
+					{
+						auto u = (i + random_double()) / (image_with - 1);
+						auto v = (j + random_double()) / (image_height - 1);
+
+						pixels[packet.count] = j * image_with + i;
+						packet.add(camera.castRay(u, v));
+					}
+				}
+				packet.finalize();
 
-	double ksi = random_double();
-	if (ksi <= P_RR)
-	{
-		FColor3 L_indir = (attenuation* ray_color_montecarlo(scattered, background, world, P_RR) / rec.mat_ptr->pdf(scattered.Direction())) / P_RR;
-		return emitted + L_indir;
+				FColor3 colors[kPacketSize];
+				trace_packet(packet, colors);
+				for (int k = 0; k < packet.count; ++k)
+				{
+					framebuffer[pixels[k]] += colors[k];
+				}
+			}
+		}
 	}
 
-	return emitted;
+	write_framebuffer(framebuffer, image_with, image_height, samples_per_pixel);
 }
 
-
-void display_usage()
+// renders every pixel sample by sample from sampler and returns the pixel
+// means, denoised when denoise_settings is given. trace returns the radiance
+// of a camera ray and fills its aovs when handed them, they go to aov_buffer
+std::vector<FColor3> render_image(const FRayCamera& camera, FSampler& sampler, int image_with, int image_height, int samples_per_pixel,
+	const FDenoiseSettings* denoise_settings, FAovBuffer* aov_buffer, const std::function<FColor3(const FRay&, FPathAovs*)>& trace)
 {
-	std::cerr << "Usage:  program.exe sceneId  methodId > filename.ppm" << std::endl;
-	for (int i=0; i< sizeof(examples) / sizeof(examples[0]); ++i)
+	FDenoiseBuffers buffers;
+	buffers.resize(image_with, image_height);
+
+	FPathAovs aovs;
+	FPathAovs* traced_aovs = (denoise_settings || aov_buffer) ? &aovs : nullptr;
+	for (int j = image_height - 1; j >= 0; --j)
 	{
-		std::cerr << "   " << i << ". " << examples[i]._name << std::endl;
+		std::cerr << "\rScanlines remaining: " << j << ' ' << std::flush;
+		for (int i = 0; i < image_with; ++i)
+		{
+			for (int s = 0; s < samples_per_pixel; ++s)
+			{
+				sampler.start_pixel_sample(i, j, s);
+				FReal du, dv;
+				sample_2d(du, dv);
+				auto u = (i + du) / (image_with - 1);
+				auto v = (j + dv) / (image_height - 1);
+
+				const FColor3 radiance = trace(camera.castRay(u, v), traced_aovs);
+				buffers.add(j * image_with + i, radiance, aovs.albedo, aovs.normal, aovs.depth);
+				if (aov_buffer) aov_buffer->add(j * image_with + i, radiance, aovs);
+			}
+		}
+	} // end j
+
+	std::vector<FColor3> image(buffers.color.size());
+	if (!denoise_settings)
+	{
+		for (size_t k = 0; k < image.size(); k++) image[k] = buffers.color[k] / samples_per_pixel;
+		return image;
 	}
+
+	FPerformanceCounter counter;
+	counter.StartPerf();
+	denoise(buffers, samples_per_pixel, *denoise_settings, image);
+	std::cerr << "\ndenoise seconds: " << (counter.EndPerf() / 1000000.0) << std::endl;
+	return image;
 }
 
 int main(int argc, char* argv[])
@@ -113,16 +158,91 @@ int main(int argc, char* argv[])
 	const int image_with = 600;
 	const int image_height = static_cast<int>(image_with / aspect_ratio);
 
-	int trace_method = 0; // 0: normal, 1: monte carlo
+	int trace_method = 0; // 0: normal, 1: monte carlo, 2: wavefront, 3: next event estimation, 4: mis
 	int example_index = -1;
+	bool use_packets = false;
+	bool use_compiled = false;
+	bool use_stats = false;
+	bool use_denoiser = false;
+	int samples_override = 0;
+	const char* aov_filename = nullptr;
+	const char* environment_filename = nullptr;
+	uint32_t aov_mask = 0;
+	ESamplerType sampler_type = ESamplerType::Sobol;
+	ELightSampling light_sampling = ELightSampling::Bvh;
+	FRoulette roulette;
+	if (argc > 1 && strcmp(argv[1], "-bench") == 0)
+	{
+		return run_benchmark(argc - 2, argv + 2);
+	}
 	if (argc > 1)
 	{
 		example_index = atoi(argv[1]);
 		if (argc > 2) {
 			trace_method = atoi(argv[2]);
 		}
+		for (int arg = 3; arg < argc; ++arg) {
+			use_packets = use_packets || strcmp(argv[arg], "-packets") == 0;
+			use_compiled = use_compiled || strcmp(argv[arg], "-compiled") == 0;
+			use_stats = use_stats || strcmp(argv[arg], "-stats") == 0;
+			use_denoiser = use_denoiser || strcmp(argv[arg], "-denoise") == 0;
+			if (strcmp(argv[arg], "-aov") == 0)
+			{
+				if (arg + 2 >= argc || !parse_aovs(argv[arg + 2], aov_mask))
+				{
+					display_usage();
+					return 0;
+				}
+				aov_filename = argv[arg + 1];
+				arg += 2;
+			}
+			if (strcmp(argv[arg], "-spp") == 0)
+			{
+				samples_override = arg + 1 < argc ? atoi(argv[++arg]) : 0;
+				if (samples_override <= 0)
+				{
+					display_usage();
+					return 0;
+				}
+			}
+			if (strcmp(argv[arg], "-sampler") == 0 && (arg + 1 >= argc || !find_sampler(argv[++arg], sampler_type)))
+			{
+				display_usage();
+				return 0;
+			}
+			if (strcmp(argv[arg], "-env") == 0)
+			{
+				if (arg + 1 >= argc)
+				{
+					display_usage();
+					return 0;
+				}
+				environment_filename = argv[++arg];
+			}
+			if (strcmp(argv[arg], "-lights") == 0 && (arg + 1 >= argc || !find_light_sampling(argv[++arg], light_sampling)))
+			{
+				display_usage();
+				return 0;
+			}
+			if (strcmp(argv[arg], "-roulette") == 0)
+			{
+				if (arg + 3 >= argc)
+				{
+					display_usage();
+					return 0;
+				}
+				roulette.min_depth = atoi(argv[++arg]);
+				roulette.max_depth = atoi(argv[++arg]);
+				roulette.survival = atof(argv[++arg]);
+				if (roulette.min_depth < 0 || roulette.max_depth < roulette.min_depth || !(roulette.survival > 0 && roulette.survival <= 1))
+				{
+					display_usage();
+					return 0;
+				}
+			}
+		}
 	}
-	if (example_index < 0 || example_index >= sizeof(examples) / sizeof(examples[0]))
+	if (example_index < 0 || example_index >= num_examples)
 	{
 		display_usage();
 		return 0;
@@ -130,65 +250,136 @@ int main(int argc, char* argv[])
 
 	shared_ptr<FRayCamera> camera = nullptr;
 	shared_ptr<FHittable> theWorld = examples[example_index]._funcptr(camera, kBackground);
+	shared_ptr<FEnvironment> environment;
+	if (environment_filename)
+	{
+		environment = make_shared<FEnvironment>(environment_filename);
+		if (!environment->valid())
+		{
+			return 1;
+		}
+	}
+	const FBackground background(kBackground, environment.get());
+	if (use_compiled)
+	{
+		shared_ptr<FCompiledScene> compiled = make_shared<FCompiledScene>(theWorld, 0.0, 1.0);
+		std::cerr << "compiled scene: " << compiled->num_primitives() << " primitives, " << compiled->num_fallbacks()
+			<< " virtual, " << compiled->num_nodes() << " nodes" << std::endl;
+		theWorld = compiled;
+	}
 
 	std::cerr << "photo size: " << image_with << ", " << image_height << std::endl;
 	std::cout << "P3\n" << image_with << " " << image_height << "\n255\n";
+	FBounceStats bounce_stats;
+	FBounceStats* stats = use_stats ? &bounce_stats : nullptr;
+
+	// the scanline renderers draw from the sampler, the packet and wavefront
+	// ones trace many paths at once and keep random_double()
+	shared_ptr<FSampler> sampler = make_sampler(sampler_type);
+	if (!use_packets && trace_method != 2)
+	{
+		std::cerr << "sampler: " << sampler->name() << std::endl;
+		active_sampler = sampler.get();
+	}
+
+	// samples per pixel of the method unless -spp is given
+	auto samples = [&](int method_spp) { return samples_override > 0 ? samples_override : method_spp; };
+
+	FDenoiseSettings denoise_settings;
+	const FDenoiseSettings* denoising = nullptr;
+	if (use_denoiser && !use_packets && trace_method != 2)
+	{
+		denoising = &denoise_settings;
+	}
+	else if (use_denoiser)
+	{
+		std::cerr << "-denoise ignored: the packet and wavefront renderers keep no first-hit guides" << std::endl;
+	}
+
+	shared_ptr<FAovBuffer> aov_buffer;
+	if (aov_filename && !use_packets && trace_method != 2)
+	{
+		aov_buffer = make_shared<FAovBuffer>(image_with, image_height, aov_mask);
+	}
+	else if (aov_filename)
+	{
+		std::cerr << "-aov ignored: the packet and wavefront renderers keep no aovs" << std::endl;
+	}
+	std::vector<FColor3> image;  // pixel means of the scanline renderers
+
 	FPerformanceCounter PerfCounter;
 	PerfCounter.StartPerf();
 
-	if (trace_method == 0)
+	if (trace_method == 0 && use_packets)
 	{
-		const int samples_per_pixel = 1000;
+		const int samples_per_pixel = samples(1000);
 		const int max_depth = 50;
 
-		for (int j = image_height - 1; j >= 0; --j)
-		{
-			std::cerr << "\rScanlines remaining: " << j << ' ' << std::flush;
-			for (int i = 0; i < image_with; ++i)
-			{
-				FColor3 pixel_color(0, 0, 0);
-
-				for (int s = 0; s < samples_per_pixel; ++s)
-				{
-					auto u = (i + random_double()) / (image_with - 1);
-					auto v = (j + random_double()) / (image_height - 1);
+		render_packets(*camera, image_with, image_height, samples_per_pixel,
+			[&](const FRayPacket& packet, FColor3* colors) { ray_color_packet(packet, background, *theWorld, max_depth, colors); });
+	}
+	else if (trace_method == 1 && use_packets)
+	{
+		const int samples_per_pixel = samples(10000);
 
-					FRay ray = camera->castRay(u, v);
-					pixel_color += ray_color(ray, kBackground, *theWorld, max_depth);
-				}
+		render_packets(*camera, image_with, image_height, samples_per_pixel,
+			[&](const FRayPacket& packet, FColor3* colors) { ray_color_montecarlo_packet(packet, background, *theWorld, roulette, colors); });
+	}
+	else if (trace_method == 0)
+	{
+		const int samples_per_pixel = samples(1000);
+		const int max_depth = 50;
 
-				write_color(std::cout, pixel_color, samples_per_pixel, 2.2);
-			}
-		} // end j
+		image = render_image(*camera, *sampler, image_with, image_height, samples_per_pixel, denoising, aov_buffer.get(),
+			[&](const FRay& ray, FPathAovs* aovs) { return ray_color(ray, background, *theWorld, max_depth, stats, aovs); });
 	}
 	else if (trace_method == 1)
 	{
-		const int samples_per_pixel = 10000;
-		const double P_RR = 0.75;
+		const int samples_per_pixel = samples(10000);
 
-		for (int j = image_height - 1; j >= 0; --j)
-		{
-			std::cerr << "\rScanlines remaining: " << j << ' ' << std::flush;
-			for (int i = 0; i < image_with; ++i)
-			{
-				FColor3 pixel_color(0, 0, 0);
+		image = render_image(*camera, *sampler, image_with, image_height, samples_per_pixel, denoising, aov_buffer.get(),
+			[&](const FRay& ray, FPathAovs* aovs) { return ray_color_montecarlo(ray, background, *theWorld, roulette, stats, aovs); });
+	}
 
-				for (int s = 0; s < samples_per_pixel; ++s)
-				{
-					auto u = (i + random_double()) / (image_with - 1);
-					auto v = (j + random_double()) / (image_height - 1);
+	else if (trace_method == 2)
+	{
+		const int samples_per_pixel = samples(1000);
+		const int max_depth = 50;
 
-					FRay ray = camera->castRay(u, v);
-					pixel_color += ray_color_montecarlo(ray, kBackground, *theWorld, 0.6);
-				}
+		std::vector<FColor3> framebuffer(image_with * image_height, FColor3(0, 0, 0));
+		render_wavefront(*camera, background, *theWorld, max_depth, image_with, image_height, samples_per_pixel, framebuffer.data());
+		write_framebuffer(framebuffer, image_with, image_height, samples_per_pixel);
+	}
 
-				write_color(std::cout, pixel_color, samples_per_pixel, 2.2);
-			}
-		} // end j
+	else if (trace_method == 3 || trace_method == 4)
+	{
+		const int samples_per_pixel = samples(1000);
+
+		FLightList lights(*theWorld, environment.get(), light_sampling);
+		std::cerr << "lights: " << lights.size() << ", " << light_sampling_name(light_sampling) << std::endl;
+
+		image = render_image(*camera, *sampler, image_with, image_height, samples_per_pixel, denoising, aov_buffer.get(),
+			[&](const FRay& ray, FPathAovs* aovs) {
+				return trace_method == 3 ? ray_color_nee(ray, background, *theWorld, lights, roulette, stats, aovs)
+					: ray_color_mis(ray, background, *theWorld, lights, roulette, stats, aovs);
+			});
+	}
+
+	if (!image.empty())
+	{
+		write_framebuffer(image, image_with, image_height, 1);
+	}
+	if (aov_buffer && !aov_buffer->write_exr(aov_filename, image))
+	{
+		std::cerr << "ERROR: Could not write " << aov_filename << std::endl;
 	}
 
 	double elapse_ms = PerfCounter.EndPerf();
 	std::cerr << "performance seconds: " << std::fixed << (elapse_ms / 1000000.0) << std::endl;
+	if (stats)
+	{
+		stats->print(std::cerr);
+	}
 	std::cerr << "\nDone.\n";
 	return 0;
 }
\ No newline at end of file
@@ -2,79 +2,104 @@
 //
 
 #include "aarect.h"
+#include "sampler.h"
 
 
-bool FXYRect::hit(const FRay& r, double t0, double t1, FHitRecord& rec) const 
+// solid angle pdf of a uniformly sampled point of the rect, normal along axis
+static FReal rect_pdf(const FHittable& rect, int axis, FReal area, const FPoint3& origin, const FVec3& dir)
+{
+	FHitRecord rec;
+	if (!rect.intersect(FRay(origin, dir), 0.001, kInfinity, rec))
+		return 0;
+
+	const FReal distance_squared = rec.t * rec.t * dir.length2();
+	const FReal cosine = fabs(dir[axis]) / dir.length();
+	return distance_squared / (cosine * area);
+}
+
+void FXYRect::surface(const FRay& r, FHitRecord& rec) const
 {
 	const FPoint3 origin = r.Origin();
 	const FVec3 direction = r.Direction();
-
-	auto t = (k - origin.z()) / direction.z();
-	if (t < t0 || t > t1)
-		return false;
+	const auto t = rec.t;
 
 	auto x = origin.x() + t * direction.x();
 	auto y = origin.y() + t * direction.y();
-	if (x < x0 || x > x1 || y < y0 || y > y1)
-		return false;
 
 	rec.u = (x - x0) / (x1 - x0);
 	rec.v = (y - y0) / (y1 - y0);
-	rec.t = t;
 	auto outward_normal = FVec3(0, 0, 1);
 	rec.set_face_normal(r, outward_normal);
-	rec.mat_ptr = mp;
+	rec.mat_ptr = mp.get();
 	rec.p = r.At(t);
-
-	return true;
 }
 
-bool FXZRect::hit(const FRay& r, double t0, double t1, FHitRecord& rec) const 
+void FXZRect::surface(const FRay& r, FHitRecord& rec) const
 {
 	const FPoint3 origin = r.Origin();
 	const FVec3 direction = r.Direction();
-
-	auto t = (k - origin.y()) / direction.y();
-	if (t < t0 || t > t1)
-		return false;
+	const auto t = rec.t;
 
 	auto x = origin.x() + t * direction.x();
 	auto z = origin.z() + t * direction.z();
-	if (x < x0 || x > x1 || z < z0 || z > z1)
-		return false;
 
 	rec.u = (x - x0) / (x1 - x0);
 	rec.v = (z - z0) / (z1 - z0);
-	rec.t = t;
 	auto outward_normal = FVec3(0, 1, 0);
 	rec.set_face_normal(r, outward_normal);
-	rec.mat_ptr = mp;
+	rec.mat_ptr = mp.get();
 	rec.p = r.At(t);
-
-	return true;
 }
 
-bool FYZRect::hit(const FRay& r, double t0, double t1, FHitRecord& rec) const 
+void FYZRect::surface(const FRay& r, FHitRecord& rec) const
 {
 	const FPoint3 origin = r.Origin();
 	const FVec3 direction = r.Direction();
-
-	auto t = (k - origin.x()) / direction.x();
-	if (t < t0 || t > t1)
-		return false;
+	const auto t = rec.t;
 
 	auto y = origin.y() + t * direction.y();
 	auto z = origin.z() + t * direction.z();
-	if (y < y0 || y > y1 || z < z0 || z > z1)
-		return false;
 
 	rec.u = (y - y0) / (y1 - y0);
 	rec.v = (z - z0) / (z1 - z0);
-	rec.t = t;
 	auto outward_normal = FVec3(1, 0, 0);
 	rec.set_face_normal(r, outward_normal);
-	rec.mat_ptr = mp;
+	rec.mat_ptr = mp.get();
 	rec.p = r.At(t);
+}
+
+FReal FXYRect::pdf_value(const FPoint3& origin, const FVec3& dir) const
+{
+	return rect_pdf(*this, 2, (x1 - x0) * (y1 - y0), origin, dir);
+}
 
-	return true;
+FVec3 FXYRect::random(const FPoint3& origin) const
+{
+	FReal u, v;
+	sample_2d(u, v);
+	return FPoint3(lerp(x0, x1, u), lerp(y0, y1, v), k) - origin;
+}
+
+FReal FXZRect::pdf_value(const FPoint3& origin, const FVec3& dir) const
+{
+	return rect_pdf(*this, 1, (x1 - x0) * (z1 - z0), origin, dir);
+}
+
+FVec3 FXZRect::random(const FPoint3& origin) const
+{
+	FReal u, v;
+	sample_2d(u, v);
+	return FPoint3(lerp(x0, x1, u), k, lerp(z0, z1, v)) - origin;
+}
+
+FReal FYZRect::pdf_value(const FPoint3& origin, const FVec3& dir) const
+{
+	return rect_pdf(*this, 0, (y1 - y0) * (z1 - z0), origin, dir);
+}
+
+FVec3 FYZRect::random(const FPoint3& origin) const
+{
+	FReal u, v;
+	sample_2d(u, v);
+	return FPoint3(k, lerp(y0, y1, u), lerp(z0, z1, v)) - origin;
 }
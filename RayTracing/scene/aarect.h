@@ -14,12 +14,15 @@ public:
 	FXYRect() {}
 
 	FXYRect(
-		double _x0, double _x1, double _y0, double _y1, double _k, const shared_ptr<FMaterial> &mat
+		FReal _x0, FReal _x1, FReal _y0, FReal _y1, FReal _k, const shared_ptr<FMaterial> &mat
 	) : x0(_x0), x1(_x1), y0(_y0), y1(_y1), k(_k), mp(mat) {};
 
-	virtual bool hit(const FRay& r, double t0, double t1, FHitRecord& rec) const;
+	virtual bool intersect(const FRay& r, FReal t0, FReal t1, FHitRecord& rec) const;
+	virtual void surface(const FRay& r, FHitRecord& rec) const;
+	virtual FReal pdf_value(const FPoint3& origin, const FVec3& dir) const;
+	virtual FVec3 random(const FPoint3& origin) const;
 
-	virtual bool bounding_box(double t0, double t1, FAABB& output_box) const {
+	virtual bool bounding_box(FReal t0, FReal t1, FAABB& output_box) const {
 		// The bounding box must have non-zero width in each dimension, so pad the Z
 		// dimension a small amount.
 		output_box = FAABB(FPoint3(x0, y0, k - 0.0001), FPoint3(x1, y1, k + 0.0001));
@@ -28,7 +31,7 @@ public:
 
 public:
 	shared_ptr<FMaterial> mp;
-	double x0, x1, y0, y1, k;
+	FReal x0, x1, y0, y1, k;
 };
 
 class FXZRect : public FHittable {
@@ -36,12 +39,15 @@ public:
 	FXZRect() {}
 
 	FXZRect(
-		double _x0, double _x1, double _z0, double _z1, double _k, const shared_ptr<FMaterial>& mat
+		FReal _x0, FReal _x1, FReal _z0, FReal _z1, FReal _k, const shared_ptr<FMaterial>& mat
 	) : x0(_x0), x1(_x1), z0(_z0), z1(_z1), k(_k), mp(mat) {};
 
-	virtual bool hit(const FRay& r, double t0, double t1, FHitRecord& rec) const;
+	virtual bool intersect(const FRay& r, FReal t0, FReal t1, FHitRecord& rec) const;
+	virtual void surface(const FRay& r, FHitRecord& rec) const;
+	virtual FReal pdf_value(const FPoint3& origin, const FVec3& dir) const;
+	virtual FVec3 random(const FPoint3& origin) const;
 
-	virtual bool bounding_box(double t0, double t1, FAABB& output_box) const {
+	virtual bool bounding_box(FReal t0, FReal t1, FAABB& output_box) const {
 		// The bounding box must have non-zero width in each dimension, so pad the Y
 		// dimension a small amount.
 		output_box = FAABB(FPoint3(x0, k - 0.0001, z0), FPoint3(x1, k + 0.0001, z1));
@@ -50,7 +56,7 @@ public:
 
 public:
 	shared_ptr<FMaterial> mp;
-	double x0, x1, z0, z1, k;
+	FReal x0, x1, z0, z1, k;
 };
 
 class FYZRect : public FHittable {
@@ -58,12 +64,15 @@ public:
 	FYZRect() {}
 
 	FYZRect(
-		double _y0, double _y1, double _z0, double _z1, double _k, const shared_ptr<FMaterial>& mat
+		FReal _y0, FReal _y1, FReal _z0, FReal _z1, FReal _k, const shared_ptr<FMaterial>& mat
 	) : y0(_y0), y1(_y1), z0(_z0), z1(_z1), k(_k), mp(mat) {};
 
-	virtual bool hit(const FRay& r, double t0, double t1, FHitRecord& rec) const;
+	virtual bool intersect(const FRay& r, FReal t0, FReal t1, FHitRecord& rec) const;
+	virtual void surface(const FRay& r, FHitRecord& rec) const;
+	virtual FReal pdf_value(const FPoint3& origin, const FVec3& dir) const;
+	virtual FVec3 random(const FPoint3& origin) const;
 
-	virtual bool bounding_box(double t0, double t1, FAABB& output_box) const {
+	virtual bool bounding_box(FReal t0, FReal t1, FAABB& output_box) const {
 		// The bounding box must have non-zero width in each dimension, so pad the X
 		// dimension a small amount.
 		output_box = FAABB(FPoint3(k - 0.0001, y0, z0), FPoint3(k + 0.0001, y1, z1));
@@ -72,6 +81,62 @@ public:
 
 public:
 	shared_ptr<FMaterial> mp;
-	double y0, y1, z0, z1, k;
+	FReal y0, y1, z0, z1, k;
 };
 
+
+// ray tests, in the header for callers that dispatch statically
+
+inline bool FXYRect::intersect(const FRay& r, FReal t0, FReal t1, FHitRecord& rec) const
+{
+	const FPoint3 origin = r.Origin();
+	const FVec3 direction = r.Direction();
+
+	auto t = (k - origin.z()) / direction.z();
+	if (t < t0 || t > t1)
+		return false;
+
+	auto x = origin.x() + t * direction.x();
+	auto y = origin.y() + t * direction.y();
+	if (x < x0 || x > x1 || y < y0 || y > y1)
+		return false;
+
+	rec.set_hit(t, this);
+	return true;
+}
+
+inline bool FXZRect::intersect(const FRay& r, FReal t0, FReal t1, FHitRecord& rec) const
+{
+	const FPoint3 origin = r.Origin();
+	const FVec3 direction = r.Direction();
+
+	auto t = (k - origin.y()) / direction.y();
+	if (t < t0 || t > t1)
+		return false;
+
+	auto x = origin.x() + t * direction.x();
+	auto z = origin.z() + t * direction.z();
+	if (x < x0 || x > x1 || z < z0 || z > z1)
+		return false;
+
+	rec.set_hit(t, this);
+	return true;
+}
+
+inline bool FYZRect::intersect(const FRay& r, FReal t0, FReal t1, FHitRecord& rec) const
+{
+	const FPoint3 origin = r.Origin();
+	const FVec3 direction = r.Direction();
+
+	auto t = (k - origin.x()) / direction.x();
+	if (t < t0 || t > t1)
+		return false;
+
+	auto y = origin.y() + t * direction.y();
+	auto z = origin.z() + t * direction.z();
+	if (y < y0 || y > y1 || z < z0 || z > z1)
+		return false;
+
+	rec.set_hit(t, this);
+	return true;
+}
@@ -5,22 +5,79 @@
 
 
 FBox::FBox(const FPoint3& p0, const FPoint3& p1, const shared_ptr<FMaterial>& ptr)
-	: box_min(p0), box_max(p1)
+	: box_min(p0), box_max(p1), mp(ptr)
 {
-	sides.add(make_shared<FXYRect>(p0.x(), p1.x(), p0.y(), p1.y(), p1.z(), ptr));
-	sides.add(make_shared<FFlipFace>(
-		make_shared<FXYRect>(p0.x(), p1.x(), p0.y(), p1.y(), p0.z(), ptr)));
+}
+
+bool FBox::intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const
+{
+	const FPoint3& origin = ray.Origin();
+	const FVec3& direction = ray.Direction();
+
+	FReal t_near = -kInfinity;
+	FReal t_far = kInfinity;
+	int near_axis = 0;
+	int far_axis = 0;
+
+	for (int a = 0; a < 3; a++)
+	{
+		const FReal inv_d = 1.0 / direction[a];
+		FReal t0 = (box_min[a] - origin[a]) * inv_d;
+		FReal t1 = (box_max[a] - origin[a]) * inv_d;
+		if (inv_d < 0.0) std::swap(t0, t1);
 
-	sides.add(make_shared<FXZRect>(p0.x(), p1.x(), p0.z(), p1.z(), p1.y(), ptr));
-	sides.add(make_shared<FFlipFace>(
-		make_shared<FXZRect>(p0.x(), p1.x(), p0.z(), p1.z(), p0.y(), ptr)));
+		if (t0 > t_near) { t_near = t0; near_axis = a; }
+		if (t1 < t_far) { t_far = t1; far_axis = a; }
+	} // end for a
 
-	sides.add(make_shared<FYZRect>(p0.y(), p1.y(), p0.z(), p1.z(), p1.x(), ptr));
-	sides.add(make_shared<FFlipFace>(
-		make_shared<FYZRect>(p0.y(), p1.y(), p0.z(), p1.z(), p0.x(), ptr)));
+	if (t_near > t_far)
+		return false;
+
+	// enter through the near face, or leave through the far one when the ray starts inside
+	FReal t;
+	int axis;
+	bool max_face;
+	if (t_near >= t_min && t_near <= t_max)
+	{
+		t = t_near;
+		axis = near_axis;
+		max_face = direction[axis] < 0.0;
+	}
+	else if (t_far >= t_min && t_far <= t_max)
+	{
+		t = t_far;
+		axis = far_axis;
+		max_face = direction[axis] > 0.0;
+	}
+	else
+	{
+		return false;
+	}
+
+	// prim_id is the hit face: axis * 2 + max_face
+	outHit.set_hit(t, this, axis * 2 + (max_face ? 1 : 0));
+	return true;
 }
 
-bool FBox::hit(const FRay& ray, double t_min, double t_max, FHitRecord& outHit) const
+void FBox::surface(const FRay& ray, FHitRecord& rec) const
 {
-	return sides.hit(ray, t_min, t_max, outHit);
+	const FPoint3& origin = ray.Origin();
+	const FVec3& direction = ray.Direction();
+	const FReal t = rec.t;
+	const int axis = rec.prim_id >> 1;
+	const bool max_face = (rec.prim_id & 1) != 0;
+
+	// uv follows the rect of that face: xy on z faces, xz on y faces, yz on x faces
+	const int ua = (axis == AABB_X) ? AABB_Y : AABB_X;
+	const int va = (axis == AABB_Z) ? AABB_Y : AABB_Z;
+	const FReal u = origin[ua] + t * direction[ua];
+	const FReal v = origin[va] + t * direction[va];
+
+	rec.u = (u - box_min[ua]) / (box_max[ua] - box_min[ua]);
+	rec.v = (v - box_min[va]) / (box_max[va] - box_min[va]);
+	FVec3 outward_normal(0, 0, 0);
+	outward_normal[axis] = max_face ? 1.0 : -1.0;
+	rec.set_face_normal(ray, outward_normal);
+	rec.mat_ptr = mp.get();
+	rec.p = ray.At(t);
 }
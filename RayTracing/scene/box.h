@@ -4,19 +4,21 @@
 
 #pragma once
 
-#include "aarect.h"
-#include "hittable_list.h"
+#include "hittable.h"
 
 
 // box
+// intersected as one slab test, the hit face is the axis that bounds the
+// entry (or, from inside, the exit) distance.
 class FBox : public FHittable
 {
 public:
 	FBox() {}
 	FBox(const FPoint3& p0, const FPoint3& p1, const shared_ptr<FMaterial>& ptr);
 
-	virtual bool hit(const FRay& ray, double t_min, double t_max, FHitRecord& outHit) const;
-	virtual bool bounding_box(double t0, double t1, FAABB& outbox) const
+	virtual bool intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const;
+	virtual void surface(const FRay& ray, FHitRecord& rec) const;
+	virtual bool bounding_box(FReal t0, FReal t1, FAABB& outbox) const
 	{
 		outbox = FAABB(box_min, box_max);
 		return true;
@@ -25,5 +27,5 @@ public:
 protected:
 	FPoint3 box_min;
 	FPoint3 box_max;
-	FHittableList sides;
+	shared_ptr<FMaterial> mp;
 };
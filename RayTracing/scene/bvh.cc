@@ -4,6 +4,7 @@
 
 #include "bvh.h"
 #include "hittable_list.h"
+#include "sphere_set.h"
 #include <algorithm>
 
 
@@ -19,6 +20,36 @@ inline bool box_compare(const shared_ptr<FHittable> &a, const shared_ptr<FHittab
 }
 
 
+// leaf content: spheres are packed into one FSphereSet, anything else goes to a list
+static shared_ptr<FHittable> make_leaf(std::vector<shared_ptr<FHittable>>::const_iterator first, std::vector<shared_ptr<FHittable>>::const_iterator last)
+{
+	shared_ptr<FHittableList> hitablelist = make_shared<FHittableList>();
+	shared_ptr<FSphereSet> spheres = make_shared<FSphereSet>();
+
+	for (auto it = first; it != last; ++it)
+	{
+		if (!spheres->add(*it))
+		{
+			hitablelist->add(*it);
+		}
+	}
+
+	if (spheres->size() < 2)
+	{
+		// not worth a batch
+		hitablelist->objects.assign(first, last);
+		return hitablelist;
+	}
+
+	if (hitablelist->objects.empty())
+	{
+		return spheres;
+	}
+
+	hitablelist->add(spheres);
+	return hitablelist;
+}
+
 bool box_x_compare(const shared_ptr<FHittable> &a, const shared_ptr<FHittable> &b) {
 	return box_compare(a, b, 0);
 }
@@ -32,7 +63,7 @@ bool box_z_compare(const shared_ptr<FHittable> &a, const shared_ptr<FHittable> &
 }
 
 
-FBVH_Node::FBVH_Node(std::vector<shared_ptr<FHittable>>& objects, size_t start, size_t end, double time0, double time1)
+FBVH_Node::FBVH_Node(std::vector<shared_ptr<FHittable>>& objects, size_t start, size_t end, FReal time0, FReal time1)
 {
 	int axis = random_int(0, 2);
 	auto comparator = (axis == AABB_X) ? box_x_compare
@@ -42,12 +73,7 @@ FBVH_Node::FBVH_Node(std::vector<shared_ptr<FHittable>>& objects, size_t start,
 
 	if (object_span <= MAX_HITTABLES_IN_LEAF)
 	{
-		shared_ptr<FHittableList> hitablelist = make_shared<FHittableList>();
-		for (size_t i = start; i < end; i++)
-		{
-			hitablelist->add(objects[i]);
-		}
-		left = hitablelist;
+		left = make_leaf(objects.begin() + start, objects.begin() + end);
 	}
 	else
 	{
@@ -78,13 +104,176 @@ FBVH_Node::FBVH_Node(std::vector<shared_ptr<FHittable>>& objects, size_t start,
 }
 	
 
-bool FBVH_Node::hit(const FRay& ray, double t_min, double t_max, FHitRecord& outHit) const
+bool FBVH_Node::intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const
 {
 	if (!box.hit(ray, t_min, t_max))
 		return false;
 
-	bool hit_left = left->hit(ray, t_min, t_max, outHit);
-	bool hit_right = right ? right->hit(ray, t_min, (hit_left ? outHit.t : t_max), outHit) : false;
+	bool hit_left = left->intersect(ray, t_min, t_max, outHit);
+	bool hit_right = right ? right->intersect(ray, t_min, (hit_left ? outHit.t : t_max), outHit) : false;
 
 	return hit_left || hit_right;
 }
+
+bool FBVH_Node::occluded(const FRay& ray, FReal t_min, FReal t_max, FReal& transmittance) const
+{
+	if (!box.hit(ray, t_min, t_max))
+		return false;
+
+	return left->occluded(ray, t_min, t_max, transmittance) || (right && right->occluded(ray, t_min, t_max, transmittance));
+}
+
+uint32_t FBVH_Node::intersect_packet(const FRayPacket& packet, FReal t_min, FReal* t_max, FHitRecord* recs) const
+{
+	// the interval test needs agreeing direction signs, otherwise go ray by ray
+	if (!packet.coherent)
+		return FHittable::intersect_packet(packet, t_min, t_max, recs);
+
+	if (!packet.hit_box(box, t_min, t_max))
+		return 0;
+
+	uint32_t hits = left->intersect_packet(packet, t_min, t_max, recs);
+	if (right)
+	{
+		hits |= right->intersect_packet(packet, t_min, t_max, recs);
+	}
+	return hits;
+}
+
+
+FLazyBVH_Node::FLazyBVH_Node(const std::vector<shared_ptr<FHittable>>& objects, size_t start, size_t end, FReal time0, FReal time1)
+	: objects(make_shared<const FObjects>(objects.begin() + start, objects.begin() + end))
+	, root_order(end - start)
+	, first(nullptr)
+	, count(end - start)
+	, children(nullptr)
+	, time0(time0)
+	, time1(time1)
+{
+	for (size_t i = 0; i < count; i++)
+		root_order[i] = static_cast<uint32_t>(i);
+	first = root_order.data();
+	init_box();
+}
+
+FLazyBVH_Node::FLazyBVH_Node(const shared_ptr<const FObjects>& objects, const uint32_t* first, size_t count, FReal time0, FReal time1)
+	: objects(objects)
+	, first(first)
+	, count(count)
+	, children(nullptr)
+	, time0(time0)
+	, time1(time1)
+{
+	init_box();
+}
+
+void FLazyBVH_Node::init_box()
+{
+	bool first_box = true;
+	for_each_primitive([&](const shared_ptr<FHittable>& object) {
+		FAABB temp_box;
+		if (!object->bounding_box(time0, time1, temp_box))
+		{
+			std::cerr << "No bounding box in lazy bvh_node constructor.\n";
+			return;
+		}
+
+		box = first_box ? temp_box : surrounding_box(box, temp_box);
+		first_box = false;
+	});
+}
+
+FLazyBVH_Node::~FLazyBVH_Node()
+{
+	delete children.load(std::memory_order_relaxed);
+}
+
+const FLazyBVH_Node::FChildren* FLazyBVH_Node::build() const
+{
+	FChildren* built = new FChildren();
+
+	if (count <= MAX_HITTABLES_IN_LEAF)
+	{
+		FObjects leaf;
+		for_each_primitive([&](const shared_ptr<FHittable>& object) { leaf.push_back(object); });
+		built->left = make_leaf(leaf.begin(), leaf.end());
+	}
+	else
+	{
+		// split a private copy of the indices, other threads may be building
+		// this node too. the children share it once it is published
+		built->order.assign(first, first + count);
+		const FObjects& all = *objects;
+		int axis = box.longest_axies();
+		std::sort(built->order.begin(), built->order.end(), [&all, axis](uint32_t a, uint32_t b) {
+			return box_compare(all[a], all[b], axis);
+		});
+
+		const size_t mid = count / 2;
+		built->left = shared_ptr<FLazyBVH_Node>(new FLazyBVH_Node(objects, built->order.data(), mid, time0, time1));
+		built->right = shared_ptr<FLazyBVH_Node>(new FLazyBVH_Node(objects, built->order.data() + mid, count - mid, time0, time1));
+	}
+
+	FChildren* expected = nullptr;
+	if (!children.compare_exchange_strong(expected, built, std::memory_order_acq_rel, std::memory_order_acquire))
+	{
+		// someone else published first
+		delete built;
+		return expected;
+	}
+
+	return built;
+}
+
+bool FLazyBVH_Node::intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const
+{
+	if (!box.hit(ray, t_min, t_max))
+		return false;
+
+	const FChildren* nodes = children.load(std::memory_order_acquire);
+	if (!nodes)
+	{
+		nodes = build();
+	}
+
+	bool hit_left = nodes->left->intersect(ray, t_min, t_max, outHit);
+	bool hit_right = nodes->right ? nodes->right->intersect(ray, t_min, (hit_left ? outHit.t : t_max), outHit) : false;
+
+	return hit_left || hit_right;
+}
+
+bool FLazyBVH_Node::occluded(const FRay& ray, FReal t_min, FReal t_max, FReal& transmittance) const
+{
+	if (!box.hit(ray, t_min, t_max))
+		return false;
+
+	const FChildren* nodes = children.load(std::memory_order_acquire);
+	if (!nodes)
+	{
+		nodes = build();
+	}
+
+	return nodes->left->occluded(ray, t_min, t_max, transmittance) || (nodes->right && nodes->right->occluded(ray, t_min, t_max, transmittance));
+}
+
+uint32_t FLazyBVH_Node::intersect_packet(const FRayPacket& packet, FReal t_min, FReal* t_max, FHitRecord* recs) const
+{
+	if (!packet.coherent)
+		return FHittable::intersect_packet(packet, t_min, t_max, recs);
+
+	if (!packet.hit_box(box, t_min, t_max))
+		return 0;
+
+	const FChildren* nodes = children.load(std::memory_order_acquire);
+	if (!nodes)
+	{
+		nodes = build();
+	}
+
+	uint32_t hits = nodes->left->intersect_packet(packet, t_min, t_max, recs);
+	if (nodes->right)
+	{
+		hits |= nodes->right->intersect_packet(packet, t_min, t_max, recs);
+	}
+	return hits;
+}
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <atomic>
 #include "basic.h"
 #include "hittable.h"
 #include "hittable_list.h"
@@ -18,15 +19,17 @@ class FBVH_Node : public FHittable
 public:
 	FBVH_Node();
 
-	FBVH_Node(FHittableList &list, double time0, double time1)
+	FBVH_Node(FHittableList &list, FReal time0, FReal time1)
 		: FBVH_Node(list.objects, 0, list.objects.size(), time0, time1)
 	{}
 
 	// [start, end)
-	FBVH_Node(std::vector<shared_ptr<FHittable>>& objects, size_t start, size_t end, double time0, double time1);
+	FBVH_Node(std::vector<shared_ptr<FHittable>>& objects, size_t start, size_t end, FReal time0, FReal time1);
 
-	virtual bool hit(const FRay& ray, double t_min, double t_max, FHitRecord& outHit) const;
-	virtual bool bounding_box(double t0, double t1, FAABB& outbox) const
+	virtual bool intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const;
+	virtual uint32_t intersect_packet(const FRayPacket& packet, FReal t_min, FReal* t_max, FHitRecord* recs) const;
+	virtual bool occluded(const FRay& ray, FReal t_min, FReal t_max, FReal& transmittance) const;
+	virtual bool bounding_box(FReal t0, FReal t1, FAABB& outbox) const
 	{
 		outbox = box;
 		return true;
@@ -37,3 +40,67 @@ public:
 	shared_ptr<FHittable> right;
 	FAABB box;
 };
+
+
+// lazily built bvh node
+// the node keeps its primitive range unsplit until a ray first enters its box,
+// then builds the children and publishes them with a CAS, so concurrent
+// tracers never block; a losing builder just throws its copy away.
+// the primitives are copied once into an array shared by the whole tree, a
+// node names its own by indices. a built node keeps its indices sorted on the
+// split axis, and its children point into them, so the tree holds one index
+// per primitive for every level built so far.
+class FLazyBVH_Node : public FHittable
+{
+public:
+	FLazyBVH_Node(FHittableList& list, FReal time0, FReal time1)
+		: FLazyBVH_Node(list.objects, 0, list.objects.size(), time0, time1)
+	{}
+
+	// [start, end)
+	FLazyBVH_Node(const std::vector<shared_ptr<FHittable>>& objects, size_t start, size_t end, FReal time0, FReal time1);
+	virtual ~FLazyBVH_Node();
+
+	virtual bool intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const;
+	virtual uint32_t intersect_packet(const FRayPacket& packet, FReal t_min, FReal* t_max, FHitRecord* recs) const;
+	virtual bool occluded(const FRay& ray, FReal t_min, FReal t_max, FReal& transmittance) const;
+	virtual bool bounding_box(FReal t0, FReal t1, FAABB& outbox) const
+	{
+		outbox = box;
+		return true;
+	}
+
+	bool is_built() const { return children.load(std::memory_order_acquire) != nullptr; }
+
+	template<typename FFunc>
+	void for_each_primitive(FFunc func) const
+	{
+		for (size_t i = 0; i < count; i++) func((*objects)[first[i]]);
+	}
+
+protected:
+	typedef std::vector<shared_ptr<FHittable>> FObjects;
+
+	struct FChildren
+	{
+		std::vector<uint32_t> order;  // indices of the node sorted on the split axis
+		shared_ptr<FHittable> left;
+		shared_ptr<FHittable> right;
+	};
+
+	// count indices from first, owned by the parent
+	FLazyBVH_Node(const shared_ptr<const FObjects>& objects, const uint32_t* first, size_t count, FReal time0, FReal time1);
+
+	void init_box();
+	const FChildren* build() const;
+
+protected:
+	shared_ptr<const FObjects> objects;  // primitives of the whole tree
+	std::vector<uint32_t> root_order;    // indices of the root, empty below it
+	const uint32_t* first;               // unsplit primitive range
+	size_t count;
+	mutable std::atomic<FChildren*> children;
+	FReal time0;
+	FReal time1;
+	FAABB box;
+};
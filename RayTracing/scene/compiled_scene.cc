@@ -0,0 +1,274 @@
+// compiled scene
+//
+//
+
+#include <algorithm>
+#include <numeric>
+#include <typeinfo>
+#include "compiled_scene.h"
+#include "hittable_list.h"
+#include "bvh.h"
+#include "sphere_set.h"
+
+
+// max primitives in a leaf
+static const size_t kMaxLeafSize = 4;
+
+// the by-value types are called non-virtually and inline, sphere sets
+// non-virtually, the rest through the vtable
+static inline bool intersect_primitive(const FCompiledPrimitive& prim, const FRay& ray, FReal t_min, FReal t_max, FHitRecord& rec)
+{
+	return std::visit([&](const auto& p) -> bool {
+		using T = std::decay_t<decltype(p)>;
+		if constexpr (std::is_same_v<T, const FHittable*>)
+			return p->intersect(ray, t_min, t_max, rec);
+		else if constexpr (std::is_same_v<T, const FSphereSet*>)
+			return p->FSphereSet::intersect(ray, t_min, t_max, rec);
+		else
+			return p.T::intersect(ray, t_min, t_max, rec);
+	}, prim);
+}
+
+// FHittable::occluded() of a primitive, only the pointer ones can be media
+static inline bool occluded_primitive(const FCompiledPrimitive& prim, const FRay& ray, FReal t_min, FReal t_max, FReal& transmittance)
+{
+	if (const FHittable* const* p = std::get_if<const FHittable*>(&prim))
+		return (*p)->occluded(ray, t_min, t_max, transmittance);
+
+	FHitRecord rec;
+	return intersect_primitive(prim, ray, t_min, t_max, rec);
+}
+
+// slab test with the reciprocal direction computed once per ray
+static inline bool hit_box(const FAABB& box, const FReal* origin, const FReal* inv_dir, FReal t_min, FReal t_max)
+{
+	for (int a = 0; a < 3; a++)
+	{
+		FReal t0 = (box.min()[a] - origin[a]) * inv_dir[a];
+		FReal t1 = (box.max()[a] - origin[a]) * inv_dir[a];
+		if (inv_dir[a] < 0)
+			std::swap(t0, t1);
+
+		t_min = t0 > t_min ? t0 : t_min;
+		t_max = t1 < t_max ? t1 : t_max;
+		if (t_max <= t_min)
+			return false;
+	}
+	return true;
+}
+
+static inline FPoint3 centroid(const FAABB& box)
+{
+	return 0.5 * (box.min() + box.max());
+}
+
+
+FCompiledScene::FCompiledScene(const shared_ptr<FHittable>& InRoot, FReal InTime0, FReal InTime1)
+	: root(InRoot)
+	, time0(InTime0)
+	, time1(InTime1)
+{
+	flatten(root);
+
+	std::vector<uint32_t> order(primitives.size());
+	std::iota(order.begin(), order.end(), 0);
+
+	// primitives are stored in leaf order
+	std::vector<FCompiledPrimitive> sorted;
+	sorted.reserve(primitives.size());
+	if (!primitives.empty())
+	{
+		build(order, 0, order.size(), sorted);
+	}
+	primitives.swap(sorted);
+	prim_boxes.clear();
+	prim_boxes.shrink_to_fit();
+}
+
+void FCompiledScene::flatten(const shared_ptr<FHittable>& obj)
+{
+	// exact types only, a subclass may override intersect()
+	const FHittable* p = obj.get();
+	const std::type_info& type = typeid(*p);
+
+	if (type == typeid(FHittableList))
+	{
+		for (const shared_ptr<FHittable>& child : static_cast<const FHittableList*>(p)->objects)
+			flatten(child);
+	}
+	else if (type == typeid(FBVH_Node))
+	{
+		const FBVH_Node* node = static_cast<const FBVH_Node*>(p);
+		flatten(node->left);
+		if (node->right)
+			flatten(node->right);
+	}
+	else if (type == typeid(FLazyBVH_Node))
+	{
+		static_cast<const FLazyBVH_Node*>(p)->for_each_primitive([&](const shared_ptr<FHittable>& child) { flatten(child); });
+	}
+	else if (type == typeid(FSphere))			add(*static_cast<const FSphere*>(p), obj);
+	else if (type == typeid(FMovingSphere))		add(*static_cast<const FMovingSphere*>(p), obj);
+	else if (type == typeid(FXYRect))			add(*static_cast<const FXYRect*>(p), obj);
+	else if (type == typeid(FXZRect))			add(*static_cast<const FXZRect*>(p), obj);
+	else if (type == typeid(FYZRect))			add(*static_cast<const FYZRect*>(p), obj);
+	else if (type == typeid(FSphereSet))		add(static_cast<const FSphereSet*>(p), obj);
+	else										add(p, obj);
+}
+
+void FCompiledScene::add(const FCompiledPrimitive& prim, const shared_ptr<FHittable>& obj)
+{
+	FAABB box;
+	if (!obj->bounding_box(time0, time1, box))
+	{
+		unbounded.push_back(prim);
+		return;
+	}
+
+	primitives.push_back(prim);
+	prim_boxes.push_back(box);
+}
+
+// median split on the longest axis of the centroids, returns the node index
+uint32_t FCompiledScene::build(std::vector<uint32_t>& order, size_t start, size_t end, std::vector<FCompiledPrimitive>& sorted)
+{
+	const uint32_t index = static_cast<uint32_t>(nodes.size());
+	nodes.push_back(FNode());
+
+	FAABB box = prim_boxes[order[start]];
+	FAABB centroids(centroid(box), centroid(box));
+	for (size_t i = start + 1; i < end; i++)
+	{
+		const FAABB& prim_box = prim_boxes[order[i]];
+		const FPoint3 c = centroid(prim_box);
+		box = surrounding_box(box, prim_box);
+		centroids = surrounding_box(centroids, FAABB(c, c));
+	}
+
+	if (end - start <= kMaxLeafSize)
+	{
+		FNode& leaf = nodes[index];
+		leaf.box = box;
+		leaf.offset = static_cast<uint32_t>(sorted.size());
+		leaf.count = static_cast<uint16_t>(end - start);
+		leaf.axis = 0;
+		for (size_t i = start; i < end; i++)
+		{
+			sorted.push_back(primitives[order[i]]);
+		}
+		return index;
+	}
+
+	const int axis = centroids.longest_axies();
+	const size_t mid = start + (end - start) / 2;
+	std::nth_element(order.begin() + start, order.begin() + mid, order.begin() + end, [&](uint32_t a, uint32_t b) {
+		return centroid(prim_boxes[a])[axis] < centroid(prim_boxes[b])[axis];
+	});
+
+	build(order, start, mid, sorted);
+	const uint32_t right = build(order, mid, end, sorted);
+
+	FNode& node = nodes[index];
+	node.box = box;
+	node.offset = right;
+	node.count = 0;
+	node.axis = static_cast<uint16_t>(axis);
+	return index;
+}
+
+template<typename FVisit>
+void FCompiledScene::traverse(const FRay& ray, FReal t_min, const FReal& t_max, FVisit visit) const
+{
+	if (nodes.empty())
+		return;
+
+	const FReal origin[3] = { ray.Origin().x(), ray.Origin().y(), ray.Origin().z() };
+	const FReal inv_dir[3] = { 1 / ray.Direction().x(), 1 / ray.Direction().y(), 1 / ray.Direction().z() };
+
+	uint32_t stack[64];
+	int top = 0;
+	uint32_t current = 0;
+	while (true)
+	{
+		const FNode& node = nodes[current];
+		if (hit_box(node.box, origin, inv_dir, t_min, t_max))
+		{
+			if (node.count == 0)
+			{
+				// near child first: the right one holds the larger centroids
+				if (inv_dir[node.axis] < 0)
+				{
+					stack[top++] = current + 1;
+					current = node.offset;
+				}
+				else
+				{
+					stack[top++] = node.offset;
+					current = current + 1;
+				}
+				continue;
+			}
+
+			for (uint32_t i = node.offset; i < node.offset + node.count; i++)
+			{
+				if (!visit(primitives[i]))
+					return;
+			}
+		}
+
+		if (top == 0)
+			break;
+		current = stack[--top];
+	}
+}
+
+bool FCompiledScene::intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const
+{
+	bool hit_anything = false;
+	auto visit = [&](const FCompiledPrimitive& prim) {
+		if (intersect_primitive(prim, ray, t_min, t_max, outHit))
+		{
+			hit_anything = true;
+			t_max = outHit.t;
+		}
+		return true;
+	};
+
+	for (const FCompiledPrimitive& prim : unbounded)
+		visit(prim);
+	traverse(ray, t_min, t_max, visit);
+	return hit_anything;
+}
+
+bool FCompiledScene::occluded(const FRay& ray, FReal t_min, FReal t_max, FReal& transmittance) const
+{
+	bool blocked = false;
+	auto visit = [&](const FCompiledPrimitive& prim) {
+		blocked = occluded_primitive(prim, ray, t_min, t_max, transmittance);
+		return !blocked;
+	};
+
+	for (const FCompiledPrimitive& prim : unbounded)
+	{
+		if (!visit(prim))
+			return true;
+	}
+	traverse(ray, t_min, t_max, visit);
+	return blocked;
+}
+
+bool FCompiledScene::bounding_box(FReal t0, FReal t1, FAABB& outbox) const
+{
+	if (nodes.empty() || !unbounded.empty())
+		return false;
+
+	outbox = nodes[0].box;
+	return true;
+}
+
+size_t FCompiledScene::num_fallbacks() const
+{
+	auto is_fallback = [](const FCompiledPrimitive& prim) { return std::holds_alternative<const FHittable*>(prim); };
+	return std::count_if(primitives.begin(), primitives.end(), is_fallback)
+		+ std::count_if(unbounded.begin(), unbounded.end(), is_fallback);
+}
@@ -0,0 +1,75 @@
+// compiled scene
+// closed-world copy of a scene for rendering. lists and bvh nodes are
+// flattened into one node array, the known primitive types are stored by
+// value in a variant and tested through a switch, so traversal and the
+// primitive tests inline into one loop without virtual calls. any other
+// hittable (instances, boxes, meshes, media, user types) is kept by pointer
+// and called through its virtual interface.
+//
+
+#pragma once
+
+#include <variant>
+#include <vector>
+#include "hittable.h"
+#include "sphere.h"
+#include "moving_sphere.h"
+#include "aarect.h"
+
+class FSphereSet;
+
+
+using FCompiledPrimitive = std::variant<FSphere, FMovingSphere, FXYRect, FXZRect, FYZRect, const FSphereSet*, const FHittable*>;
+
+class FCompiledScene : public FHittable
+{
+public:
+	// root is kept alive, pointer primitives point into it
+	FCompiledScene(const shared_ptr<FHittable>& root, FReal time0, FReal time1);
+
+	virtual bool intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const override;
+	virtual bool occluded(const FRay& ray, FReal t_min, FReal t_max, FReal& transmittance) const override;
+	virtual bool bounding_box(FReal t0, FReal t1, FAABB& outbox) const override;
+
+	size_t num_primitives() const { return primitives.size(); }
+	size_t num_fallbacks() const;
+	size_t num_nodes() const { return nodes.size(); }
+
+	template<typename FFunc>
+	void for_each_primitive(FFunc func) const
+	{
+		for (const FCompiledPrimitive& prim : primitives) func(prim);
+		for (const FCompiledPrimitive& prim : unbounded) func(prim);
+	}
+
+protected:
+	// inner nodes: left child follows the node, right child at offset
+	// leaves: count primitives from offset
+	struct FNode
+	{
+		FAABB		box;
+		uint32_t	offset;
+		uint16_t	count;
+		uint16_t	axis;
+	};
+
+	void flatten(const shared_ptr<FHittable>& obj);
+	void add(const FCompiledPrimitive& prim, const shared_ptr<FHittable>& obj);
+	uint32_t build(std::vector<uint32_t>& order, size_t start, size_t end, std::vector<FCompiledPrimitive>& sorted);
+
+	// calls visit(prim) for the primitives of the leaves ray enters within
+	// [t_min, t_max], near leaves first. t_max may shrink while it runs,
+	// visit returns false to stop
+	template<typename FVisit>
+	void traverse(const FRay& ray, FReal t_min, const FReal& t_max, FVisit visit) const;
+
+protected:
+	shared_ptr<FHittable> root;
+	FReal time0;
+	FReal time1;
+
+	std::vector<FCompiledPrimitive> primitives;
+	std::vector<FAABB> prim_boxes;                   // build only
+	std::vector<FCompiledPrimitive> unbounded;       // no bounding box, tested by every ray
+	std::vector<FNode> nodes;
+};
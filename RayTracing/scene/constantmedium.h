@@ -5,61 +5,86 @@
 #include "hittable.h"
 #include "material.h"
 #include "texture.h"
+#include "sampler.h"
 
 
 // constant medium
 class FConstantMedium : public FHittable
 {
 public:
-	FConstantMedium(const shared_ptr<FHittable>& b, double density, const shared_ptr<FTexture>& a)
+	FConstantMedium(const shared_ptr<FHittable>& b, FReal density, const shared_ptr<FTexture>& a)
 		: boundary(b)
 		, neg_inv_density(-1.0 / density)
 	{
 		phase_function = make_shared<FIsotropic>(a);
+		has_box = boundary->bounding_box(0, 1, box);
 	}
 
-	virtual bool hit(const FRay& ray, double t_min, double t_max, FHitRecord& rec) const
+	virtual bool intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& rec) const
 	{
-		FHitRecord rec1, rec2;
-
-		if (!boundary->hit(ray, -kInfinity, kInfinity, rec1))
-			return false;
-
-		if (!boundary->hit(ray, rec1.t + 0.0001, kInfinity, rec2))
+		FReal t_enter, t_exit;
+		if (!inside(ray, t_min, t_max, t_enter, t_exit))
 			return false;
 
-		if (rec1.t < t_min) rec1.t = t_min;
-		if (rec2.t > t_max) rec2.t = t_max;
-
-		if (rec1.t >= rec2.t)
-			return false;
-
-		if (rec1.t < 0.0) rec1.t = 0.0;
-
 		const auto ray_length = ray.Direction().length();
-		const auto distance_inside_boundary = (rec2.t - rec1.t) * ray_length;
-		const auto hit_distance = neg_inv_density * log(random_double());
+		const auto distance_inside_boundary = (t_exit - t_enter) * ray_length;
+		const auto hit_distance = neg_inv_density * log(1 - sample_medium_1d());
 
 		if (hit_distance > distance_inside_boundary)
 			return false;
 
-		rec.t = rec1.t + hit_distance / ray_length;
+		rec.set_hit(t_enter + hit_distance / ray_length, this);
+		return true;
+	}
+
+	// never opaque, lets exp(-density * distance) through
+	virtual bool occluded(const FRay& ray, FReal t_min, FReal t_max, FReal& transmittance) const
+	{
+		FReal t_enter, t_exit;
+		if (inside(ray, t_min, t_max, t_enter, t_exit))
+			transmittance *= exp((t_exit - t_enter) * ray.Direction().length() / neg_inv_density);
+		return false;
+	}
+
+	virtual void surface(const FRay& ray, FHitRecord& rec) const
+	{
 		rec.p = ray.At(rec.t);
 
-		rec.normal = FVec3(1, 0, 0);  // arbitrary
+		rec.normal = FVec3(0, 0, 0);  // none inside a medium, spawned rays start at p
 		rec.front_face = true;     // also arbitrary
-		rec.mat_ptr = phase_function;
-
-		return true;
+		rec.mat_ptr = phase_function.get();
 	}
 
-	virtual bool bounding_box(double t0, double t1, FAABB& outbox) const
+	virtual bool bounding_box(FReal t0, FReal t1, FAABB& outbox) const
 	{
 		return boundary->bounding_box(t0, t1, outbox);
 	}
 
+protected:
+	// the part of [t_min, t_max] inside the boundary
+	bool inside(const FRay& ray, FReal t_min, FReal t_max, FReal& t_enter, FReal& t_exit) const
+	{
+		// the boundary is searched from -infinity, rays missing its box skip that
+		if (has_box && !box.hit(ray, t_min, t_max))
+			return false;
+
+		FHitRecord rec1, rec2;
+
+		if (!boundary->intersect(ray, -kInfinity, kInfinity, rec1))
+			return false;
+
+		if (!boundary->intersect(ray, rec1.t + 0.0001, kInfinity, rec2))
+			return false;
+
+		t_enter = std::max(rec1.t, std::max(t_min, FReal(0)));
+		t_exit = std::min(rec2.t, t_max);
+		return t_enter < t_exit;
+	}
+
 protected:
 	shared_ptr<FHittable> boundary;
 	shared_ptr<FMaterial> phase_function;
-	double neg_inv_density;
+	FReal neg_inv_density;
+	FAABB box;
+	bool has_box = false;
 };
@@ -0,0 +1,104 @@
+// environment light
+//
+//
+
+#include <iostream>
+#include "environment.h"
+#include "external/stb_image.h"
+
+
+FEnvironment::FEnvironment(const char* filename, FReal scale, FReal rotation_degrees)
+	: rotation(rotation_degrees * kPiOver180)
+{
+	int components = 3;
+	float* data = stbi_loadf(filename, &width, &height, &components, 3);
+	if (!data)
+	{
+		std::cerr << "ERROR: Could not load environment image file " << filename << ".\n";
+		width = height = 0;
+		return;
+	}
+
+	pixels.assign(data, data + size_t(width) * height * 3);
+	stbi_image_free(data);
+	build(scale);
+}
+
+FEnvironment::FEnvironment(int w, int h, const std::vector<float>& rgb, FReal scale, FReal rotation_degrees)
+	: width(w), height(h), pixels(rgb), rotation(rotation_degrees * kPiOver180)
+{
+	build(scale);
+}
+
+void FEnvironment::build(FReal scale)
+{
+	for (float& c : pixels)
+		c = float(c * scale);
+
+	// a row at polar angle theta covers sin(theta) of the solid angle of the
+	// equator row, the distribution is over the image rectangle
+	std::vector<FReal> weights(size_t(width) * height);
+	double sum = 0.0;
+	for (int j = 0; j < height; j++)
+	{
+		const FReal sin_theta = sin(kPi * (j + 0.5) / height);
+		for (int i = 0; i < width; i++)
+		{
+			const float* p = &pixels[(size_t(j) * width + i) * 3];
+			const FReal y = std::max(luminance(FColor3(p[0], p[1], p[2])), FReal(0));
+			weights[size_t(j) * width + i] = y * sin_theta;
+			sum += y * sin_theta;
+		}
+	}
+	distribution = FDistribution2D(weights.data(), width, height);
+
+	// integral over the sphere is 2 pi^2 times the mean weight
+	average = FReal(2 * kPi * kPi * (sum / weights.size()) / (4 * kPi));
+}
+
+void FEnvironment::direction_to_uv(const FVec3& dir, FReal& u, FReal& v) const
+{
+	const FVec3 d = unit_vector(dir);
+	const FReal theta = acos(clamp(d.y(), -1.0, 1.0));
+	FReal phi = atan2(d.x(), -d.z()) + rotation;
+	u = phi / kTwoPi + 0.5;
+	u -= floor(u);
+	v = theta / kPi;
+}
+
+const float* FEnvironment::pixel(FReal u, FReal v) const
+{
+	const int i = std::min(int(u * width), width - 1);
+	const int j = std::min(int(v * height), height - 1);
+	return &pixels[(size_t(j) * width + i) * 3];
+}
+
+FColor3 FEnvironment::eval(const FVec3& dir) const
+{
+	FReal u, v;
+	direction_to_uv(dir, u, v);
+	const float* p = pixel(u, v);
+	return FColor3(p[0], p[1], p[2]);
+}
+
+FVec3 FEnvironment::sample(FReal u0, FReal u1, FReal& pdf) const
+{
+	FReal u, v, pdf_uv;
+	distribution.sample(u0, u1, u, v, pdf_uv);
+
+	const FReal theta = v * kPi;
+	const FReal phi = (u - 0.5) * kTwoPi - rotation;
+	const FReal sin_theta = sin(theta);
+
+	// d omega = sin(theta) d theta d phi = 2 pi^2 sin(theta) du dv
+	pdf = sin_theta > 0 ? pdf_uv / (2 * kPi * kPi * sin_theta) : FReal(0);
+	return FVec3(sin_theta * sin(phi), cos(theta), -sin_theta * cos(phi));
+}
+
+FReal FEnvironment::pdf(const FVec3& dir) const
+{
+	FReal u, v;
+	direction_to_uv(dir, u, v);
+	const FReal sin_theta = sin(v * kPi);
+	return sin_theta > 0 ? distribution.pdf(u, v) / (2 * kPi * kPi * sin_theta) : FReal(0);
+}
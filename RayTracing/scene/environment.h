@@ -0,0 +1,68 @@
+// environment light
+// radiance arriving from infinitely far away, read from an equirectangular
+// (latitude-longitude) image, usually a captured .hdr. the top row looks up
+// (+y), the middle column towards -z, columns run clockwise seen from above.
+// directions are importance sampled from a piecewise constant distribution of
+// the pixel luminances weighted by the solid angle they cover.
+//
+// integrators see it through the FBackground they are given, a light list
+// given one samples it as one more light.
+//
+
+#pragma once
+
+#include <vector>
+#include "basic.h"
+#include "vec3.h"
+#include "color.h"
+#include "distribution.h"
+
+
+class FEnvironment
+{
+public:
+	// image loaded with stb_image, .hdr keeps its range. scale multiplies the
+	// radiance, rotation turns the map around +y, in degrees
+	FEnvironment(const char* filename, FReal scale = 1, FReal rotation = 0);
+	// width x height rgb triplets, top row first
+	FEnvironment(int width, int height, const std::vector<float>& rgb, FReal scale = 1, FReal rotation = 0);
+
+	bool valid() const { return width > 0; }
+
+	// radiance arriving along -dir, dir need not be normalized
+	FColor3 eval(const FVec3& dir) const;
+
+	// unit direction towards the environment and its solid angle pdf
+	FVec3 sample(FReal u0, FReal u1, FReal& pdf) const;
+	FReal pdf(const FVec3& dir) const;
+
+	// luminance averaged over all directions
+	FReal mean_luminance() const { return average; }
+
+private:
+	void build(FReal scale);
+	void direction_to_uv(const FVec3& dir, FReal& u, FReal& v) const;
+	const float* pixel(FReal u, FReal v) const;
+
+	int width = 0;
+	int height = 0;
+	std::vector<float> pixels;  // rgb, top row first
+	FReal rotation = 0;         // radians
+	FReal average = 0;
+	FDistribution2D distribution;
+};
+
+// what a ray leaving the scene sees: the environment when there is one, the
+// background color otherwise. a color converts to one without environment
+struct FBackground
+{
+	FBackground(const FColor3& InColor, const FEnvironment* InEnvironment = nullptr)
+		: color(InColor), environment(InEnvironment)
+	{}
+
+	// radiance arriving along -dir
+	FColor3 eval(const FVec3& dir) const { return environment ? environment->eval(dir) : color; }
+
+	FColor3 color;
+	const FEnvironment* environment;
+};
@@ -4,7 +4,21 @@
 #include "hittable.h"
 
 
-FRotateY::FRotateY(const shared_ptr<FHittable>& p, double angle)
+uint32_t FHittable::intersect_packet(const FRayPacket& packet, FReal t_min, FReal* t_max, FHitRecord* recs) const
+{
+	uint32_t hits = 0;
+	for (int i = 0; i < packet.count; i++)
+	{
+		if (intersect(packet.rays[i], t_min, t_max[i], recs[i]))
+		{
+			t_max[i] = recs[i].t;
+			hits |= 1u << i;
+		}
+	}
+	return hits;
+}
+
+FRotateY::FRotateY(const shared_ptr<FHittable>& p, FReal angle)
 	: ptr(p)
 {
 	auto radians = degrees_2_radians(angle);
@@ -38,7 +52,7 @@ FRotateY::FRotateY(const shared_ptr<FHittable>& p, double angle)
 	bbox = FAABB(min, max);
 }
 
-bool FRotateY::hit(const FRay& ray, double t_min, double t_max, FHitRecord& outHit) const
+FRay FRotateY::to_local(const FRay& ray) const
 {
 	const FPoint3 &origin = ray.Origin();
 	const FVec3 &direction = ray.Direction();
@@ -51,22 +65,36 @@ bool FRotateY::hit(const FRay& ray, double t_min, double t_max, FHitRecord& outH
 	local_dir[0] = cos_theta * direction[0] - sin_theta * direction[2];
 	local_dir[2] = sin_theta * direction[0] + cos_theta * direction[2];
 
-	FRay rotated_r(local_origin, local_dir, ray.Time());
+	return FRay(local_origin, local_dir, ray.Time());
+}
 
-	if (!ptr->hit(rotated_r, t_min, t_max, outHit))
+bool FRotateY::intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const
+{
+	if (!ptr->intersect(to_local(ray), t_min, t_max, outHit))
 		return false;
 
-	FPoint3 p = outHit.p;
-	FVec3 normal = outHit.normal;
+	defer_instance(ray, outHit);
+	return true;
+}
 
-	p[0] = cos_theta * outHit.p[0] + sin_theta * outHit.p[2];
-	p[2] = -sin_theta * outHit.p[0] + cos_theta * outHit.p[2];
+bool FRotateY::occluded(const FRay& ray, FReal t_min, FReal t_max, FReal& transmittance) const
+{
+	return ptr->occluded(to_local(ray), t_min, t_max, transmittance);
+}
 
-	normal[0] = cos_theta * outHit.normal[0] + sin_theta * outHit.normal[2];
-	normal[2] = -sin_theta * outHit.normal[0] + cos_theta * outHit.normal[2];
+void FRotateY::surface(const FRay& ray, FHitRecord& rec) const
+{
+	resolve_surface(to_local(ray), rec);
 
-	outHit.p = p;
-	outHit.normal = normal;
+	FPoint3 p = rec.p;
+	FVec3 normal = rec.normal;
 
-	return true;
+	p[0] = cos_theta * rec.p[0] + sin_theta * rec.p[2];
+	p[2] = -sin_theta * rec.p[0] + cos_theta * rec.p[2];
+
+	normal[0] = cos_theta * rec.normal[0] + sin_theta * rec.normal[2];
+	normal[2] = -sin_theta * rec.normal[0] + cos_theta * rec.normal[2];
+
+	rec.p = p;
+	rec.normal = normal;
 }
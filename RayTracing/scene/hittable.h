@@ -8,33 +8,133 @@
 #include "vec3.h"
 #include "ray.h"
 #include "aabb.h"
+#include "ray_packet.h"
 
 
 class FMaterial;
+class FHittable;
+
+// max nested instances (translate, rotate, ...) a hit can be deferred through
+const int kMaxInstanceDepth = 8;
 
 struct FHitRecord
 {
 	FPoint3	p;
-	FVec3	normal;
-	shared_ptr<FMaterial> mat_ptr;
-	double  t;
-	double u;   // texture coordination <u,v>
-	double v;
+	FVec3	normal;     // zero at a scattering point inside a medium
+	const FMaterial* mat_ptr = nullptr;  // owned by the scene
+	FReal  t;
+	FReal u;   // texture coordination <u,v>
+	FReal v;
 	bool	front_face;
 
+	// filled by intersect(), consumed by surface()
+	const FHittable* obj_ptr = nullptr;  // primitive hit, nullptr once the surface is evaluated
+	int		prim_id = 0;                 // primitive index inside obj_ptr
+	int		inst_depth = 0;
+	const FHittable* inst_stack[kMaxInstanceDepth];  // instances the hit was found through, innermost first
+
 	inline void set_face_normal(const FRay& ray, const FVec3& outward_normal)
 	{
 		front_face = dot(ray.Direction(), outward_normal) < 0;
 		normal = front_face ? outward_normal : -outward_normal;
 	}
+
+	// ray leaving the surface in dir, started off the side dir points to
+	inline FRay spawn_ray(const FVec3& dir, FReal time) const
+	{
+		return FRay(offset_ray_origin(p, dot(dir, normal) > 0 ? normal : -normal), dir, time);
+	}
+
+	// called by primitives accepting a closer hit
+	inline void set_hit(FReal hit_t, const FHittable* obj, int prim = 0)
+	{
+		t = hit_t;
+		obj_ptr = obj;
+		prim_id = prim;
+		inst_depth = 0;
+	}
+
+	inline bool push_instance(const FHittable* inst)
+	{
+		if (inst_depth == kMaxInstanceDepth)
+			return false;
+
+		inst_stack[inst_depth++] = inst;
+		return true;
+	}
 };
 
 // abstract hittable
-class FHittable 
+// intersect() only finds the closest t and the primitive, surface() then
+// computes point, normal, uv and material once for the final hit.
+class FHittable
 {
 public:
-	virtual bool hit(const FRay &ray, double t_min, double t_max, FHitRecord &outHit) const = 0;
-	virtual bool bounding_box(double t0, double t1, FAABB& outbox) const = 0;
+	virtual bool intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const = 0;
+	virtual bool bounding_box(FReal t0, FReal t1, FAABB& outbox) const = 0;
+
+	// closest hits of a packet of rays. t_max and recs hold kPacketSize entries,
+	// t_max[i] bounds ray i and is lowered
+	// to each hit found, bit i of the result is set when ray i hit. the
+	// default traces ray by ray, aggregates override it to cull whole packets
+	virtual uint32_t intersect_packet(const FRayPacket& packet, FReal t_min, FReal* t_max, FHitRecord* recs) const;
+
+	// shadow query: true when something opaque lies on ray in [t_min, t_max],
+	// otherwise media along it multiply transmittance by what they let
+	// through. the default counts any hit as opaque, aggregates and instances
+	// pass the query on to their children
+	virtual bool occluded(const FRay& ray, FReal t_min, FReal t_max, FReal& transmittance) const
+	{
+		FHitRecord rec;
+		return intersect(ray, t_min, t_max, rec);
+	}
+
+	// evaluates the hit found by intersect(). ray is in the space of the
+	// object, instances transform it and resolve the hit below them
+	virtual void surface(const FRay& ray, FHitRecord& rec) const {}
+
+	// area light sampling, for primitives that can be lights
+	// pdf per solid angle, seen from origin, of sampling direction dir
+	virtual FReal pdf_value(const FPoint3& origin, const FVec3& dir) const { return 0.0; }
+	// direction from origin towards a random point of the object, not normalized
+	virtual FVec3 random(const FPoint3& origin) const { return FVec3(1, 0, 0); }
+
+	// intersect + surface
+	bool hit(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const
+	{
+		if (!intersect(ray, t_min, t_max, outHit))
+			return false;
+
+		resolve_surface(ray, outHit);
+		return true;
+	}
+
+	// evaluates the surface of the last instance pushed, or of the primitive
+	static void resolve_surface(const FRay& ray, FHitRecord& rec)
+	{
+		if (rec.inst_depth > 0)
+		{
+			const FHittable* inst = rec.inst_stack[--rec.inst_depth];
+			inst->surface(ray, rec);
+		}
+		else if (rec.obj_ptr)
+		{
+			rec.obj_ptr->surface(ray, rec);
+			rec.obj_ptr = nullptr;
+		}
+	}
+
+protected:
+	// called by instances after the wrapped object accepted a hit. when the
+	// instance stack is full the hit is evaluated right away
+	void defer_instance(const FRay& ray, FHitRecord& rec) const
+	{
+		if (!rec.push_instance(this))
+		{
+			surface(ray, rec);
+			rec.obj_ptr = nullptr;
+		}
+	}
 };
 
 // flip face(normal)
@@ -43,20 +143,43 @@ class FFlipFace : public FHittable
 public:
 	FFlipFace(const shared_ptr<FHittable> &p) : ptr(p) {}
 
-	virtual bool hit(const FRay& ray, double t_min, double t_max, FHitRecord& outHit) const
+	virtual bool intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const
 	{
-		if (!ptr->hit(ray, t_min, t_max, outHit))
+		if (!ptr->intersect(ray, t_min, t_max, outHit))
 			return false;
 
-		outHit.front_face = !outHit.front_face;
+		defer_instance(ray, outHit);
 		return true;
 	}
 
-	virtual bool bounding_box(double t0, double t1, FAABB& outbox) const
+	virtual bool occluded(const FRay& ray, FReal t_min, FReal t_max, FReal& transmittance) const
+	{
+		return ptr->occluded(ray, t_min, t_max, transmittance);
+	}
+
+	virtual void surface(const FRay& ray, FHitRecord& rec) const
+	{
+		resolve_surface(ray, rec);
+		rec.front_face = !rec.front_face;
+	}
+
+	virtual bool bounding_box(FReal t0, FReal t1, FAABB& outbox) const
 	{
 		return ptr->bounding_box(t0, t1, outbox);
 	}
 
+	virtual FReal pdf_value(const FPoint3& origin, const FVec3& dir) const
+	{
+		return ptr->pdf_value(origin, dir);
+	}
+
+	virtual FVec3 random(const FPoint3& origin) const
+	{
+		return ptr->random(origin);
+	}
+
+	const FHittable* object() const { return ptr.get(); }
+
 protected:
 	shared_ptr<FHittable> ptr;
 };
@@ -65,21 +188,35 @@ protected:
 class FTranslate : public FHittable
 {
 public:
-	FTranslate(const shared_ptr<FHittable>& p, const FVec3 &displacement) 
+	FTranslate(const shared_ptr<FHittable>& p, const FVec3 &displacement)
 		: ptr(p), offset(displacement) {}
 
-	virtual bool hit(const FRay& ray, double t_min, double t_max, FHitRecord& outHit) const
+	virtual bool intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const
 	{
 		FRay local_ray(ray.Origin() - offset, ray.Direction(), ray.Time());
 
-		if (!ptr->hit(local_ray, t_min, t_max, outHit))
+		if (!ptr->intersect(local_ray, t_min, t_max, outHit))
 			return false;
 
-		outHit.p += offset;
+		defer_instance(ray, outHit);
 		return true;
 	}
 
-	virtual bool bounding_box(double t0, double t1, FAABB& outbox) const
+	virtual bool occluded(const FRay& ray, FReal t_min, FReal t_max, FReal& transmittance) const
+	{
+		FRay local_ray(ray.Origin() - offset, ray.Direction(), ray.Time());
+		return ptr->occluded(local_ray, t_min, t_max, transmittance);
+	}
+
+	virtual void surface(const FRay& ray, FHitRecord& rec) const
+	{
+		FRay local_ray(ray.Origin() - offset, ray.Direction(), ray.Time());
+
+		resolve_surface(local_ray, rec);
+		rec.p += offset;
+	}
+
+	virtual bool bounding_box(FReal t0, FReal t1, FAABB& outbox) const
 	{
 		if (!ptr->bounding_box(t0, t1, outbox))
 			return false;
@@ -97,20 +234,23 @@ protected:
 class FRotateY : public FHittable
 {
 public:
-	FRotateY(const shared_ptr<FHittable>& p, double angle);
+	FRotateY(const shared_ptr<FHittable>& p, FReal angle);
 
-	virtual bool hit(const FRay& ray, double t_min, double t_max, FHitRecord& outHit) const;
-	virtual bool bounding_box(double t0, double t1, FAABB& outbox) const
+	virtual bool intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const;
+	virtual bool occluded(const FRay& ray, FReal t_min, FReal t_max, FReal& transmittance) const;
+	virtual void surface(const FRay& ray, FHitRecord& rec) const;
+	virtual bool bounding_box(FReal t0, FReal t1, FAABB& outbox) const
 	{
 		outbox = bbox;
 		return bHasbox;
 	}
 
 protected:
+	FRay to_local(const FRay& ray) const;
+
 	shared_ptr<FHittable> ptr;
-	double sin_theta;
-	double cos_theta;
+	FReal sin_theta;
+	FReal cos_theta;
 	FAABB bbox;
 	bool bHasbox;
 };
-
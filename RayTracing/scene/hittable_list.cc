@@ -4,28 +4,46 @@
 
 #include "hittable_list.h"
 
-bool FHittableList::hit(const FRay& ray, double t_min, double t_max, FHitRecord& outHit) const
+bool FHittableList::intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const
 {
-	FHitRecord temp_hit;
+	// primitives only write the record on a hit, so the closest one so far
+	// can be kept in place
 	auto hit_any = false;
 	auto closest_sofar = t_max;
 
 	for (const auto &object : objects)
 	{
-		if (object->hit(ray, t_min, closest_sofar, temp_hit))
+		if (object->intersect(ray, t_min, closest_sofar, outHit))
 		{
 			hit_any = true;
-			closest_sofar = temp_hit.t;
+			closest_sofar = outHit.t;
 		}
 	} // end for 
 
-	if (hit_any) {
-		outHit = temp_hit;
-	}
 	return hit_any;
 }
 
-bool FHittableList::bounding_box(double t0, double t1, FAABB& outbox) const
+uint32_t FHittableList::intersect_packet(const FRayPacket& packet, FReal t_min, FReal* t_max, FHitRecord* recs) const
+{
+	uint32_t hits = 0;
+	for (const auto& object : objects)
+	{
+		hits |= object->intersect_packet(packet, t_min, t_max, recs);
+	}
+	return hits;
+}
+
+bool FHittableList::occluded(const FRay& ray, FReal t_min, FReal t_max, FReal& transmittance) const
+{
+	for (const auto& object : objects)
+	{
+		if (object->occluded(ray, t_min, t_max, transmittance))
+			return true;
+	}
+	return false;
+}
+
+bool FHittableList::bounding_box(FReal t0, FReal t1, FAABB& outbox) const
 {
 	if (objects.empty()) return false;
 
@@ -23,8 +23,10 @@ public:
 	void clear() { objects.clear(); }
 	void add(const shared_ptr<FHittable>& obj) { objects.push_back(obj); }
 
-	virtual bool hit(const FRay& ray, double t_min, double t_max, FHitRecord& outHit) const override;
-	virtual bool bounding_box(double t0, double t1, FAABB& outbox) const override;
+	virtual bool intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const override;
+	virtual uint32_t intersect_packet(const FRayPacket& packet, FReal t_min, FReal* t_max, FHitRecord* recs) const override;
+	virtual bool occluded(const FRay& ray, FReal t_min, FReal t_max, FReal& transmittance) const override;
+	virtual bool bounding_box(FReal t0, FReal t1, FAABB& outbox) const override;
 
 public:
 	std::vector<shared_ptr<FHittable>> objects;
@@ -0,0 +1,345 @@
+// light list
+//
+//
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <typeinfo>
+#include "light_list.h"
+#include "hittable_list.h"
+#include "bvh.h"
+#include "sphere.h"
+#include "aarect.h"
+#include "sphere_set.h"
+#include "material.h"
+#include "compiled_scene.h"
+#include "sampler.h"
+#include "color.h"
+#include "environment.h"
+
+
+// material of the primitives that implement light sampling
+static const FMaterial* sampled_material(const FHittable* obj)
+{
+	const std::type_info& type = typeid(*obj);
+	if (type == typeid(FSphere))	return static_cast<const FSphere*>(obj)->mat_ptr.get();
+	if (type == typeid(FXYRect))	return static_cast<const FXYRect*>(obj)->mp.get();
+	if (type == typeid(FXZRect))	return static_cast<const FXZRect*>(obj)->mp.get();
+	if (type == typeid(FYZRect))	return static_cast<const FYZRect*>(obj)->mp.get();
+	return nullptr;
+}
+
+
+static const char* kLightSamplingNames[(int)ELightSampling::Count] = { "uniform", "power", "bvh" };
+
+const char* light_sampling_name(ELightSampling strategy)
+{
+	return kLightSamplingNames[(int)strategy];
+}
+
+bool find_light_sampling(const char* name, ELightSampling& strategy)
+{
+	for (int i = 0; i < (int)ELightSampling::Count; i++)
+	{
+		if (strcmp(name, kLightSamplingNames[i]) == 0)
+		{
+			strategy = (ELightSampling)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+// emitted power up to a constant: radiance at the middle of the light times
+// its area. textured emission is only looked at once
+static FReal light_power(const FHittable* obj)
+{
+	const std::type_info& type = typeid(*obj);
+	FPoint3 center;
+	FReal area = 0;
+	if (type == typeid(FSphere))
+	{
+		const FSphere* s = static_cast<const FSphere*>(obj);
+		center = s->center;
+		area = 4 * kPi * s->radius * s->radius;
+	}
+	else if (type == typeid(FXYRect))
+	{
+		const FXYRect* r = static_cast<const FXYRect*>(obj);
+		center = FPoint3((r->x0 + r->x1) / 2, (r->y0 + r->y1) / 2, r->k);
+		area = (r->x1 - r->x0) * (r->y1 - r->y0);
+	}
+	else if (type == typeid(FXZRect))
+	{
+		const FXZRect* r = static_cast<const FXZRect*>(obj);
+		center = FPoint3((r->x0 + r->x1) / 2, r->k, (r->z0 + r->z1) / 2);
+		area = (r->x1 - r->x0) * (r->z1 - r->z0);
+	}
+	else if (type == typeid(FYZRect))
+	{
+		const FYZRect* r = static_cast<const FYZRect*>(obj);
+		center = FPoint3(r->k, (r->y0 + r->y1) / 2, (r->z0 + r->z1) / 2);
+		area = (r->y1 - r->y0) * (r->z1 - r->z0);
+	}
+
+	return luminance(material_emitted(*sampled_material(obj), 0.5, 0.5, center)) * std::abs(area);
+}
+
+
+FLightList::FLightList(const FHittable& world, const FEnvironment* InEnvironment, ELightSampling strategy)
+	: sampling(strategy)
+{
+	collect(&world);
+	if (InEnvironment && InEnvironment->valid())
+		environment = InEnvironment;
+
+	if (lights.empty() || sampling == ELightSampling::Uniform)
+	{
+		environment_probability = environment ? FReal(1) / (lights.size() + 1) : FReal(0);
+		return;
+	}
+
+	std::vector<FReal> powers(lights.size());
+	FReal total = 0;
+	for (size_t i = 0; i < lights.size(); i++)
+	{
+		powers[i] = light_power(lights[i]);
+		total += powers[i];
+	}
+
+	// what the environment pours into the bounding sphere of the scene, in
+	// the units of light_power(). kept between 0.1 and 0.9: neither side
+	// should starve on a bad estimate
+	if (environment)
+	{
+		FAABB box;
+		const FReal radius = world.bounding_box(0, 1, box) ? (box.max() - box.min()).length() / 2 : FReal(1);
+		const FReal environment_power = 2 * kPi * radius * radius * environment->mean_luminance();
+		environment_probability = clamp(environment_power / (environment_power + total), 0.1, 0.9);
+	}
+
+	// a light whose single look came out dark may still shine elsewhere,
+	// it must stay reachable
+	const FReal floor = total > 0 ? FReal(1e-3) * total / lights.size() : FReal(1);
+	for (FReal& power : powers)
+		power = std::max(power, floor);
+
+	if (sampling == ELightSampling::Power)
+	{
+		power_table = FAliasTable(powers);
+		return;
+	}
+
+	std::vector<FAABB> boxes(lights.size());
+	for (size_t i = 0; i < lights.size(); i++)
+		lights[i]->bounding_box(0, 1, boxes[i]);
+
+	std::vector<int> ids(lights.size());
+	for (size_t i = 0; i < ids.size(); i++) ids[i] = int(i);
+	nodes.reserve(2 * lights.size() - 1);
+	leaves.resize(lights.size());
+	build(ids, 0, ids.size(), -1, powers, boxes);
+}
+
+int FLightList::build(std::vector<int>& ids, size_t begin, size_t end, int parent, const std::vector<FReal>& powers, const std::vector<FAABB>& boxes)
+{
+	const int n = int(nodes.size());
+	nodes.emplace_back();
+	nodes[n].parent = parent;
+
+	FAABB box = boxes[ids[begin]];
+	FAABB centroids(box.min() + box.max(), box.min() + box.max());
+	FReal power = 0;
+	for (size_t i = begin; i < end; i++)
+	{
+		const FAABB& b = boxes[ids[i]];
+		const FPoint3 c = b.min() + b.max();
+		box = surrounding_box(box, b);
+		centroids = surrounding_box(centroids, FAABB(c, c));
+		power += powers[ids[i]];
+	}
+	nodes[n].box = box;
+	nodes[n].power = power;
+
+	if (end - begin == 1)
+	{
+		nodes[n].light = ids[begin];
+		leaves[ids[begin]] = n;
+		return n;
+	}
+
+	// median split of the centers along their widest axis
+	const int axis = centroids.longest_axies();
+	const size_t mid = (begin + end) / 2;
+	std::nth_element(ids.begin() + begin, ids.begin() + mid, ids.begin() + end, [&](int a, int b) {
+		return boxes[a].min()[axis] + boxes[a].max()[axis] < boxes[b].min()[axis] + boxes[b].max()[axis];
+	});
+
+	const int left = build(ids, begin, mid, n, powers, boxes);
+	const int right = build(ids, mid, end, n, powers, boxes);
+	nodes[n].left = left;
+	nodes[n].right = right;
+	return n;
+}
+
+FReal FLightList::importance(const FLightNode& node, const FPoint3& p, const FVec3& n) const
+{
+	const FPoint3 center = (node.box.min() + node.box.max()) * 0.5;
+	const FReal radius2 = (node.box.max() - center).length2();
+	const FVec3 d = center - p;
+	const FReal dist2 = d.length2();
+
+	// inside the bounding sphere every direction may lead to a light
+	if (dist2 <= radius2)
+		return node.power / std::max(radius2, FReal(1e-8));
+
+	// the sphere covers directions within theta_u of d, the surface takes
+	// light up to 90 degrees from n: bound cos(theta_i) by cos(theta_i - theta_u)
+	FReal cos_bound = 1;
+	const FReal n2 = n.length2();
+	if (n2 > 0)
+	{
+		const FReal cos_i = dot(n, d) / std::sqrt(n2 * dist2);
+		const FReal sin_i = std::sqrt(std::max(FReal(0), 1 - cos_i * cos_i));
+		const FReal sin_u2 = radius2 / dist2;
+		const FReal cos_u = std::sqrt(1 - sin_u2);
+		const FReal sin_u = std::sqrt(sin_u2);
+		if (cos_i < cos_u)
+			cos_bound = std::max(FReal(0), cos_i * cos_u + sin_i * sin_u);
+	}
+
+	return node.power * cos_bound / dist2;
+}
+
+FReal FLightList::left_probability(const FLightNode& node, const FPoint3& p, const FVec3& n) const
+{
+	const FReal l = importance(nodes[node.left], p, n);
+	const FReal r = importance(nodes[node.right], p, n);
+	return l + r > 0 ? l / (l + r) : FReal(0.5);
+}
+
+const FHittable* FLightList::pick(const FPoint3& p, const FVec3& n, FReal& pick_pdf) const
+{
+	FReal u = sample_1d();
+	if (u < environment_probability)
+	{
+		pick_pdf = environment_probability;
+		return nullptr;
+	}
+
+	u = std::min((u - environment_probability) / (1 - environment_probability), FReal(1) - std::numeric_limits<FReal>::epsilon());
+	const FHittable* light = pick_light(u, p, n, pick_pdf);
+	pick_pdf *= 1 - environment_probability;
+	return light;
+}
+
+const FHittable* FLightList::pick_light(FReal u, const FPoint3& p, const FVec3& n, FReal& pick_pdf) const
+{
+	if (sampling == ELightSampling::Uniform)
+	{
+		const size_t i = std::min(static_cast<size_t>(u * lights.size()), lights.size() - 1);
+		pick_pdf = FReal(1) / lights.size();
+		return lights[i];
+	}
+	if (sampling == ELightSampling::Power)
+		return lights[power_table.sample(u, pick_pdf)];
+
+	// one number steers the whole descent, rescaled at every node
+	pick_pdf = 1;
+	int node = 0;
+	while (nodes[node].light < 0)
+	{
+		const FReal pl = left_probability(nodes[node], p, n);
+		if (u < pl)
+		{
+			u = u / pl;
+			pick_pdf *= pl;
+			node = nodes[node].left;
+		}
+		else
+		{
+			u = (u - pl) / (1 - pl);
+			pick_pdf *= 1 - pl;
+			node = nodes[node].right;
+		}
+		u = std::min(u, FReal(1) - std::numeric_limits<FReal>::epsilon());
+	}
+	return lights[nodes[node].light];
+}
+
+FReal FLightList::pick_pdf(const FHittable* light, const FPoint3& p, const FVec3& n) const
+{
+	return (1 - environment_probability) * light_pdf(light, p, n);
+}
+
+FReal FLightList::light_pdf(const FHittable* light, const FPoint3& p, const FVec3& n) const
+{
+	if (sampling == ELightSampling::Uniform)
+		return FReal(1) / lights.size();
+
+	const size_t i = index.at(light);
+	if (sampling == ELightSampling::Power)
+		return power_table.pdf(i);
+
+	FReal pdf = 1;
+	for (int child = leaves[i], node = nodes[child].parent; node >= 0; child = node, node = nodes[node].parent)
+	{
+		const FReal pl = left_probability(nodes[node], p, n);
+		pdf *= nodes[node].left == child ? pl : 1 - pl;
+	}
+	return pdf;
+}
+
+void FLightList::collect(const FHittable* obj)
+{
+	const std::type_info& type = typeid(*obj);
+
+	if (type == typeid(FHittableList))
+	{
+		for (const shared_ptr<FHittable>& child : static_cast<const FHittableList*>(obj)->objects)
+			collect(child.get());
+	}
+	else if (type == typeid(FBVH_Node))
+	{
+		const FBVH_Node* node = static_cast<const FBVH_Node*>(obj);
+		collect(node->left.get());
+		if (node->right)
+			collect(node->right.get());
+	}
+	else if (type == typeid(FLazyBVH_Node))
+	{
+		static_cast<const FLazyBVH_Node*>(obj)->for_each_primitive([&](const shared_ptr<FHittable>& child) { collect(child.get()); });
+	}
+	else if (type == typeid(FFlipFace))
+	{
+		// emission ignores the face, the wrapped primitive is the light
+		collect(static_cast<const FFlipFace*>(obj)->object());
+	}
+	else if (type == typeid(FCompiledScene))
+	{
+		static_cast<const FCompiledScene*>(obj)->for_each_primitive([this](const FCompiledPrimitive& prim) {
+			std::visit([this](const auto& p) {
+				using T = std::decay_t<decltype(p)>;
+				if constexpr (std::is_pointer_v<T>)
+					collect(p);
+				else
+					collect(&p);
+			}, prim);
+		});
+	}
+	else
+	{
+		add(obj);
+	}
+}
+
+void FLightList::add(const FHittable* obj)
+{
+	const FMaterial* mat = sampled_material(obj);
+	if (dynamic_cast<const FDiffuseLight*>(mat) && !contains(obj))
+	{
+		index[obj] = lights.size();
+		lights.push_back(obj);
+	}
+}
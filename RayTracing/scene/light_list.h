@@ -0,0 +1,97 @@
+// light list
+// emissive primitives of a scene that can be sampled directly (next event
+// estimation). lists, bvh nodes, flip faces and compiled scenes are searched
+// for spheres and rects with a FDiffuseLight material; lights below a
+// transform are not collected and are only found by bounce rays. bvh leaves
+// keep emissive spheres out of their sphere sets.
+//
+// which light a shadow ray goes to is chosen by one of three strategies:
+// uniform, in proportion to emitted power (alias table), or by walking a bvh
+// over the lights towards the ones that matter most for the shading point
+// (conty estevez and kulla 2018, without orientation cones since diffuse
+// lights are two-sided). the light bvh pays off with many lights spread out.
+//
+// the environment, if given, is one more light. it gets its share of the
+// picks before the strategy chooses among the others.
+//
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include "hittable.h"
+#include "distribution.h"
+
+
+enum class ELightSampling
+{
+	Uniform,
+	Power,  // emitted power times area
+	Bvh,    // power over squared distance, bounded per bvh node
+	Count,
+};
+
+const char* light_sampling_name(ELightSampling strategy);
+bool find_light_sampling(const char* name, ELightSampling& strategy);
+
+class FEnvironment;
+
+class FLightList
+{
+public:
+	// environment: the one of the FBackground the integrators get, if any
+	explicit FLightList(const FHittable& world, const FEnvironment* environment = nullptr, ELightSampling strategy = ELightSampling::Bvh);
+
+	ELightSampling strategy() const { return sampling; }
+
+	// size() counts the primitives, empty() the environment too
+	size_t size() const { return lights.size(); }
+	bool empty() const { return lights.empty() && !environment; }
+	const FHittable* light(size_t i) const { return lights[i]; }
+
+	// obj is the primitive of a hit record (FHitRecord::obj_ptr)
+	bool contains(const FHittable* obj) const { return index.count(obj) != 0; }
+
+	const FEnvironment* environment_light() const { return environment; }
+
+	// light for a shadow ray from p, n is the surface normal there (zero in
+	// a medium), nullptr for the environment. one sample_1d dimension
+	const FHittable* pick(const FPoint3& p, const FVec3& n, FReal& pick_pdf) const;
+	// probability of pick(p, n) returning light
+	FReal pick_pdf(const FHittable* light, const FPoint3& p, const FVec3& n) const;
+	// probability of pick() returning the environment
+	FReal environment_pdf() const { return environment_probability; }
+
+private:
+	struct FLightNode
+	{
+		FAABB	box;
+		FReal	power = 0;
+		int		left = -1;    // children, -1 for a leaf
+		int		right = -1;
+		int		parent = -1;
+		int		light = -1;   // light of a leaf
+	};
+
+	// pick() and pick_pdf() among the lights only
+	const FHittable* pick_light(FReal u, const FPoint3& p, const FVec3& n, FReal& pick_pdf) const;
+	FReal light_pdf(const FHittable* light, const FPoint3& p, const FVec3& n) const;
+
+	void collect(const FHittable* obj);
+	void add(const FHittable* obj);
+
+	int build(std::vector<int>& ids, size_t begin, size_t end, int parent, const std::vector<FReal>& powers, const std::vector<FAABB>& boxes);
+	// upper bound of what the lights below node send to p
+	FReal importance(const FLightNode& node, const FPoint3& p, const FVec3& n) const;
+	// chance of going from a node to its child left (or right)
+	FReal left_probability(const FLightNode& node, const FPoint3& p, const FVec3& n) const;
+
+	ELightSampling sampling;
+	std::vector<const FHittable*> lights;
+	std::unordered_map<const FHittable*, size_t> index;
+	FAliasTable power_table;
+	std::vector<FLightNode> nodes;  // root first
+	std::vector<int> leaves;        // node of each light
+	const FEnvironment* environment = nullptr;
+	FReal environment_probability = 0;
+};
@@ -4,26 +4,94 @@
 
 #pragma once
 
+#include <atomic>
+#include <typeinfo>
 #include "basic.h"
 #include "vec3.h"
 #include "ray.h"
 #include "hittable.h"
 #include "texture.h"
+#include "onb.h"
 
 
+// concrete materials the static dispatch below knows, anything else is Custom
+enum class EMaterialKind : uint8_t
+{
+	Unresolved,
+	Custom,
+	Lambertian,
+	Metal,
+	Dielectric,
+	DiffuseLight,
+	Isotropic,
+	Pbr,
+};
+
+// a direction sampled from a bsdf
+struct FBsdfSample
+{
+	FVec3	wi;        // unit, the direction the path continues in
+	FColor3	f;         // bsdf value f(wo, wi)
+	FReal	pdf = 0;   // solid angle pdf of wi
+	FColor3	weight;    // f * cos / pdf, the factor on the path throughput
+	bool	specular = false;  // delta lobe or sample-only material, f and pdf are unused
+};
+
 // abstract material
+// wo and wi are unit vectors pointing away from the surface, wo towards the
+// viewer. sample() picks wi, eval() and pdf() give f and the pdf of any wi
 class FMaterial
 {
 public:
-	virtual bool scatter(const FRay& ray_in, const FHitRecord& rec, FColor3& attenuation, FRay& scattered) const = 0;
-	virtual FColor3 emitted(double u, double v, const FPoint3& p) const
+	virtual bool sample(const FVec3& wo, const FHitRecord& rec, FBsdfSample& out) const = 0;
+	virtual FColor3 eval(const FVec3& wo, const FVec3& wi, const FHitRecord& rec) const
+	{
+		return FColor3(0, 0, 0);
+	}
+	virtual FReal pdf(const FVec3& wo, const FVec3& wi, const FHitRecord& rec) const
+	{
+		return 0.0;
+	}
+	virtual FColor3 emitted(FReal u, FReal v, const FPoint3& p) const
 	{
 		return FColor3(0,0,0);
 	}
-	virtual double pdf(const FVec3& wi) const
+	// surface color at the hit, the denoiser guide. white for materials without one
+	virtual FColor3 base_color(const FHitRecord& rec) const
+	{
+		return FColor3(1, 1, 1);
+	}
+
+	// sample() and the ray leaving the hit, attenuation is the sample weight
+	bool scatter(const FRay& ray_in, const FHitRecord& rec, FColor3& attenuation, FRay& scattered) const
+	{
+		FBsdfSample bs;
+		if (!sample(-unit_vector(ray_in.Direction()), rec, bs))
+			return false;
+
+		attenuation = bs.weight;
+		scattered = rec.spawn_ray(bs.wi, ray_in.Time());
+		return true;
+	}
+
+	// the known material this is exactly an instance of, Custom for anything
+	// else, classes deriving from a known one included so their overrides are
+	// kept. resolved with typeid on first use
+	EMaterialKind kind() const
 	{
-		return 1.0;
+		EMaterialKind k = resolved_kind.load(std::memory_order_relaxed);
+		if (k == EMaterialKind::Unresolved)
+		{
+			k = resolve_kind();
+			resolved_kind.store(k, std::memory_order_relaxed);
+		}
+		return k;
 	}
+
+private:
+	EMaterialKind resolve_kind() const;
+
+	mutable std::atomic<EMaterialKind> resolved_kind{ EMaterialKind::Unresolved };
 };
 
 
@@ -33,20 +101,38 @@ class FLambertian : public FMaterial
 public:
 	FLambertian(const shared_ptr<FTexture> &a) : albedo(a) {}
 
-	virtual bool scatter(const FRay& ray_in, const FHitRecord& rec, FColor3& attenuation, FRay& scattered) const
+	// cosine weighted, the weight is the albedo
+	virtual bool sample(const FVec3& wo, const FHitRecord& rec, FBsdfSample& out) const
 	{
-		FVec3 scatter_direction = unit_vector(random_in_hemisphere(rec.normal));
-		scattered = FRay(rec.p, scatter_direction, ray_in.Time());
-
-		FColor3 p = albedo->value(rec.u, rec.v, rec.p);
-		double cos_theta = std::max(dot(rec.normal, scatter_direction), 0.0);
-		attenuation = (kOneOverPi * cos_theta) * p;
+		out.wi = unit_vector(FOnb(rec.normal).local(random_cosine_direction()));
+		const FColor3 p = albedo->value(rec.u, rec.v, rec.p);
+		const FReal cos_theta = dot(rec.normal, out.wi);
+		if (cos_theta <= 0)
+			return false;
+
+		out.f = kOneOverPi * p;
+		out.pdf = cos_theta * kOneOverPi;
+		out.weight = p;
+		out.specular = false;
 		return true;
 	}
 
-	virtual double pdf(const FVec3& wi) const
+	virtual FColor3 eval(const FVec3& wo, const FVec3& wi, const FHitRecord& rec) const
+	{
+		if (dot(rec.normal, wi) <= 0)
+			return FColor3(0, 0, 0);
+
+		return kOneOverPi * albedo->value(rec.u, rec.v, rec.p);
+	}
+
+	virtual FReal pdf(const FVec3& wo, const FVec3& wi, const FHitRecord& rec) const
 	{
-		return 1.0 / kTwoPi; // pdf of hemisphere
+		return std::max<FReal>(dot(rec.normal, wi), 0.0) * kOneOverPi;
+	}
+
+	virtual FColor3 base_color(const FHitRecord& rec) const
+	{
+		return albedo->value(rec.u, rec.v, rec.p);
 	}
 
 public:
@@ -58,24 +144,30 @@ public:
 class FMetal : public FMaterial
 {
 public:
-	FMetal(const FColor3& a, double f=1.0) : albedo(a), fuzzy(f<1.0 ? f : 1.0) {}
+	FMetal(const FColor3& a, FReal f=1.0) : albedo(a), fuzzy(f<1.0 ? f : 1.0) {}
 
-	virtual bool scatter(const FRay& ray_in, const FHitRecord& rec, FColor3& attenuation, FRay& scattered) const
+	virtual bool sample(const FVec3& wo, const FHitRecord& rec, FBsdfSample& out) const
 	{
-		FVec3 reflected = reflect(unit_vector(ray_in.Direction()), rec.normal);
-		scattered = FRay(rec.p, reflected + fuzzy * random_in_unit_sphere(), ray_in.Time());
-		attenuation = albedo;
+		FVec3 reflected = reflect(-wo, rec.normal);
+		out.wi = unit_vector(reflected + fuzzy * sample_in_unit_sphere());
+		out.weight = albedo;
+		out.specular = true;
 
-		return (dot(scattered.Direction(), rec.normal) > 0);
+		return (dot(out.wi, rec.normal) > 0);
+	}
+
+	virtual FColor3 base_color(const FHitRecord& rec) const
+	{
+		return albedo;
 	}
 
 public:
 	FColor3 albedo;
-	double fuzzy;
+	FReal fuzzy;
 };
 
 // Schlick approximation
-inline double schlick(double cosine, double ref_idx)
+inline FReal schlick(FReal cosine, FReal ref_idx)
 {
 	auto r0 = (1 - ref_idx) / (1 + ref_idx);
 	r0 = r0 * r0;
@@ -86,39 +178,37 @@ inline double schlick(double cosine, double ref_idx)
 class FDielectric : public FMaterial
 {
 public:
-	FDielectric(double ri) : ref_idx(ri) {}
+	FDielectric(FReal ri) : ref_idx(ri) {}
 
-	virtual bool scatter(const FRay& ray_in, const FHitRecord& rec, FColor3& attenuation, FRay& scattered) const
+	virtual bool sample(const FVec3& wo, const FHitRecord& rec, FBsdfSample& out) const
 	{
-		attenuation = FColor3(1.0, 1.0, 1.0);
-		double etai_over_etat = (rec.front_face) ? (1.0 / ref_idx) : ref_idx;
+		out.weight = FColor3(1.0, 1.0, 1.0);
+		out.specular = true;
+		FReal etai_over_etat = (rec.front_face) ? (1.0 / ref_idx) : ref_idx;
 
-		FVec3 unit_direction = unit_vector(ray_in.Direction());
-		double cos_theta = fmin(dot(-unit_direction, rec.normal), 1.0);
-		double sin_theta = sqrt(1.0 - cos_theta * cos_theta);
+		FVec3 unit_direction = -wo;
+		FReal cos_theta = fmin(dot(-unit_direction, rec.normal), 1.0);
+		FReal sin_theta = sqrt(1.0 - cos_theta * cos_theta);
 		if (etai_over_etat * sin_theta > 1.0) // total internal reflection(ȫڷ)
 		{
-			FVec3 reflected = reflect(unit_direction, rec.normal);
-			scattered = FRay(rec.p, reflected, ray_in.Time());
+			out.wi = reflect(unit_direction, rec.normal);
 			return true;
 		}
 
 		// schlick approximation
-		double reflect_prob = schlick(cos_theta, etai_over_etat);
-		if (random_double() < reflect_prob)
+		FReal reflect_prob = schlick(cos_theta, etai_over_etat);
+		if (sample_1d() < reflect_prob)
 		{
-			FVec3 reflected = reflect(unit_direction, rec.normal);
-			scattered = FRay(rec.p, reflected, ray_in.Time());
+			out.wi = reflect(unit_direction, rec.normal);
 			return true;
 		}
 
-		FVec3 refracted = refract(unit_direction, rec.normal, etai_over_etat);
-		scattered = FRay(rec.p, refracted, ray_in.Time());
+		out.wi = unit_vector(refract(unit_direction, rec.normal, etai_over_etat));
 		return true;
 	}
 
 private:
-	double ref_idx;
+	FReal ref_idx;
 };
 
 // diffuse light
@@ -127,12 +217,12 @@ class FDiffuseLight : public FMaterial
 public:
 	FDiffuseLight(const std::shared_ptr<FTexture>& a) : emittexture(a) {}
 
-	virtual bool scatter(const FRay& ray_in, const FHitRecord& rec, FColor3& attenuation, FRay& scattered) const
+	virtual bool sample(const FVec3& wo, const FHitRecord& rec, FBsdfSample& out) const
 	{
 		return false;
 	}
 
-	virtual FColor3 emitted(double u, double v, const FPoint3& p) const
+	virtual FColor3 emitted(FReal u, FReal v, const FPoint3& p) const
 	{
 		return emittexture->value(u, v, p);
 	}
@@ -147,14 +237,34 @@ class FIsotropic : public FMaterial
 public:
 	FIsotropic(const shared_ptr<FTexture>& a) : albedo(a) {}
 
-	virtual bool scatter(const FRay& ray_in, const FHitRecord& rec, FColor3& attenuation, FRay& scattered) const
+	// uniform over the sphere, the weight is the albedo
+	virtual bool sample(const FVec3& wo, const FHitRecord& rec, FBsdfSample& out) const
 	{
-		scattered = FRay(rec.p, random_in_unit_sphere(), ray_in.Time());
-		attenuation = albedo->value(rec.u, rec.v, rec.p);
+		out.wi = sample_unit_vector();
+		out.f = eval(wo, out.wi, rec);
+		out.pdf = pdf(wo, out.wi, rec);
+		out.weight = albedo->value(rec.u, rec.v, rec.p);
+		out.specular = false;
 
 		return true;
 	}
 
+	// phase function, no cosine: the hit is a point in a medium
+	virtual FColor3 eval(const FVec3& wo, const FVec3& wi, const FHitRecord& rec) const
+	{
+		return albedo->value(rec.u, rec.v, rec.p) / (4 * kPi);
+	}
+
+	virtual FReal pdf(const FVec3& wo, const FVec3& wi, const FHitRecord& rec) const
+	{
+		return 1 / (4 * kPi);
+	}
+
+	virtual FColor3 base_color(const FHitRecord& rec) const
+	{
+		return albedo->value(rec.u, rec.v, rec.p);
+	}
+
 protected:
 	shared_ptr<FTexture> albedo;
 };
@@ -171,24 +281,85 @@ public:
 		, roughnessTex(InRoughnessTex)
 	{}
 
-	virtual double pdf(const FVec3& wi) const
+	// picks the GGX lobe, sampled through its visible normals, or the
+	// cosine weighted diffuse lobe by their estimated reflectance
+	virtual bool sample(const FVec3& wo, const FHitRecord& rec, FBsdfSample& out) const
 	{
-		return 1.0 / kTwoPi; // pdf of hemisphere
+		const FReal NdotV = dot(rec.normal, wo);
+		if (NdotV <= 0)
+			return false;
+
+		const FOnb onb(rec.normal);
+		if (sample_1d() < specular_probability(NdotV, rec))
+		{
+			const FReal alpha = GGXAlpha(roughnessTex->value(rec.u, rec.v, rec.p)[0]);
+			const FVec3 H = onb.local(SampleGGXVNDF(onb.project(wo), alpha));
+			out.wi = unit_vector(reflect(-wo, H));
+		}
+		else
+		{
+			out.wi = unit_vector(onb.local(random_cosine_direction()));
+		}
+
+		const FReal cos_theta = dot(rec.normal, out.wi);
+		if (cos_theta <= 0)
+			return false;
+
+		out.f = brdf(wo, out.wi, rec);
+		out.pdf = pdf(wo, out.wi, rec);
+		if (out.pdf <= 0)
+			return false;
+
+		out.weight = out.f * (cos_theta / out.pdf);
+		out.specular = false;
+		return true;
 	}
 
-	virtual bool scatter(const FRay& ray_in, const FHitRecord& rec, FColor3& attenuation, FRay& scattered) const
+	virtual FColor3 eval(const FVec3& wo, const FVec3& wi, const FHitRecord& rec) const
 	{
-		FVec3 scatter_direction = unit_vector(random_in_hemisphere(rec.normal));
-		scattered = FRay(rec.p, scatter_direction, ray_in.Time());
+		if (dot(rec.normal, wi) <= 0)
+			return FColor3(0, 0, 0);
 
+		return brdf(wo, wi, rec);
+	}
+
+	// mix of the two sampling strategies of sample()
+	virtual FReal pdf(const FVec3& wo, const FVec3& wi, const FHitRecord& rec) const
+	{
 		const FVec3& N = rec.normal;
-		const FVec3& L = scatter_direction;
-		const FVec3  V = -unit_vector(ray_in.Direction());
+		const FReal NdotV = dot(N, wo);
+		const FReal NdotL = dot(N, wi);
+		if (NdotV <= 0 || NdotL <= 0)
+			return 0.0;
+
+		// visible normal pdf D(H) * G1(V) * VdotH / NdotV, times the
+		// 1 / (4 * VdotH) jacobian of the reflection
+		const FVec3 H = unit_vector(wo + wi);
+		const FReal alpha = GGXAlpha(roughnessTex->value(rec.u, rec.v, rec.p)[0]);
+		const FReal pdf_specular = DistributionGGX(N, H, alpha) * SmithG1GGX(NdotV, alpha) / (4.0 * NdotV);
+		const FReal pdf_diffuse = NdotL * kOneOverPi;
+
+		const FReal p = specular_probability(NdotV, rec);
+		return p * pdf_specular + (1 - p) * pdf_diffuse;
+	}
+
+	virtual FColor3 base_color(const FHitRecord& rec) const
+	{
+		return albedoTex->value(rec.u, rec.v, rec.p);
+	}
+
+protected:
+	// Cook-Torrance specular + lambertian diffuse, wi above the surface
+	FColor3 brdf(const FVec3& wo, const FVec3& wi, const FHitRecord& rec) const
+	{
+		const FVec3& N = rec.normal;
+		const FVec3& L = wi;
+		const FVec3& V = wo;
 		const FVec3  H = unit_vector(V + L);
 
 		const FColor3 albedo = albedoTex->value(rec.u, rec.v, rec.p);
-		const double metallic = metallicTex->value(rec.u, rec.v, rec.p)[0];
-		const double roughness = roughnessTex->value(rec.u, rec.v, rec.p)[0];
+		const FReal metallic = metallicTex->value(rec.u, rec.v, rec.p)[0];
+		const FReal roughness = roughnessTex->value(rec.u, rec.v, rec.p)[0];
 
 		// calculate reflectance at normal incidence; if dia-electric (like plastic) use F0 
 		// of 0.04 and if it's a metal, use the albedo color as F0 (metallic workflow)   
@@ -196,13 +367,13 @@ public:
 		const FVec3 F0 = lerp(kFb, albedo, metallic); // mix
 
 		// Cook-Torrance BRDF
-		double NDF = DistributionGGX(N, H, roughness);
-		double G = GeometrySmith(N, V, L, roughness);
+		FReal NDF = DistributionGGX(N, H, GGXAlpha(roughness));
+		FReal G = GeometrySmith(N, V, L, roughness);
 		FVec3 F = fresnelSchlick(clamp(dot(H, V), 0.0, 1.0), F0);
 
 		FVec3 nominator = NDF * G * F;
-		double denominator = 4.0 * std::max(dot(N, V), 0.0) * std::max(dot(N, L), 0.0);
-		const FColor3 brdf_specular = nominator / std::max(denominator, 0.001); // prevent divide by zero for NdotV=0.0 or NdotL=0.0
+		FReal denominator = 4.0 * std::max<FReal>(dot(N, V), 0.0) * std::max<FReal>(dot(N, L), 0.0);
+		const FColor3 brdf_specular = nominator / std::max<FReal>(denominator, 0.001); // prevent divide by zero for NdotV=0.0 or NdotL=0.0
 
 
 		// kS is equal to Fresnel
@@ -219,48 +390,100 @@ public:
 		const FColor3 brdf_diffuse = albedo * kOneOverPi; // lambertian model
 		const FColor3 brdf_cooktorrance = kD * brdf_diffuse + brdf_specular; // kS is Fresnel
 
-		const double NdotL = std::max(dot(N, L), 0.0);
-		attenuation = brdf_cooktorrance * NdotL;
-
-		return true;
+		return brdf_cooktorrance;
 	}
 
 protected:
-	double DistributionGGX(const FVec3& N, const FVec3& H, double InRoughness) const
+	// GGX alpha of a perceptual roughness, kept off zero where D is a delta
+	static FReal GGXAlpha(FReal InRoughness)
 	{
-		double a = InRoughness * InRoughness;
-		double a2 = a * a;
-		double NdotH = std::max(dot(N, H), 0.0);
-		double NdotH2 = NdotH * NdotH;
+		return std::max<FReal>(InRoughness * InRoughness, 1e-3);
+	}
 
-		double nom = a2;
-		double denom = NdotH2 * (a2 - 1.0) + 1.0;
+	static FReal DistributionGGX(const FVec3& N, const FVec3& H, FReal alpha)
+	{
+		FReal a2 = alpha * alpha;
+		FReal NdotH = std::max<FReal>(dot(N, H), 0.0);
+		FReal NdotH2 = NdotH * NdotH;
+
+		FReal nom = a2;
+		FReal denom = NdotH2 * (a2 - 1.0) + 1.0;
 		denom = kPi * denom * denom;
 
-		return nom / std::max(denom, 0.001); // prevent divide by zero for roughness=0.0 and NdotH=1.0
+		return nom / denom;
+	}
+
+	// separable smith masking of the GGX distribution itself, the pdf of
+	// the visible normals. brdf() keeps the schlick approximation
+	static FReal SmithG1GGX(FReal NdotV, FReal alpha)
+	{
+		const FReal a2 = alpha * alpha;
+		return 2.0 * NdotV / (NdotV + sqrt(a2 + (1.0 - a2) * NdotV * NdotV));
+	}
+
+	// half vector distributed as D(H) * G1(V) * max(0, VdotH) / NdotV,
+	// V and the result in the local frame of the normal (+z).
+	// "Sampling the GGX Distribution of Visible Normals", Heitz 2018
+	static FVec3 SampleGGXVNDF(const FVec3& V, FReal alpha)
+	{
+		// stretch to the hemisphere configuration
+		const FVec3 Vh = unit_vector(FVec3(alpha * V.x(), alpha * V.y(), V.z()));
+
+		const FReal lensq = Vh.x() * Vh.x() + Vh.y() * Vh.y();
+		const FVec3 T1 = lensq > 0 ? FVec3(-Vh.y(), Vh.x(), 0) / sqrt(lensq) : FVec3(1, 0, 0);
+		const FVec3 T2 = cross(Vh, T1);
+
+		// uniform disk point, warped to the projected visible hemisphere
+		FReal u1, u2;
+		sample_2d(u1, u2);
+		const FReal r = sqrt(u1);
+		const FReal phi = kTwoPi * u2;
+		const FReal t1 = r * cos(phi);
+		const FReal s = 0.5 * (1.0 + Vh.z());
+		const FReal t2 = (1.0 - s) * sqrt(1.0 - t1 * t1) + s * r * sin(phi);
+
+		const FVec3 Nh = t1 * T1 + t2 * T2 + sqrt(std::max<FReal>(0.0, 1.0 - t1 * t1 - t2 * t2)) * Vh;
+
+		// unstretch
+		return unit_vector(FVec3(alpha * Nh.x(), alpha * Nh.y(), std::max<FReal>(0.0, Nh.z())));
+	}
+
+	// chance of sampling the specular lobe: fresnel at the view angle
+	// against the diffuse reflectance left over by it
+	FReal specular_probability(FReal NdotV, const FHitRecord& rec) const
+	{
+		const FColor3 albedo = albedoTex->value(rec.u, rec.v, rec.p);
+		const FReal metallic = metallicTex->value(rec.u, rec.v, rec.p)[0];
+
+		static const FVec3 kFb(0.04, 0.04, 0.04);
+		const FVec3 F = fresnelSchlick(NdotV, lerp(kFb, albedo, metallic));
+		const FReal specular = (F.x() + F.y() + F.z()) / 3.0;
+		const FReal diffuse = (1.0 - metallic) * (albedo.x() + albedo.y() + albedo.z()) / 3.0 * (1.0 - specular);
+
+		return specular / std::max<FReal>(specular + diffuse, 1e-6);
 	}
 
-	double GeometrySchlickGGX(double NdotV, double InRoughness) const
+	FReal GeometrySchlickGGX(FReal NdotV, FReal InRoughness) const
 	{
-		double r = InRoughness + 1.0;
-		double k = (r * r) * (1.0 / 8.0);
-		double nom = NdotV;
-		double denom = NdotV * (1.0 - k) + k;
+		FReal r = InRoughness + 1.0;
+		FReal k = (r * r) * (1.0 / 8.0);
+		FReal nom = NdotV;
+		FReal denom = NdotV * (1.0 - k) + k;
 
 		return nom / denom;
 	}
 
-	double GeometrySmith(const FVec3& N, const FVec3& V, const FVec3 &L, double InRoughness) const
+	FReal GeometrySmith(const FVec3& N, const FVec3& V, const FVec3 &L, FReal InRoughness) const
 	{
-		double NdotV = std::max(dot(N, V), 0.0);
-		double NdotL = std::max(dot(N, L), 0.0);
-		double ggx2 = GeometrySchlickGGX(NdotV, InRoughness);
-		double ggx1 = GeometrySchlickGGX(NdotL, InRoughness);
+		FReal NdotV = std::max<FReal>(dot(N, V), 0.0);
+		FReal NdotL = std::max<FReal>(dot(N, L), 0.0);
+		FReal ggx2 = GeometrySchlickGGX(NdotV, InRoughness);
+		FReal ggx1 = GeometrySchlickGGX(NdotL, InRoughness);
 
 		return ggx1 * ggx2;
 	}
 
-	FVec3 fresnelSchlick(double HdotV, const FVec3& F0) const
+	FVec3 fresnelSchlick(FReal HdotV, const FVec3& F0) const
 	{
 		return F0 + (FVec3(1.0,1.0,1.0) - F0) * pow(1.0 - HdotV, 5.0);
 	}
@@ -270,3 +493,78 @@ protected:
 	shared_ptr<FTexture> metallicTex;
 	shared_ptr<FTexture> roughnessTex;
 };
+
+
+inline EMaterialKind FMaterial::resolve_kind() const
+{
+	const std::type_info& type = typeid(*this);
+	if (type == typeid(FLambertian))		return EMaterialKind::Lambertian;
+	if (type == typeid(FMetal))				return EMaterialKind::Metal;
+	if (type == typeid(FDielectric))		return EMaterialKind::Dielectric;
+	if (type == typeid(FDiffuseLight))		return EMaterialKind::DiffuseLight;
+	if (type == typeid(FIsotropic))			return EMaterialKind::Isotropic;
+	if (type == typeid(FPbrMaterial))		return EMaterialKind::Pbr;
+	return EMaterialKind::Custom;
+}
+
+// static dispatch on FMaterial::kind(): the known materials are called
+// directly and can be inlined, Custom ones go through the vtable
+inline bool material_sample(const FMaterial& mat, const FVec3& wo, const FHitRecord& rec, FBsdfSample& out)
+{
+	switch (mat.kind())
+	{
+	case EMaterialKind::Lambertian:		return static_cast<const FLambertian&>(mat).FLambertian::sample(wo, rec, out);
+	case EMaterialKind::Metal:			return static_cast<const FMetal&>(mat).FMetal::sample(wo, rec, out);
+	case EMaterialKind::Dielectric:		return static_cast<const FDielectric&>(mat).FDielectric::sample(wo, rec, out);
+	case EMaterialKind::DiffuseLight:	return false;
+	case EMaterialKind::Isotropic:		return static_cast<const FIsotropic&>(mat).FIsotropic::sample(wo, rec, out);
+	case EMaterialKind::Pbr:			return static_cast<const FPbrMaterial&>(mat).FPbrMaterial::sample(wo, rec, out);
+	default:							return mat.sample(wo, rec, out);
+	}
+}
+
+inline FColor3 material_eval(const FMaterial& mat, const FVec3& wo, const FVec3& wi, const FHitRecord& rec)
+{
+	switch (mat.kind())
+	{
+	case EMaterialKind::Lambertian:		return static_cast<const FLambertian&>(mat).FLambertian::eval(wo, wi, rec);
+	case EMaterialKind::Isotropic:		return static_cast<const FIsotropic&>(mat).FIsotropic::eval(wo, wi, rec);
+	case EMaterialKind::Pbr:			return static_cast<const FPbrMaterial&>(mat).FPbrMaterial::eval(wo, wi, rec);
+	case EMaterialKind::Custom:			return mat.eval(wo, wi, rec);
+	default:							return FColor3(0, 0, 0);
+	}
+}
+
+inline FReal material_pdf(const FMaterial& mat, const FVec3& wo, const FVec3& wi, const FHitRecord& rec)
+{
+	switch (mat.kind())
+	{
+	case EMaterialKind::Lambertian:		return static_cast<const FLambertian&>(mat).FLambertian::pdf(wo, wi, rec);
+	case EMaterialKind::Isotropic:		return static_cast<const FIsotropic&>(mat).FIsotropic::pdf(wo, wi, rec);
+	case EMaterialKind::Pbr:			return static_cast<const FPbrMaterial&>(mat).FPbrMaterial::pdf(wo, wi, rec);
+	case EMaterialKind::Custom:			return mat.pdf(wo, wi, rec);
+	default:							return 0.0;
+	}
+}
+
+inline FColor3 material_emitted(const FMaterial& mat, FReal u, FReal v, const FPoint3& p)
+{
+	switch (mat.kind())
+	{
+	case EMaterialKind::Custom:			return mat.emitted(u, v, p);
+	case EMaterialKind::DiffuseLight:	return static_cast<const FDiffuseLight&>(mat).FDiffuseLight::emitted(u, v, p);
+	default:							return FColor3(0, 0, 0);
+	}
+}
+
+// FMaterial::scatter through material_sample
+inline bool material_scatter(const FMaterial& mat, const FRay& ray_in, const FHitRecord& rec, FColor3& attenuation, FRay& scattered)
+{
+	FBsdfSample bs;
+	if (!material_sample(mat, -unit_vector(ray_in.Direction()), rec, bs))
+		return false;
+
+	attenuation = bs.weight;
+	scattered = rec.spawn_ray(bs.wi, ray_in.Time());
+	return true;
+}
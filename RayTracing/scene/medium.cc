@@ -0,0 +1,239 @@
+// participating media
+//
+//
+
+#include "medium.h"
+#include "color.h"
+
+
+// lowest majorant of a cell, as a fraction of the highest density in the medium
+static const FReal kMajorantFloor = FReal(1) / 64;
+
+// [t0, t1] narrowed to where ray is inside box, false when it misses
+static bool clip_to_box(const FAABB& box, const FRay& ray, FReal& t0, FReal& t1)
+{
+	for (int a = 0; a < 3; a++)
+	{
+		const FReal inv_d = 1 / ray.Direction()[a];
+		FReal near = (box.min()[a] - ray.Origin()[a]) * inv_d;
+		FReal far = (box.max()[a] - ray.Origin()[a]) * inv_d;
+		if (inv_d < 0)
+			std::swap(near, far);
+		t0 = near > t0 ? near : t0;
+		t1 = far < t1 ? far : t1;
+		if (t1 <= t0)
+			return false;
+	}
+	return true;
+}
+
+
+FHeterogeneousMedium::FHeterogeneousMedium(const FAABB& b, const shared_ptr<FTexture>& density_map, FReal scale,
+	const shared_ptr<FTexture>& albedo, int grid_resolution)
+	: bounds(b)
+	, density_texture(density_map)
+	, density_scale(scale)
+	, resolution(std::max(grid_resolution, 1))
+{
+	phase_function = make_shared<FIsotropic>(albedo);
+	const FVec3 extent = bounds.max() - bounds.min();
+	inv_extent = FVec3(1 / extent.x(), 1 / extent.y(), 1 / extent.z());
+
+	// density on one lattice over the whole box, at least 4 steps per cell
+	const int lattice = std::max(64, 4 * resolution);
+	const int points = lattice + 1;
+	std::vector<FReal> sampled(size_t(points) * points * points);
+	FReal peak = 0;
+	for (int k = 0; k < points; k++)
+		for (int j = 0; j < points; j++)
+			for (int i = 0; i < points; i++)
+			{
+				const FVec3 uvw(FReal(i) / lattice, FReal(j) / lattice, FReal(k) / lattice);
+				const FReal d = density(bounds.min() + uvw * extent);
+				sampled[(size_t(k) * points + j) * points + i] = d;
+				peak = std::max(peak, d);
+			}
+
+	// between lattice points the density can rise above both ends. a lattice
+	// point bounds the space up to one step around it by its density plus its
+	// steepest difference to a neighbour, and that bound goes to every cell
+	// the step reaches. no cell is left at 0 either: one whose lattice saw no
+	// density still gets a small share of the peak, so tracking never skips it
+	majorants.assign(size_t(resolution) * resolution * resolution, peak * kMajorantFloor);
+	for (int k = 0; k < points; k++)
+	{
+		for (int j = 0; j < points; j++)
+		{
+			for (int i = 0; i < points; i++)
+			{
+				const int at[3] = { i, j, k };
+				const size_t index = (size_t(k) * points + j) * points + i;
+				const size_t stride[3] = { 1, size_t(points), size_t(points) * points };
+				FReal bound = sampled[index];
+				FReal slope = 0;
+				for (int a = 0; a < 3; a++)
+				{
+					if (at[a] > 0)
+						slope = std::max<FReal>(slope, fabs(sampled[index] - sampled[index - stride[a]]));
+					if (at[a] < lattice)
+						slope = std::max<FReal>(slope, fabs(sampled[index + stride[a]] - sampled[index]));
+				}
+				bound += slope;
+
+				int lo[3], hi[3];
+				for (int a = 0; a < 3; a++)
+				{
+					lo[a] = std::max((at[a] - 1) * resolution / lattice, 0);
+					hi[a] = std::min((at[a] + 1) * resolution / lattice, resolution - 1);
+				}
+				for (int z = lo[2]; z <= hi[2]; z++)
+					for (int y = lo[1]; y <= hi[1]; y++)
+						for (int x = lo[0]; x <= hi[0]; x++)
+						{
+							FReal& m = majorants[(size_t(z) * resolution + y) * resolution + x];
+							m = std::max(m, bound);
+						}
+			}
+		}
+	}
+}
+
+FReal FHeterogeneousMedium::density(const FPoint3& p) const
+{
+	const FPoint3 uvw = (p - bounds.min()) * inv_extent;
+	return density_scale * std::max(luminance(density_texture->value(0, 0, uvw)), FReal(0));
+}
+
+template<typename FStep>
+void FHeterogeneousMedium::walk_grid(const FRay& ray, FReal t_enter, FReal t_exit, FStep step) const
+{
+	// 3d dda in grid units (amanatides and woo)
+	const FVec3 scale = inv_extent * FReal(resolution);
+	const FVec3 o = (ray.Origin() - bounds.min()) * scale;
+	const FVec3 d = ray.Direction() * scale;
+	const FVec3 p = o + d * t_enter;
+
+	int cell[3], cell_step[3];
+	FReal next[3], delta[3];
+	for (int a = 0; a < 3; a++)
+	{
+		cell[a] = std::min(std::max(int(floor(p[a])), 0), resolution - 1);
+		if (d[a] > 0)
+		{
+			next[a] = t_enter + (cell[a] + 1 - p[a]) / d[a];
+			delta[a] = 1 / d[a];
+			cell_step[a] = 1;
+		}
+		else if (d[a] < 0)
+		{
+			next[a] = t_enter + (cell[a] - p[a]) / d[a];
+			delta[a] = -1 / d[a];
+			cell_step[a] = -1;
+		}
+		else
+		{
+			next[a] = kInfinity;
+			delta[a] = kInfinity;
+			cell_step[a] = 0;
+		}
+	}
+
+	FReal t = t_enter;
+	while (t < t_exit)
+	{
+		const int axis = next[0] < next[1] ? (next[0] < next[2] ? 0 : 2) : (next[1] < next[2] ? 1 : 2);
+		const FReal t_next = std::min(next[axis], t_exit);
+		if (!step(t, t_next, majorants[(size_t(cell[2]) * resolution + cell[1]) * resolution + cell[0]]))
+			return;
+
+		t = t_next;
+		cell[axis] += cell_step[axis];
+		if (cell[axis] < 0 || cell[axis] >= resolution)
+			return;
+		next[axis] += delta[axis];
+	}
+}
+
+// the number of tracking steps varies from ray to ray, they draw from
+// random_double() so the sampler dimensions of later bounces stay in place
+bool FHeterogeneousMedium::intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& rec) const
+{
+	FReal t_enter = t_min, t_exit = t_max;
+	if (!clip_to_box(bounds, ray, t_enter, t_exit))
+		return false;
+
+	const FReal ray_length = ray.Direction().length();
+
+	// delta tracking: a tentative collision is real with probability density / majorant
+	FReal hit_t = -1;
+	walk_grid(ray, t_enter, t_exit, [&](FReal t0, FReal t1, FReal majorant) {
+		if (majorant <= 0)
+			return true;
+		const FReal rate = majorant * ray_length;
+		for (FReal t = t0; ; )
+		{
+			t -= log(1 - random_double()) / rate;
+			if (t >= t1)
+				return true;
+			if (random_double() * majorant < density(ray.At(t)))
+			{
+				hit_t = t;
+				return false;
+			}
+		}
+	});
+
+	if (hit_t < 0)
+		return false;
+
+	rec.set_hit(hit_t, this);
+	return true;
+}
+
+// ratio tracking: every tentative collision keeps 1 - density / majorant
+bool FHeterogeneousMedium::occluded(const FRay& ray, FReal t_min, FReal t_max, FReal& transmittance) const
+{
+	FReal t_enter = t_min, t_exit = t_max;
+	if (!clip_to_box(bounds, ray, t_enter, t_exit))
+		return false;
+
+	const FReal ray_length = ray.Direction().length();
+	FReal inside = 1;
+	walk_grid(ray, t_enter, t_exit, [&](FReal t0, FReal t1, FReal majorant) {
+		if (majorant <= 0)
+			return true;
+		const FReal rate = majorant * ray_length;
+		for (FReal t = t0; ; )
+		{
+			t -= log(1 - random_double()) / rate;
+			if (t >= t1)
+				return true;
+			inside *= std::max(FReal(0), 1 - density(ray.At(t)) / majorant);
+
+			// a faint ray plays russian roulette instead of walking on
+			if (inside < 0.1)
+			{
+				const FReal q = inside * 10;
+				if (random_double() >= q)
+				{
+					inside = 0;
+					return false;
+				}
+				inside /= q;
+			}
+		}
+	});
+
+	// nothing got through, as good as opaque
+	transmittance *= inside;
+	return inside <= 0;
+}
+
+void FHeterogeneousMedium::surface(const FRay& ray, FHitRecord& rec) const
+{
+	rec.p = ray.At(rec.t);
+
+	rec.normal = FVec3(0, 0, 0);  // none inside a medium, spawned rays start at p
+	rec.front_face = true;     // also arbitrary
+	rec.mat_ptr = phase_function.get();
+}
@@ -0,0 +1,61 @@
+// participating media
+// a medium is a hittable whose "hit" is a sampled scattering point inside it,
+// shaded with an isotropic phase function. a ray that comes out without one
+// passed through, so bounce rays get free-flight sampling for free.
+//
+// shadow rays ask occluded() instead: media are never opaque there, they
+// multiply in their transmittance along the ray (analytic for a constant
+// medium, ratio tracking for a heterogeneous one).
+//
+
+#pragma once
+
+#include <vector>
+#include "hittable.h"
+#include "material.h"
+#include "texture.h"
+
+
+// heterogeneous medium
+// density(p) = scale * luminance of the density texture at p, looked up with p
+// mapped to [0, 1]^3 over the bounds of the medium. scattering points are
+// found by delta tracking and shadow rays by ratio tracking, both against the
+// majorants of a coarse grid walked cell by cell, so thin regions are crossed
+// in few steps. the majorant of a cell bounds the density of a lattice of 64
+// (or 4 per cell) steps along each axis, each point widened by its steepest
+// step to a neighbour and spread over the cells within one step, with a floor
+// so no cell is 0. a texture that peaks within a lattice step of flat samples
+// can still exceed it.
+class FHeterogeneousMedium : public FHittable
+{
+public:
+	// grid_resolution cells along each axis, 1 tracks against a single global majorant
+	FHeterogeneousMedium(const FAABB& bounds, const shared_ptr<FTexture>& density, FReal scale,
+		const shared_ptr<FTexture>& albedo, int grid_resolution = 16);
+
+	virtual bool intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& rec) const override;
+	virtual bool occluded(const FRay& ray, FReal t_min, FReal t_max, FReal& transmittance) const override;
+	virtual void surface(const FRay& ray, FHitRecord& rec) const override;
+	virtual bool bounding_box(FReal t0, FReal t1, FAABB& outbox) const override
+	{
+		outbox = bounds;
+		return true;
+	}
+
+	FReal density(const FPoint3& p) const;
+
+protected:
+	// calls step(t0, t1, majorant) for the cells the ray crosses in [t_enter, t_exit],
+	// majorant per unit of t. step returns false to stop the walk
+	template<typename FStep>
+	void walk_grid(const FRay& ray, FReal t_enter, FReal t_exit, FStep step) const;
+
+protected:
+	FAABB	bounds;
+	FVec3	inv_extent;                // 1 / (max - min)
+	shared_ptr<FTexture> density_texture;
+	FReal	density_scale;
+	shared_ptr<FMaterial> phase_function;
+	int		resolution;
+	std::vector<FReal> majorants;     // x fastest
+};
@@ -0,0 +1,938 @@
+// mesh loader (wavefront obj, binary ply)
+//
+//
+
+#include "mesh_loader.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "mapped_file.h"
+#include "parallel.h"
+#include "timer.h"
+
+
+static bool has_extension(const char* filename, const char* ext)
+{
+	size_t n = strlen(filename);
+	size_t m = strlen(ext);
+	if (n < m) return false;
+
+	for (size_t i = 0; i < m; i++)
+	{
+		if (tolower(filename[n - m + i]) != ext[i]) return false;
+	}
+	return true;
+}
+
+shared_ptr<FTriangleMesh> load_mesh(const char* filename, const shared_ptr<FMaterial>& m, FMeshLoadStats* stats)
+{
+	if (has_extension(filename, ".obj"))
+	{
+		return load_obj(filename, m, stats);
+	}
+	if (has_extension(filename, ".ply"))
+	{
+		return load_ply(filename, m, stats);
+	}
+
+	std::cerr << "ERROR: unknown mesh format " << filename << ".\n";
+	return nullptr;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// text parsing
+
+static inline bool is_blank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char* skip_blank(const char* p, const char* end)
+{
+	while (p < end && is_blank(*p)) ++p;
+	return p;
+}
+
+static inline const char* next_line(const char* p, const char* end)
+{
+	const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+	return nl ? nl + 1 : end;
+}
+
+// locale independent, no allocation
+static const char* parse_double(const char* p, const char* end, double& out)
+{
+	static const double kPow10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	p = skip_blank(p, end);
+
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		negative = (*p == '-');
+		++p;
+	}
+
+	uint64_t mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	while (p < end && *p >= '0' && *p <= '9')
+	{
+		if (digits < 19) { mantissa = mantissa * 10 + (*p - '0'); digits++; }
+		else { exponent++; }
+		++p;
+	}
+	if (p < end && *p == '.')
+	{
+		++p;
+		while (p < end && *p >= '0' && *p <= '9')
+		{
+			if (digits < 19) { mantissa = mantissa * 10 + (*p - '0'); digits++; exponent--; }
+			++p;
+		}
+	}
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		++p;
+		bool negative_exp = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative_exp = (*p == '-');
+			++p;
+		}
+		int e = 0;
+		while (p < end && *p >= '0' && *p <= '9')
+		{
+			if (e < 10000) e = e * 10 + (*p - '0');
+			++p;
+		}
+		exponent += negative_exp ? -e : e;
+	}
+
+	double value = static_cast<double>(mantissa);
+	if (exponent < 0)
+	{
+		value = (-exponent <= 22) ? value / kPow10[-exponent] : value * pow(10.0, exponent);
+	}
+	else if (exponent > 0)
+	{
+		value = (exponent <= 22) ? value * kPow10[exponent] : value * pow(10.0, exponent);
+	}
+
+	out = negative ? -value : value;
+	return p;
+}
+
+static const char* parse_int(const char* p, const char* end, int64_t& out, bool& ok)
+{
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		negative = (*p == '-');
+		++p;
+	}
+
+	const char* start = p;
+	int64_t value = 0;
+	while (p < end && *p >= '0' && *p <= '9')
+	{
+		value = value * 10 + (*p - '0');
+		++p;
+	}
+
+	ok = (p != start);
+	out = negative ? -value : value;
+	return p;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// wavefront obj
+
+// one face corner, -1 for a missing attribute
+struct FObjCorner
+{
+	int32_t v;
+	int32_t vt;
+	int32_t vn;
+};
+
+// a line aligned slice of the file
+struct FObjChunk
+{
+	const char* begin = nullptr;
+	const char* end = nullptr;
+
+	// pass 1 counts, turned into global offsets before pass 2
+	size_t num_v = 0;
+	size_t num_vt = 0;
+	size_t num_vn = 0;
+	size_t num_tris = 0;
+
+	bool has_vt = false;
+	bool has_vn = false;
+	bool error = false;
+};
+
+static inline bool is_tag(const char* p, const char* end, char c0, char c1)
+{
+	if (p >= end || p[0] != c0) return false;
+	if (c1 == 0) return (p + 1 < end) && is_blank(p[1]);
+	return (p + 2 < end) && p[1] == c1 && is_blank(p[2]);
+}
+
+static void obj_count(FObjChunk& chunk)
+{
+	for (const char* line = chunk.begin; line < chunk.end; line = next_line(line, chunk.end))
+	{
+		const char* p = skip_blank(line, chunk.end);
+		if (is_tag(p, chunk.end, 'v', 0)) chunk.num_v++;
+		else if (is_tag(p, chunk.end, 'v', 't')) chunk.num_vt++;
+		else if (is_tag(p, chunk.end, 'v', 'n')) chunk.num_vn++;
+		else if (is_tag(p, chunk.end, 'f', 0))
+		{
+			int corners = 0;
+			p += 1;
+			while (true)
+			{
+				p = skip_blank(p, chunk.end);
+				if (p >= chunk.end || *p == '\n' || *p == '#') break;
+				corners++;
+				while (p < chunk.end && !is_blank(*p) && *p != '\n') ++p;
+			}
+			if (corners >= 3) chunk.num_tris += corners - 2;
+		}
+	}
+}
+
+// resolve a 1-based (or negative, relative) obj index, false for 0 and
+// relative indices before the first element
+static inline bool obj_index(int64_t index, size_t count_sofar, int32_t& out)
+{
+	const int64_t resolved = index > 0 ? index - 1 : static_cast<int64_t>(count_sofar) + index;
+	if (index == 0 || resolved < 0)
+		return false;
+
+	out = static_cast<int32_t>(resolved);
+	return true;
+}
+
+static void obj_parse(FObjChunk& chunk, size_t v_offset, size_t vt_offset, size_t vn_offset, size_t tri_offset,
+	size_t total_v, size_t total_vt, size_t total_vn,
+	FPoint3* positions, double* texcoords, FVec3* normals, FObjCorner* corners)
+{
+	size_t v = v_offset, vt = vt_offset, vn = vn_offset;
+	FObjCorner* corner = corners + 3 * tri_offset;
+
+	for (const char* line = chunk.begin; line < chunk.end; line = next_line(line, chunk.end))
+	{
+		const char* p = skip_blank(line, chunk.end);
+		double x, y, z;
+		if (is_tag(p, chunk.end, 'v', 0))
+		{
+			p = parse_double(p + 1, chunk.end, x);
+			p = parse_double(p, chunk.end, y);
+			p = parse_double(p, chunk.end, z);
+			positions[v++] = FPoint3(x, y, z);
+		}
+		else if (is_tag(p, chunk.end, 'v', 't'))
+		{
+			p = parse_double(p + 2, chunk.end, x);
+			p = parse_double(p, chunk.end, y);
+			texcoords[2 * vt] = x;
+			texcoords[2 * vt + 1] = y;
+			vt++;
+		}
+		else if (is_tag(p, chunk.end, 'v', 'n'))
+		{
+			p = parse_double(p + 2, chunk.end, x);
+			p = parse_double(p, chunk.end, y);
+			p = parse_double(p, chunk.end, z);
+			normals[vn++] = FVec3(x, y, z);
+		}
+		else if (is_tag(p, chunk.end, 'f', 0))
+		{
+			FObjCorner first = { -1, -1, -1 }, prev = { -1, -1, -1 };
+			int count = 0;
+			p += 1;
+			while (true)
+			{
+				p = skip_blank(p, chunk.end);
+				if (p >= chunk.end || *p == '\n' || *p == '#') break;
+
+				FObjCorner c = { -1, -1, -1 };
+				int64_t index;
+				bool ok;
+				p = parse_int(p, chunk.end, index, ok);
+				if (!ok || !obj_index(index, v, c.v)) { chunk.error = true; return; }
+				if (p < chunk.end && *p == '/')
+				{
+					++p;
+					p = parse_int(p, chunk.end, index, ok);
+					if (ok)
+					{
+						if (!obj_index(index, vt, c.vt)) { chunk.error = true; return; }
+						chunk.has_vt = true;
+					}
+					if (p < chunk.end && *p == '/')
+					{
+						++p;
+						p = parse_int(p, chunk.end, index, ok);
+						if (ok)
+						{
+							if (!obj_index(index, vn, c.vn)) { chunk.error = true; return; }
+							chunk.has_vn = true;
+						}
+					}
+				}
+				while (p < chunk.end && !is_blank(*p) && *p != '\n') ++p;
+
+				if (static_cast<size_t>(c.v) >= total_v
+					|| c.vt >= static_cast<int64_t>(total_vt)
+					|| c.vn >= static_cast<int64_t>(total_vn))
+				{
+					chunk.error = true;
+					return;
+				}
+
+				// fan triangulation
+				if (count == 0) first = c;
+				else if (count >= 2)
+				{
+					corner[0] = first;
+					corner[1] = prev;
+					corner[2] = c;
+					corner += 3;
+				}
+				prev = c;
+				count++;
+			}
+		}
+	}
+}
+
+static inline uint32_t hash_corner(const FObjCorner& c)
+{
+	uint32_t h = static_cast<uint32_t>(c.v) * 0x9E3779B1u;
+	h ^= static_cast<uint32_t>(c.vt) * 0x85EBCA77u + (h << 6) + (h >> 2);
+	h ^= static_cast<uint32_t>(c.vn) * 0xC2B2AE3Du + (h << 6) + (h >> 2);
+	return h;
+}
+
+shared_ptr<FTriangleMesh> load_obj(const char* filename, const shared_ptr<FMaterial>& m, FMeshLoadStats* stats)
+{
+	FPerformanceCounter counter;
+	counter.StartPerf();
+
+	FMappedFile file;
+	if (!file.open(filename))
+	{
+		std::cerr << "ERROR: Could not open mesh file " << filename << ".\n";
+		return nullptr;
+	}
+
+	const char* data = file.data();
+	const char* data_end = data + file.size();
+
+	// split into line aligned chunks
+	const int num_threads = hardware_threads();
+	std::vector<FObjChunk> chunks(num_threads);
+	for (int i = 0; i < num_threads; i++)
+	{
+		const char* begin = (i == 0) ? data : chunks[i - 1].end;
+		const char* end = (i == num_threads - 1) ? data_end : data + file.size() * (i + 1) / num_threads;
+		if (end < begin) end = begin;
+		if (end < data_end && end > data && end[-1] != '\n') end = next_line(end, data_end);
+
+		chunks[i].begin = begin;
+		chunks[i].end = end;
+	}
+
+	// pass 1: count
+	parallel_for(num_threads, [&chunks](int i) { obj_count(chunks[i]); });
+
+	std::vector<size_t> v_offsets(num_threads), vt_offsets(num_threads), vn_offsets(num_threads), tri_offsets(num_threads);
+	size_t total_v = 0, total_vt = 0, total_vn = 0, total_tris = 0;
+	for (int i = 0; i < num_threads; i++)
+	{
+		v_offsets[i] = total_v;
+		vt_offsets[i] = total_vt;
+		vn_offsets[i] = total_vn;
+		tri_offsets[i] = total_tris;
+		total_v += chunks[i].num_v;
+		total_vt += chunks[i].num_vt;
+		total_vn += chunks[i].num_vn;
+		total_tris += chunks[i].num_tris;
+	}
+
+	if (total_tris == 0 || total_v >= INT32_MAX || 3 * total_tris >= UINT32_MAX)
+	{
+		std::cerr << "ERROR: Unsupported mesh size in " << filename << ".\n";
+		return nullptr;
+	}
+
+	// pass 2: parse straight into flat arrays
+	std::vector<FPoint3> positions(total_v);
+	std::vector<double> texcoords(2 * total_vt);
+	std::vector<FVec3> normals(total_vn);
+	std::vector<FObjCorner> corners(3 * total_tris);
+
+	parallel_for(num_threads, [&](int i) {
+		obj_parse(chunks[i], v_offsets[i], vt_offsets[i], vn_offsets[i], tri_offsets[i],
+			total_v, total_vt, total_vn,
+			positions.data(), texcoords.data(), normals.data(), corners.data());
+	});
+
+	bool has_vt = false, has_vn = false;
+	for (const auto& chunk : chunks)
+	{
+		if (chunk.error)
+		{
+			std::cerr << "ERROR: Malformed face in mesh file " << filename << ".\n";
+			return nullptr;
+		}
+		has_vt = has_vt || chunk.has_vt;
+		has_vn = has_vn || chunk.has_vn;
+	}
+
+	shared_ptr<FTriangleMesh> mesh = make_shared<FTriangleMesh>(m);
+	mesh->indices.resize(corners.size());
+
+	if (!has_vt && !has_vn)
+	{
+		// position only corners index the position array directly
+		parallel_for(num_threads, [&](int i) {
+			size_t begin = corners.size() * i / num_threads;
+			size_t end = corners.size() * (i + 1) / num_threads;
+			for (size_t k = begin; k < end; k++)
+			{
+				mesh->indices[k] = static_cast<uint32_t>(corners[k].v);
+			}
+		});
+		mesh->positions = std::move(positions);
+	}
+	else
+	{
+		// deduplicate (v, vt, vn) corners into mesh vertices
+		size_t capacity = 1;
+		while (capacity < 2 * corners.size()) capacity <<= 1;
+		const uint32_t mask = static_cast<uint32_t>(capacity - 1);
+
+		std::vector<uint32_t> slots(capacity, UINT32_MAX);
+		std::vector<FObjCorner> unique;
+		unique.reserve(corners.size());
+
+		for (size_t k = 0; k < corners.size(); k++)
+		{
+			const FObjCorner& c = corners[k];
+			uint32_t slot = hash_corner(c) & mask;
+			while (true)
+			{
+				const uint32_t id = slots[slot];
+				if (id == UINT32_MAX)
+				{
+					slots[slot] = static_cast<uint32_t>(unique.size());
+					mesh->indices[k] = static_cast<uint32_t>(unique.size());
+					unique.push_back(c);
+					break;
+				}
+
+				const FObjCorner& u = unique[id];
+				if (u.v == c.v && u.vt == c.vt && u.vn == c.vn)
+				{
+					mesh->indices[k] = id;
+					break;
+				}
+				slot = (slot + 1) & mask;
+			}
+		}
+
+		mesh->positions.resize(unique.size());
+		if (has_vn) mesh->normals.resize(unique.size());
+		if (has_vt) mesh->uvs.resize(2 * unique.size());
+
+		parallel_for(num_threads, [&](int i) {
+			size_t begin = unique.size() * i / num_threads;
+			size_t end = unique.size() * (i + 1) / num_threads;
+			for (size_t k = begin; k < end; k++)
+			{
+				const FObjCorner& c = unique[k];
+				mesh->positions[k] = positions[c.v];
+				if (has_vn)
+				{
+					mesh->normals[k] = (c.vn >= 0) ? normals[c.vn] : FVec3(0, 0, 0);
+				}
+				if (has_vt)
+				{
+					mesh->uvs[2 * k] = (c.vt >= 0) ? texcoords[2 * c.vt] : 0.0;
+					mesh->uvs[2 * k + 1] = (c.vt >= 0) ? texcoords[2 * c.vt + 1] : 0.0;
+				}
+			}
+		});
+	}
+
+	const double parse_us = counter.EndPerf();
+	counter.StartPerf();
+	mesh->build();
+	const double build_us = counter.EndPerf();
+
+	if (stats)
+	{
+		stats->file_bytes = file.size();
+		stats->vertices = mesh->positions.size();
+		stats->triangles = mesh->triangle_count();
+		stats->threads = num_threads;
+		stats->parse_seconds = parse_us / 1000000.0;
+		stats->build_seconds = build_us / 1000000.0;
+	}
+
+	return mesh;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// binary ply
+
+enum EPlyType
+{
+	PLY_INVALID = 0,
+	PLY_INT8,
+	PLY_UINT8,
+	PLY_INT16,
+	PLY_UINT16,
+	PLY_INT32,
+	PLY_UINT32,
+	PLY_FLOAT32,
+	PLY_FLOAT64
+};
+
+struct FPlyProperty
+{
+	std::string name;
+	EPlyType type = PLY_INVALID;
+	EPlyType count_type = PLY_INVALID;  // list length type, PLY_INVALID for scalars
+};
+
+struct FPlyElement
+{
+	std::string name;
+	size_t count = 0;
+	std::vector<FPlyProperty> properties;
+};
+
+static EPlyType ply_type(const std::string& name)
+{
+	if (name == "char" || name == "int8") return PLY_INT8;
+	if (name == "uchar" || name == "uint8") return PLY_UINT8;
+	if (name == "short" || name == "int16") return PLY_INT16;
+	if (name == "ushort" || name == "uint16") return PLY_UINT16;
+	if (name == "int" || name == "int32") return PLY_INT32;
+	if (name == "uint" || name == "uint32") return PLY_UINT32;
+	if (name == "float" || name == "float32") return PLY_FLOAT32;
+	if (name == "double" || name == "float64") return PLY_FLOAT64;
+	return PLY_INVALID;
+}
+
+static size_t ply_size(EPlyType type)
+{
+	switch (type)
+	{
+	case PLY_INT8: case PLY_UINT8: return 1;
+	case PLY_INT16: case PLY_UINT16: return 2;
+	case PLY_INT32: case PLY_UINT32: case PLY_FLOAT32: return 4;
+	case PLY_FLOAT64: return 8;
+	default: return 0;
+	}
+}
+
+// read one value, swapping bytes for big endian files
+static inline double ply_read(const char* p, EPlyType type, bool swap)
+{
+	unsigned char bytes[8];
+	const size_t size = ply_size(type);
+	memcpy(bytes, p, size);
+	if (swap) std::reverse(bytes, bytes + size);
+
+	switch (type)
+	{
+	case PLY_INT8: { int8_t v; memcpy(&v, bytes, 1); return v; }
+	case PLY_UINT8: { uint8_t v; memcpy(&v, bytes, 1); return v; }
+	case PLY_INT16: { int16_t v; memcpy(&v, bytes, 2); return v; }
+	case PLY_UINT16: { uint16_t v; memcpy(&v, bytes, 2); return v; }
+	case PLY_INT32: { int32_t v; memcpy(&v, bytes, 4); return v; }
+	case PLY_UINT32: { uint32_t v; memcpy(&v, bytes, 4); return v; }
+	case PLY_FLOAT32: { float v; memcpy(&v, bytes, 4); return v; }
+	case PLY_FLOAT64: { double v; memcpy(&v, bytes, 8); return v; }
+	default: return 0.0;
+	}
+}
+
+// parse the ascii header, returns the start of the binary body or nullptr
+static const char* ply_header(const char* data, const char* end, std::vector<FPlyElement>& elements, bool& swap)
+{
+	bool binary = false;
+	const char* line = data;
+	bool first = true;
+
+	while (line < end)
+	{
+		const char* line_end = next_line(line, end);
+		std::string text(line, line_end);
+		while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) text.pop_back();
+		line = line_end;
+
+		std::vector<std::string> tokens;
+		for (size_t pos = 0; pos < text.size();)
+		{
+			size_t start = text.find_first_not_of(" \t", pos);
+			if (start == std::string::npos) break;
+			size_t stop = text.find_first_of(" \t", start);
+			if (stop == std::string::npos) stop = text.size();
+			tokens.push_back(text.substr(start, stop - start));
+			pos = stop;
+		}
+
+		if (first)
+		{
+			if (tokens.size() != 1 || tokens[0] != "ply") return nullptr;
+			first = false;
+			continue;
+		}
+		if (tokens.empty() || tokens[0] == "comment" || tokens[0] == "obj_info") continue;
+
+		if (tokens[0] == "format" && tokens.size() >= 2)
+		{
+			binary = (tokens[1] == "binary_little_endian" || tokens[1] == "binary_big_endian");
+			swap = (tokens[1] == "binary_big_endian");
+		}
+		else if (tokens[0] == "element" && tokens.size() >= 3)
+		{
+			FPlyElement element;
+			element.name = tokens[1];
+			element.count = static_cast<size_t>(strtoull(tokens[2].c_str(), nullptr, 10));
+			elements.push_back(element);
+		}
+		else if (tokens[0] == "property" && !elements.empty())
+		{
+			FPlyProperty property;
+			if (tokens.size() >= 5 && tokens[1] == "list")
+			{
+				property.count_type = ply_type(tokens[2]);
+				property.type = ply_type(tokens[3]);
+				property.name = tokens[4];
+				if (property.count_type == PLY_INVALID) return nullptr;
+			}
+			else if (tokens.size() >= 3)
+			{
+				property.type = ply_type(tokens[1]);
+				property.name = tokens[2];
+			}
+			if (property.type == PLY_INVALID) return nullptr;
+			elements.back().properties.push_back(property);
+		}
+		else if (tokens[0] == "end_header")
+		{
+			return binary ? line : nullptr;
+		}
+	}
+
+	return nullptr;
+}
+
+// byte size of a fixed size element, 0 if it contains lists
+static size_t ply_stride(const FPlyElement& element)
+{
+	size_t stride = 0;
+	for (const auto& property : element.properties)
+	{
+		if (property.count_type != PLY_INVALID) return 0;
+		stride += ply_size(property.type);
+	}
+	return stride;
+}
+
+// size of one property starting at p, 0 if it runs past end
+static size_t ply_property_size(const FPlyProperty& property, const char* p, const char* end, bool swap)
+{
+	if (property.count_type == PLY_INVALID)
+	{
+		return (p + ply_size(property.type) <= end) ? ply_size(property.type) : 0;
+	}
+
+	if (p + ply_size(property.count_type) > end) return 0;
+	const size_t count = static_cast<size_t>(ply_read(p, property.count_type, swap));
+	const size_t size = ply_size(property.count_type) + count * ply_size(property.type);
+	return (p + size <= end) ? size : 0;
+}
+
+// size of one element record starting at p, 0 if it runs past end
+static size_t ply_record_size(const FPlyElement& element, const char* p, const char* end, bool swap)
+{
+	size_t size = 0;
+	for (const auto& property : element.properties)
+	{
+		const size_t property_size = ply_property_size(property, p + size, end, swap);
+		if (property_size == 0) return 0;
+		size += property_size;
+	}
+	return size;
+}
+
+static int ply_find(const FPlyElement& element, const char* const* names)
+{
+	for (; *names; ++names)
+	{
+		for (size_t i = 0; i < element.properties.size(); i++)
+		{
+			if (element.properties[i].name == *names) return static_cast<int>(i);
+		}
+	}
+	return -1;
+}
+
+shared_ptr<FTriangleMesh> load_ply(const char* filename, const shared_ptr<FMaterial>& m, FMeshLoadStats* stats)
+{
+	FPerformanceCounter counter;
+	counter.StartPerf();
+
+	FMappedFile file;
+	if (!file.open(filename))
+	{
+		std::cerr << "ERROR: Could not open mesh file " << filename << ".\n";
+		return nullptr;
+	}
+
+	const char* end = file.data() + file.size();
+	std::vector<FPlyElement> elements;
+	bool swap = false;
+	const char* p = ply_header(file.data(), end, elements, swap);
+	if (!p)
+	{
+		std::cerr << "ERROR: " << filename << " is not a binary ply file.\n";
+		return nullptr;
+	}
+
+	const int num_threads = hardware_threads();
+	shared_ptr<FTriangleMesh> mesh = make_shared<FTriangleMesh>(m);
+	bool has_vertices = false;
+	bool has_faces = false;
+
+	for (const auto& element : elements)
+	{
+		if (element.name == "vertex")
+		{
+			// fixed size records, convert in parallel
+			const size_t stride = ply_stride(element);
+			if (stride == 0 || p + stride * element.count > end || element.count >= INT32_MAX)
+			{
+				std::cerr << "ERROR: Unsupported vertex layout in " << filename << ".\n";
+				return nullptr;
+			}
+
+			static const char* kX[] = { "x", nullptr };
+			static const char* kY[] = { "y", nullptr };
+			static const char* kZ[] = { "z", nullptr };
+			static const char* kNX[] = { "nx", nullptr };
+			static const char* kNY[] = { "ny", nullptr };
+			static const char* kNZ[] = { "nz", nullptr };
+			static const char* kU[] = { "u", "s", "texture_u", "texture_s", nullptr };
+			static const char* kV[] = { "v", "t", "texture_v", "texture_t", nullptr };
+
+			int props[8] = { ply_find(element, kX), ply_find(element, kY), ply_find(element, kZ),
+				ply_find(element, kNX), ply_find(element, kNY), ply_find(element, kNZ),
+				ply_find(element, kU), ply_find(element, kV) };
+			if (props[0] < 0 || props[1] < 0 || props[2] < 0)
+			{
+				std::cerr << "ERROR: Missing vertex positions in " << filename << ".\n";
+				return nullptr;
+			}
+
+			size_t offsets[8];
+			EPlyType types[8];
+			for (int k = 0; k < 8; k++)
+			{
+				offsets[k] = 0;
+				types[k] = PLY_INVALID;
+				if (props[k] < 0) continue;
+				for (int j = 0; j < props[k]; j++) offsets[k] += ply_size(element.properties[j].type);
+				types[k] = element.properties[props[k]].type;
+			}
+
+			const bool has_normals = props[3] >= 0 && props[4] >= 0 && props[5] >= 0;
+			const bool has_uvs = props[6] >= 0 && props[7] >= 0;
+			mesh->positions.resize(element.count);
+			if (has_normals) mesh->normals.resize(element.count);
+			if (has_uvs) mesh->uvs.resize(2 * element.count);
+
+			const char* body = p;
+			parallel_for(num_threads, [&](int i) {
+				size_t begin = element.count * i / num_threads;
+				size_t stop = element.count * (i + 1) / num_threads;
+				for (size_t k = begin; k < stop; k++)
+				{
+					const char* record = body + k * stride;
+					mesh->positions[k] = FPoint3(ply_read(record + offsets[0], types[0], swap),
+						ply_read(record + offsets[1], types[1], swap),
+						ply_read(record + offsets[2], types[2], swap));
+					if (has_normals)
+					{
+						mesh->normals[k] = FVec3(ply_read(record + offsets[3], types[3], swap),
+							ply_read(record + offsets[4], types[4], swap),
+							ply_read(record + offsets[5], types[5], swap));
+					}
+					if (has_uvs)
+					{
+						mesh->uvs[2 * k] = ply_read(record + offsets[6], types[6], swap);
+						mesh->uvs[2 * k + 1] = ply_read(record + offsets[7], types[7], swap);
+					}
+				}
+			});
+
+			p += stride * element.count;
+			has_vertices = true;
+		}
+		else if (element.name == "face")
+		{
+			static const char* kIndices[] = { "vertex_indices", "vertex_index", nullptr };
+			const int prop = ply_find(element, kIndices);
+			if (prop < 0 || element.properties[prop].count_type == PLY_INVALID)
+			{
+				std::cerr << "ERROR: Missing face indices in " << filename << ".\n";
+				return nullptr;
+			}
+
+			const FPlyProperty& list = element.properties[prop];
+			const size_t count_size = ply_size(list.count_type);
+			const size_t index_size = ply_size(list.type);
+
+			// fast path: faces are a single triangle list, fixed stride
+			size_t tri_stride = count_size + 3 * index_size;
+			bool fixed = element.properties.size() == 1 && p + tri_stride * element.count <= end;
+			if (fixed)
+			{
+				std::vector<char> ok(num_threads, 1);
+				parallel_for(num_threads, [&](int i) {
+					size_t begin = element.count * i / num_threads;
+					size_t stop = element.count * (i + 1) / num_threads;
+					for (size_t k = begin; k < stop; k++)
+					{
+						if (ply_read(p + k * tri_stride, list.count_type, swap) != 3.0) { ok[i] = 0; return; }
+					}
+				});
+				for (char thread_ok : ok) fixed = fixed && thread_ok;
+			}
+
+			if (fixed)
+			{
+				mesh->indices.resize(3 * element.count);
+				const char* body = p;
+				parallel_for(num_threads, [&](int i) {
+					size_t begin = element.count * i / num_threads;
+					size_t stop = element.count * (i + 1) / num_threads;
+					for (size_t k = begin; k < stop; k++)
+					{
+						const char* record = body + k * tri_stride + count_size;
+						for (int c = 0; c < 3; c++)
+						{
+							mesh->indices[3 * k + c] = static_cast<uint32_t>(ply_read(record + c * index_size, list.type, swap));
+						}
+					}
+				});
+				p += tri_stride * element.count;
+			}
+			else
+			{
+				// variable length polygons: count, then fan triangulate
+				size_t num_tris = 0;
+				const char* q = p;
+				for (size_t k = 0; k < element.count; k++)
+				{
+					const size_t size = ply_record_size(element, q, end, swap);
+					if (size == 0)
+					{
+						std::cerr << "ERROR: Truncated faces in " << filename << ".\n";
+						return nullptr;
+					}
+
+					size_t offset = 0;
+					for (int j = 0; j < prop; j++) offset += ply_property_size(element.properties[j], q + offset, end, swap);
+					const size_t corners = static_cast<size_t>(ply_read(q + offset, list.count_type, swap));
+					if (corners >= 3) num_tris += corners - 2;
+					q += size;
+				}
+
+				mesh->indices.resize(3 * num_tris);
+				uint32_t* out = mesh->indices.data();
+				for (size_t k = 0; k < element.count; k++)
+				{
+					const size_t size = ply_record_size(element, p, end, swap);
+					size_t offset = 0;
+					for (int j = 0; j < prop; j++) offset += ply_property_size(element.properties[j], p + offset, end, swap);
+					const size_t corners = static_cast<size_t>(ply_read(p + offset, list.count_type, swap));
+					const char* first = p + offset + count_size;
+					for (size_t c = 2; c < corners; c++)
+					{
+						*out++ = static_cast<uint32_t>(ply_read(first, list.type, swap));
+						*out++ = static_cast<uint32_t>(ply_read(first + (c - 1) * index_size, list.type, swap));
+						*out++ = static_cast<uint32_t>(ply_read(first + c * index_size, list.type, swap));
+					}
+					p += size;
+				}
+			}
+			has_faces = true;
+		}
+		else
+		{
+			// skip elements we don't use
+			const size_t stride = ply_stride(element);
+			for (size_t k = 0; k < element.count; k++)
+			{
+				const size_t size = stride ? stride : ply_record_size(element, p, end, swap);
+				if (size == 0 || p + size > end)
+				{
+					std::cerr << "ERROR: Truncated element " << element.name << " in " << filename << ".\n";
+					return nullptr;
+				}
+				p += size;
+			}
+		}
+
+		if (has_vertices && has_faces) break;
+	}
+
+	if (!has_vertices || !has_faces || mesh->indices.empty())
+	{
+		std::cerr << "ERROR: No triangles in " << filename << ".\n";
+		return nullptr;
+	}
+
+	for (uint32_t index : mesh->indices)
+	{
+		if (index >= mesh->positions.size())
+		{
+			std::cerr << "ERROR: Vertex index out of range in " << filename << ".\n";
+			return nullptr;
+		}
+	}
+
+	const double parse_us = counter.EndPerf();
+	counter.StartPerf();
+	mesh->build();
+	const double build_us = counter.EndPerf();
+
+	if (stats)
+	{
+		stats->file_bytes = file.size();
+		stats->vertices = mesh->positions.size();
+		stats->triangles = mesh->triangle_count();
+		stats->threads = num_threads;
+		stats->parse_seconds = parse_us / 1000000.0;
+		stats->build_seconds = build_us / 1000000.0;
+	}
+
+	return mesh;
+}
@@ -0,0 +1,25 @@
+// mesh loader (wavefront obj, binary ply)
+// files are memory mapped and parsed by all hardware threads, results are
+// written straight into the flat buffers of a FTriangleMesh.
+//
+
+#pragma once
+
+#include "triangle_mesh.h"
+
+
+struct FMeshLoadStats
+{
+	size_t	file_bytes = 0;
+	size_t	vertices = 0;
+	size_t	triangles = 0;
+	int		threads = 0;
+	double	parse_seconds = 0.0;  // mapping + parsing + dedup
+	double	build_seconds = 0.0;  // bvh
+};
+
+// load a .obj or .ply file, returns nullptr on failure
+shared_ptr<FTriangleMesh> load_mesh(const char* filename, const shared_ptr<FMaterial>& m, FMeshLoadStats* stats = nullptr);
+
+shared_ptr<FTriangleMesh> load_obj(const char* filename, const shared_ptr<FMaterial>& m, FMeshLoadStats* stats = nullptr);
+shared_ptr<FTriangleMesh> load_ply(const char* filename, const shared_ptr<FMaterial>& m, FMeshLoadStats* stats = nullptr);
@@ -16,13 +16,13 @@ struct FPositionTrackKey
 		, time(0)
 	{}
 
-	FPositionTrackKey(const FPoint3 &p, double t)
+	FPositionTrackKey(const FPoint3 &p, FReal t)
 		: pos(p)
 		, time(t)
 	{}
 
 	FPoint3	pos;
-	double	time;
+	FReal	time;
 };
 
 // moving sphere
@@ -30,23 +30,67 @@ class FMovingSphere : public FHittable
 {
 public:
 	FMovingSphere() : radius(0) {}
-	FMovingSphere(const FPositionTrackKey &k0, const FPositionTrackKey& k1, double InRadius, const shared_ptr<FMaterial> &m)
+	FMovingSphere(const FPositionTrackKey &k0, const FPositionTrackKey& k1, FReal InRadius, const shared_ptr<FMaterial> &m)
 		: key0(k0)
 		, key1(k1)
 		, radius(InRadius)
 		, mat_ptr(m)
 	{}
 
-	virtual bool hit(const FRay& ray, double t_min, double t_max, FHitRecord& outHit) const override;
-	virtual bool bounding_box(double t0, double t1, FAABB& outbox) const override;
+	virtual bool intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const override;
+	virtual void surface(const FRay& ray, FHitRecord& rec) const override;
+	virtual bool bounding_box(FReal t0, FReal t1, FAABB& outbox) const override;
 
-	FPoint3 Position(double time) const;
+	FPoint3 Position(FReal time) const;
 
 public:
 	FPositionTrackKey key0;
 	FPositionTrackKey key1;
 
-	double		radius;
+	FReal		radius;
 	shared_ptr<FMaterial>	mat_ptr;
 
 };
+
+inline bool FMovingSphere::intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const
+{
+	const FPoint3 center = Position(ray.Time());
+
+	FVec3 oc = ray.Origin() - center;
+	auto a = ray.Direction().length2();
+	auto half_b = dot(oc, ray.Direction());
+	auto c = oc.length2() - radius * radius;
+	auto discriminant = half_b * half_b - a * c;
+
+	if (discriminant > 0.0) {
+		auto root = sqrt(discriminant);
+		auto time = 0.0;
+		
+		// check root1
+		auto root1 = (-half_b - root) / a;
+		if (root1 < t_max && root1 > t_min) {
+			time = root1;
+		}
+		else {
+			// check root2
+			auto root2 = (-half_b + root) / a;
+			if (root2 < t_max && root2 > t_min) {
+				time = root2;
+			}
+			else {
+				return false;
+			}
+		}
+
+		outHit.set_hit(time, this);
+		return true;
+	}
+
+	return false;
+}
+
+inline FPoint3 FMovingSphere::Position(FReal time) const
+{
+	FReal t = (time - key0.time) / (key1.time - key0.time);
+	return lerp(key0.pos, key1.pos, t);
+}
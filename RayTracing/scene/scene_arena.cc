@@ -0,0 +1,53 @@
+// scene arena
+//
+//
+
+#include "scene_arena.h"
+
+
+FMonotonicPool::~FMonotonicPool()
+{
+	for (char* block : blocks)
+	{
+		::operator delete(block);
+	}
+}
+
+void* FMonotonicPool::allocate(size_t size, size_t alignment)
+{
+	size_t padding = (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) % alignment;
+	if (!cursor || padding + size > remaining)
+	{
+		// oversized objects get a block of their own
+		size_t new_size = std::max(block_size, size + alignment);
+		char* block = static_cast<char*>(::operator new(new_size));
+		blocks.push_back(block);
+
+		cursor = block;
+		remaining = new_size;
+		padding = (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) % alignment;
+	}
+
+	char* p = cursor + padding;
+	cursor = p + size;
+	remaining -= padding + size;
+
+	allocations++;
+	bytes += size;
+	return p;
+}
+
+size_t FSceneArena::num_objects() const
+{
+	return hittables.num_allocations() + materials.num_allocations() + textures.num_allocations() + others.num_allocations();
+}
+
+size_t FSceneArena::num_blocks() const
+{
+	return hittables.num_blocks() + materials.num_blocks() + textures.num_blocks() + others.num_blocks();
+}
+
+size_t FSceneArena::num_bytes() const
+{
+	return hittables.num_bytes() + materials.num_bytes() + textures.num_bytes() + others.num_bytes();
+}
@@ -0,0 +1,102 @@
+// scene arena
+// holds the memory of every hittable, material and texture of a scene.
+// objects are bump allocated into typed pools, so objects of one kind sit next
+// to each other, and their memory is freed in one shot with the arena.
+//
+// make<T>() hands out an ordinary owning shared_ptr whose control block sits
+// next to the object in the pool and holds the arena: objects die when their
+// last reference goes, the blocks when the last object of the arena does, so
+// any copy kept outside the scene stays valid.
+//
+
+#pragma once
+
+#include <type_traits>
+#include <vector>
+#include "basic.h"
+#include "hittable.h"
+#include "material.h"
+#include "texture.h"
+
+
+// monotonic block allocator
+class FMonotonicPool
+{
+public:
+	explicit FMonotonicPool(size_t InBlockSize = 64 * 1024)
+		: block_size(InBlockSize), cursor(nullptr), remaining(0), allocations(0), bytes(0)
+	{}
+	~FMonotonicPool();
+
+	FMonotonicPool(const FMonotonicPool&) = delete;
+	FMonotonicPool& operator=(const FMonotonicPool&) = delete;
+
+	void* allocate(size_t size, size_t alignment);
+
+	size_t num_allocations() const { return allocations; }
+	size_t num_bytes() const { return bytes; }
+	size_t num_blocks() const { return blocks.size(); }
+
+private:
+	std::vector<char*> blocks;
+	size_t block_size;
+	char* cursor;
+	size_t remaining;
+
+	size_t allocations;
+	size_t bytes;
+};
+
+
+class FSceneArena : public std::enable_shared_from_this<FSceneArena>
+{
+public:
+	FSceneArena() {}
+
+	FSceneArena(const FSceneArena&) = delete;
+	FSceneArena& operator=(const FSceneArena&) = delete;
+
+	// the arena itself must be owned by a shared_ptr
+	template<typename T, typename... Args>
+	shared_ptr<T> make(Args&&... args)
+	{
+		FMonotonicPool& pool = std::is_base_of<FHittable, T>::value ? hittables
+			: std::is_base_of<FMaterial, T>::value ? materials
+			: std::is_base_of<FTexture, T>::value ? textures : others;
+
+		return std::allocate_shared<T>(TArenaAllocator<T>(shared_from_this(), pool), std::forward<Args>(args)...);
+	}
+
+	size_t num_objects() const;
+	size_t num_blocks() const;
+	size_t num_bytes() const;
+
+private:
+	// allocates from one pool and never frees, every copy (the one kept in
+	// each control block included) holds the arena
+	template<typename T>
+	struct TArenaAllocator
+	{
+		using value_type = T;
+
+		TArenaAllocator(const shared_ptr<FSceneArena>& InArena, FMonotonicPool& InPool) : arena(InArena), pool(&InPool) {}
+		template<typename U>
+		TArenaAllocator(const TArenaAllocator<U>& other) : arena(other.arena), pool(other.pool) {}
+
+		T* allocate(size_t n) { return static_cast<T*>(pool->allocate(n * sizeof(T), alignof(T))); }
+		void deallocate(T*, size_t) {}
+
+		template<typename U>
+		bool operator==(const TArenaAllocator<U>& other) const { return pool == other.pool; }
+		template<typename U>
+		bool operator!=(const TArenaAllocator<U>& other) const { return pool != other.pool; }
+
+		shared_ptr<FSceneArena> arena;
+		FMonotonicPool* pool;
+	};
+
+	FMonotonicPool hittables;
+	FMonotonicPool materials;
+	FMonotonicPool textures;
+	FMonotonicPool others;
+};
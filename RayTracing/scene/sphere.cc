@@ -3,49 +3,106 @@
 //
 
 #include "sphere.h"
+#include "simd.h"
+#include "onb.h"
 
 
-bool FSphere::hit(const FRay& ray, double t_min, double t_max, FHitRecord& outHit) const
+// one sphere against kSimdWidth rays at a time, same arithmetic as intersect()
+uint32_t FSphere::intersect_packet(const FRayPacket& packet, FReal t_min, FReal* t_max, FHitRecord* recs) const
 {
-	FVec3 oc = ray.Origin() - center;
-	auto a = ray.Direction().length2();
-	auto half_b = dot(oc, ray.Direction());
-	auto c = oc.length2() - radius * radius;
-	auto discriminant = half_b * half_b - a * c;
-
-	if (discriminant > 0.0) {
-		auto root = sqrt(discriminant);
-		auto time = 0.0;
-		
-		// check root1
-		auto root1 = (-half_b - root) / a;
-		if (root1 < t_max && root1 > t_min) {
-			time = root1;
-		}
-		else {
-			// check root2
-			auto root2 = (-half_b + root) / a;
-			if (root2 < t_max && root2 > t_min) {
-				time = root2;
-			}
-			else {
-				return false;
+	const FSimdReal cx = simd_set1(center.x()), cy = simd_set1(center.y()), cz = simd_set1(center.z());
+	const FSimdReal radius2 = simd_set1(radius * radius);
+	const FSimdReal lo = simd_set1(t_min);
+	const FSimdReal zero = simd_set1(0.0);
+
+	uint32_t hits = 0;
+	alignas(32) FReal roots[kSimdWidth];
+	for (int base = 0; base < packet.count; base += kSimdWidth)
+	{
+		const FSimdReal dx = simd_load(&packet.dx[base]), dy = simd_load(&packet.dy[base]), dz = simd_load(&packet.dz[base]);
+		const FSimdReal ocx = simd_load(&packet.ox[base]) - cx;
+		const FSimdReal ocy = simd_load(&packet.oy[base]) - cy;
+		const FSimdReal ocz = simd_load(&packet.oz[base]) - cz;
+
+		const FSimdReal a = dx * dx + dy * dy + dz * dz;
+		const FSimdReal half_b = ocx * dx + ocy * dy + ocz * dz;
+		const FSimdReal c = (ocx * ocx + ocy * ocy + ocz * ocz) - radius2;
+		const FSimdReal discriminant = half_b * half_b - a * c;
+
+		const FSimdMask valid = simd_gt(discriminant, zero);
+		if (simd_movemask(valid) == 0)
+			continue;
+
+		const FSimdReal hi = simd_load(&t_max[base]);
+		const FSimdReal root = simd_sqrt(simd_select(valid, discriminant, zero));
+		const FSimdReal root1 = (-half_b - root) / a;
+		const FSimdReal root2 = (-half_b + root) / a;
+
+		const FSimdMask valid1 = valid & simd_lt(root1, hi) & simd_gt(root1, lo);
+		const FSimdMask valid2 = simd_andnot(valid & simd_lt(root2, hi) & simd_gt(root2, lo), valid1);
+		const int lanes = simd_movemask(valid1 | valid2);
+		if (lanes == 0)
+			continue;
+
+		simd_store(roots, simd_select(valid1, root1, root2));
+		for (int lane = 0; lane < kSimdWidth; ++lane)
+		{
+			const int i = base + lane;
+			if ((lanes & (1 << lane)) && i < packet.count)
+			{
+				recs[i].set_hit(roots[lane], this);
+				t_max[i] = roots[lane];
+				hits |= 1u << i;
 			}
 		}
-
-		outHit.t = time;
-		outHit.p = ray.At(time);
-		FVec3 outward_normal = (outHit.p - center) / radius;
-		outHit.set_face_normal(ray, outward_normal);
-		get_shere_uv(outward_normal, outHit.u, outHit.v);
-		outHit.mat_ptr = mat_ptr;
-		return true;
 	}
+	simd_end();
+
+	return hits;
+}
+
+void FSphere::surface(const FRay& ray, FHitRecord& rec) const
+{
+	rec.p = ray.At(rec.t);
+	FVec3 outward_normal = (rec.p - center) / radius;
+	rec.set_face_normal(ray, outward_normal);
+	get_shere_uv(outward_normal, rec.u, rec.v);
+	rec.mat_ptr = mat_ptr.get();
+}
+
+FReal FSphere::pdf_value(const FPoint3& origin, const FVec3& dir) const
+{
+	FHitRecord rec;
+	if (!intersect(FRay(origin, dir), 0.001, kInfinity, rec))
+		return 0;
+
+	const FReal distance_squared = (center - origin).length2();
+	if (distance_squared <= radius * radius)
+		return 0;
+
+	const FReal cos_theta_max = sqrt(1 - radius * radius / distance_squared);
+	return 1 / (kTwoPi * (1 - cos_theta_max));
+}
+
+FVec3 FSphere::random(const FPoint3& origin) const
+{
+	const FVec3 direction = center - origin;
+	const FReal distance_squared = direction.length2();
+	if (distance_squared <= radius * radius)
+		return sample_unit_vector();
+
+	// uniform in the cone around the direction to the center
+	const FReal cos_theta_max = sqrt(1 - radius * radius / distance_squared);
+	FReal u, v;
+	sample_2d(u, v);
+	const FReal z = 1 + u * (cos_theta_max - 1);
+	const FReal phi = kTwoPi * v;
+	const FReal r = sqrt(1 - z * z);
 
-	return false;
+	return FOnb(direction).local(r * cos(phi), r * sin(phi), z);
 }
 
-void get_shere_uv(const FVec3& p, double& u, double& v)
+void get_shere_uv(const FVec3& p, FReal& u, FReal& v)
 {
 	auto phi = atan2(p.z(), p.x());
 	auto theta = asin(p.y());
@@ -13,14 +13,19 @@ class FSphere : public FHittable
 {
 public:
 	FSphere() : center(0,0,0), radius(0) {}
-	FSphere(const FPoint3 &InCenter, double InRadius, const shared_ptr<FMaterial> &m)
+	FSphere(const FPoint3 &InCenter, FReal InRadius, const shared_ptr<FMaterial> &m)
 		: center(InCenter)
 		, radius(InRadius)
 		, mat_ptr(m)
 	{}
 
-	virtual bool hit(const FRay& ray, double t_min, double t_max, FHitRecord& outHit) const override;
-	virtual bool bounding_box(double t0, double t1, FAABB& outbox) const override
+	virtual bool intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const override;
+	virtual void surface(const FRay& ray, FHitRecord& rec) const override;
+	virtual uint32_t intersect_packet(const FRayPacket& packet, FReal t_min, FReal* t_max, FHitRecord* recs) const override;
+	// samples the cone the sphere subtends, origin must be outside
+	virtual FReal pdf_value(const FPoint3& origin, const FVec3& dir) const override;
+	virtual FVec3 random(const FPoint3& origin) const override;
+	virtual bool bounding_box(FReal t0, FReal t1, FAABB& outbox) const override
 	{
 		outbox = FAABB(center - FVec3(radius, radius, radius),
 			center + FVec3(radius, radius, radius));
@@ -29,10 +34,46 @@ public:
 
 public:
 	FPoint3		center;
-	double		radius;
+	FReal		radius;
 	shared_ptr<FMaterial>	mat_ptr;
 };
 
+// defined here so callers knowing the type (FCompiledScene) inline it
+inline bool FSphere::intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const
+{
+	FVec3 oc = ray.Origin() - center;
+	auto a = ray.Direction().length2();
+	auto half_b = dot(oc, ray.Direction());
+	auto c = oc.length2() - radius * radius;
+	auto discriminant = half_b * half_b - a * c;
+
+	if (discriminant > 0.0) {
+		auto root = sqrt(discriminant);
+		auto time = 0.0;
+		
+		// check root1
+		auto root1 = (-half_b - root) / a;
+		if (root1 < t_max && root1 > t_min) {
+			time = root1;
+		}
+		else {
+			// check root2
+			auto root2 = (-half_b + root) / a;
+			if (root2 < t_max && root2 > t_min) {
+				time = root2;
+			}
+			else {
+				return false;
+			}
+		}
+
+		outHit.set_hit(time, this);
+		return true;
+	}
+
+	return false;
+}
+
 
 // caculate uv of sphere (p in a point on the unit sphere)
-void get_shere_uv(const FVec3& p, double& u, double& v);
+void get_shere_uv(const FVec3& p, FReal& u, FReal& v);
@@ -0,0 +1,264 @@
+// sphere set
+//
+//
+
+#include <typeinfo>
+#include "sphere_set.h"
+#include "material.h"
+#include "simd.h"
+
+
+void FSphereSet::add(const FPoint3& center, FReal r, const shared_ptr<FMaterial>& m)
+{
+	add(FPositionTrackKey(center, 0.0), FPositionTrackKey(center, 0.0), r, m);
+}
+
+void FSphereSet::add(const FPositionTrackKey& k0, const FPositionTrackKey& k1, FReal r, const shared_ptr<FMaterial>& m)
+{
+	const size_t i = radius.size();
+	radius.push_back(r);
+	pad();
+
+	const FVec3 motion = k1.pos - k0.pos;
+	const FReal duration = k1.time - k0.time;
+
+	cx[i] = k0.pos.x();
+	cy[i] = k0.pos.y();
+	cz[i] = k0.pos.z();
+	mx[i] = motion.x();
+	my[i] = motion.y();
+	mz[i] = motion.z();
+	time0[i] = k0.time;
+	inv_duration[i] = (duration != 0.0) ? 1.0 / duration : 0.0;
+	radius2[i] = r * r;
+	mat_ids[i] = material_id(m);
+
+	has_motion = has_motion || (motion.length2() > 0.0);
+}
+
+bool FSphereSet::add(const shared_ptr<FHittable>& obj)
+{
+	// exact types only, a subclass may override intersect or surface.
+	// emitters stay separate objects so light lists can sample them
+	const std::type_info& type = typeid(*obj);
+	if (type == typeid(FSphere))
+	{
+		const FSphere* sphere = static_cast<const FSphere*>(obj.get());
+		if (dynamic_cast<const FDiffuseLight*>(sphere->mat_ptr.get()))
+			return false;
+
+		add(sphere->center, sphere->radius, sphere->mat_ptr);
+		return true;
+	}
+
+	if (type == typeid(FMovingSphere))
+	{
+		const FMovingSphere* moving = static_cast<const FMovingSphere*>(obj.get());
+		if (dynamic_cast<const FDiffuseLight*>(moving->mat_ptr.get()))
+			return false;
+
+		add(moving->key0, moving->key1, moving->radius, moving->mat_ptr);
+		return true;
+	}
+
+	return false;
+}
+
+int FSphereSet::material_id(const shared_ptr<FMaterial>& m)
+{
+	for (size_t i = 0; i < materials.size(); ++i)
+	{
+		if (materials[i] == m) return static_cast<int>(i);
+	}
+
+	materials.push_back(m);
+	return static_cast<int>(materials.size() - 1);
+}
+
+void FSphereSet::pad()
+{
+	// padding lanes are zero-radius spheres, they are skipped by index
+	const size_t padded = (radius.size() + kSimdWidth - 1) / kSimdWidth * kSimdWidth;
+
+	cx.resize(padded, 0.0); cy.resize(padded, 0.0); cz.resize(padded, 0.0);
+	mx.resize(padded, 0.0); my.resize(padded, 0.0); mz.resize(padded, 0.0);
+	time0.resize(padded, 0.0);
+	inv_duration.resize(padded, 0.0);
+	radius2.resize(padded, 0.0);
+	mat_ids.resize(padded, 0);
+}
+
+FPoint3 FSphereSet::center(size_t i, FReal time) const
+{
+	const FReal s = (time - time0[i]) * inv_duration[i];
+	return FPoint3(cx[i] + s * mx[i], cy[i] + s * my[i], cz[i] + s * mz[i]);
+}
+
+bool FSphereSet::intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const
+{
+	const FPoint3& origin = ray.Origin();
+	const FVec3& dir = ray.Direction();
+
+	const FSimdReal ox = simd_set1(origin.x()), oy = simd_set1(origin.y()), oz = simd_set1(origin.z());
+	const FSimdReal dx = simd_set1(dir.x()), dy = simd_set1(dir.y()), dz = simd_set1(dir.z());
+	const FSimdReal a = simd_set1(dir.length2());
+	const FSimdReal time = simd_set1(ray.Time());
+	const FSimdReal lo = simd_set1(t_min);
+	const FSimdReal zero = simd_set1(0.0);
+
+	const size_t count = radius.size();
+	size_t closest = count;
+	FReal closest_sofar = t_max;
+	alignas(32) FReal roots[kSimdWidth];
+
+	for (size_t base = 0; base < count; base += kSimdWidth)
+	{
+		FSimdReal ocx = ox - simd_load(&cx[base]);
+		FSimdReal ocy = oy - simd_load(&cy[base]);
+		FSimdReal ocz = oz - simd_load(&cz[base]);
+		if (has_motion)
+		{
+			FSimdReal s = (time - simd_load(&time0[base])) * simd_load(&inv_duration[base]);
+			ocx = ocx - s * simd_load(&mx[base]);
+			ocy = ocy - s * simd_load(&my[base]);
+			ocz = ocz - s * simd_load(&mz[base]);
+		}
+
+		FSimdReal half_b = ocx * dx + ocy * dy + ocz * dz;
+		FSimdReal c = (ocx * ocx + ocy * ocy + ocz * ocz) - simd_load(&radius2[base]);
+		FSimdReal discriminant = half_b * half_b - a * c;
+
+		FSimdMask valid = simd_gt(discriminant, zero);
+		if (simd_movemask(valid) == 0)
+			continue;
+
+		const FSimdReal hi = simd_set1(closest_sofar);
+		FSimdReal root = simd_sqrt(simd_select(valid, discriminant, zero));
+		FSimdReal root1 = (-half_b - root) / a;
+		FSimdReal root2 = (-half_b + root) / a;
+
+		FSimdMask valid1 = valid & simd_lt(root1, hi) & simd_gt(root1, lo);
+		FSimdMask valid2 = simd_andnot(valid & simd_lt(root2, hi) & simd_gt(root2, lo), valid1);
+		int hits = simd_movemask(valid1 | valid2);
+		if (hits == 0)
+			continue;
+
+		simd_store(roots, simd_select(valid1, root1, root2));
+		for (int lane = 0; lane < kSimdWidth; ++lane)
+		{
+			const size_t i = base + lane;
+			if ((hits & (1 << lane)) && i < count && roots[lane] < closest_sofar)
+			{
+				closest = i;
+				closest_sofar = roots[lane];
+			}
+		}
+	} // end for base
+	simd_end();
+
+	if (closest == count)
+		return false;
+
+	outHit.set_hit(closest_sofar, this, static_cast<int>(closest));
+	return true;
+}
+
+// each sphere against kSimdWidth rays at a time, same arithmetic as intersect()
+uint32_t FSphereSet::intersect_packet(const FRayPacket& packet, FReal t_min, FReal* t_max, FHitRecord* recs) const
+{
+	const FSimdReal lo = simd_set1(t_min);
+	const FSimdReal zero = simd_set1(0.0);
+
+	alignas(32) FReal times[kPacketSize];
+	if (has_motion)
+	{
+		for (int i = 0; i < kPacketSize; i++)
+			times[i] = packet.rays[i < packet.count ? i : 0].Time();
+	}
+
+	uint32_t hits = 0;
+	alignas(32) FReal roots[kSimdWidth];
+	for (size_t sphere = 0; sphere < radius.size(); sphere++)
+	{
+		const FSimdReal cx0 = simd_set1(cx[sphere]), cy0 = simd_set1(cy[sphere]), cz0 = simd_set1(cz[sphere]);
+		const FSimdReal r2 = simd_set1(radius2[sphere]);
+
+		for (int base = 0; base < packet.count; base += kSimdWidth)
+		{
+			const FSimdReal dx = simd_load(&packet.dx[base]), dy = simd_load(&packet.dy[base]), dz = simd_load(&packet.dz[base]);
+			FSimdReal ocx = simd_load(&packet.ox[base]) - cx0;
+			FSimdReal ocy = simd_load(&packet.oy[base]) - cy0;
+			FSimdReal ocz = simd_load(&packet.oz[base]) - cz0;
+			if (has_motion)
+			{
+				const FSimdReal s = (simd_load(&times[base]) - simd_set1(time0[sphere])) * simd_set1(inv_duration[sphere]);
+				ocx = ocx - s * simd_set1(mx[sphere]);
+				ocy = ocy - s * simd_set1(my[sphere]);
+				ocz = ocz - s * simd_set1(mz[sphere]);
+			}
+
+			const FSimdReal a = dx * dx + dy * dy + dz * dz;
+			const FSimdReal half_b = ocx * dx + ocy * dy + ocz * dz;
+			const FSimdReal c = (ocx * ocx + ocy * ocy + ocz * ocz) - r2;
+			const FSimdReal discriminant = half_b * half_b - a * c;
+
+			const FSimdMask valid = simd_gt(discriminant, zero);
+			if (simd_movemask(valid) == 0)
+				continue;
+
+			const FSimdReal hi = simd_load(&t_max[base]);
+			const FSimdReal root = simd_sqrt(simd_select(valid, discriminant, zero));
+			const FSimdReal root1 = (-half_b - root) / a;
+			const FSimdReal root2 = (-half_b + root) / a;
+
+			const FSimdMask valid1 = valid & simd_lt(root1, hi) & simd_gt(root1, lo);
+			const FSimdMask valid2 = simd_andnot(valid & simd_lt(root2, hi) & simd_gt(root2, lo), valid1);
+			const int lanes = simd_movemask(valid1 | valid2);
+			if (lanes == 0)
+				continue;
+
+			simd_store(roots, simd_select(valid1, root1, root2));
+			for (int lane = 0; lane < kSimdWidth; ++lane)
+			{
+				const int i = base + lane;
+				if ((lanes & (1 << lane)) && i < packet.count)
+				{
+					recs[i].set_hit(roots[lane], this, static_cast<int>(sphere));
+					t_max[i] = roots[lane];
+					hits |= 1u << i;
+				}
+			}
+		}
+	}
+	simd_end();
+
+	return hits;
+}
+
+void FSphereSet::surface(const FRay& ray, FHitRecord& rec) const
+{
+	const size_t i = rec.prim_id;
+	const FPoint3 c = has_motion ? center(i, ray.Time()) : FPoint3(cx[i], cy[i], cz[i]);
+	rec.p = ray.At(rec.t);
+	FVec3 outward_normal = (rec.p - c) / radius[i];
+	rec.set_face_normal(ray, outward_normal);
+	get_shere_uv(outward_normal, rec.u, rec.v);
+	rec.mat_ptr = materials[mat_ids[i]].get();
+}
+
+bool FSphereSet::bounding_box(FReal t0, FReal t1, FAABB& outbox) const
+{
+	if (radius.empty()) return false;
+
+	for (size_t i = 0; i < radius.size(); ++i)
+	{
+		FVec3 bound(radius[i], radius[i], radius[i]);
+		FPoint3 center0 = center(i, t0);
+		FPoint3 center1 = center(i, t1);
+		FAABB box = surrounding_box(FAABB(center0 - bound, center0 + bound), FAABB(center1 - bound, center1 + bound));
+
+		outbox = (i == 0) ? box : surrounding_box(outbox, box);
+	}
+
+	return true;
+}
@@ -0,0 +1,51 @@
+// hittable: sphere set
+// spheres stored as structure-of-arrays and intersected kSimdWidth at a time.
+// a packet goes the other way round, each sphere against kSimdWidth rays.
+//
+
+#pragma once
+
+#include <vector>
+#include "hittable.h"
+#include "sphere.h"
+#include "moving_sphere.h"
+
+class FMaterial;
+
+// sphere set
+class FSphereSet : public FHittable
+{
+public:
+	FSphereSet() : has_motion(false) {}
+
+	void add(const FPoint3& center, FReal radius, const shared_ptr<FMaterial>& m);
+	void add(const FPositionTrackKey& k0, const FPositionTrackKey& k1, FReal radius, const shared_ptr<FMaterial>& m);
+	// add obj if it is exactly a FSphere or FMovingSphere and does not emit, return false otherwise
+	bool add(const shared_ptr<FHittable>& obj);
+
+	size_t size() const { return radius.size(); }
+
+	virtual bool intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const override;
+	virtual uint32_t intersect_packet(const FRayPacket& packet, FReal t_min, FReal* t_max, FHitRecord* recs) const override;
+	virtual void surface(const FRay& ray, FHitRecord& rec) const override;
+	virtual bool bounding_box(FReal t0, FReal t1, FAABB& outbox) const override;
+
+protected:
+	int material_id(const shared_ptr<FMaterial>& m);
+	FPoint3 center(size_t i, FReal time) const;
+	void pad();
+
+protected:
+	// per sphere arrays, padded to a multiple of kSimdWidth
+	// center(time) = center0 + ((time - time0) * inv_duration) * motion
+	std::vector<FReal> cx, cy, cz;
+	std::vector<FReal> mx, my, mz;  // motion
+	std::vector<FReal> time0;
+	std::vector<FReal> inv_duration;
+	std::vector<FReal> radius2;
+	std::vector<int>	mat_ids;
+
+	std::vector<FReal> radius;  // not padded
+	std::vector<shared_ptr<FMaterial>> materials;
+	bool has_motion;
+};
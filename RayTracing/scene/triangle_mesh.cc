@@ -0,0 +1,253 @@
+// triangle mesh
+//
+//
+
+#include "triangle_mesh.h"
+#include <algorithm>
+
+
+// per ray constants of the watertight ray/triangle test
+// Woop, Benthin, Wald. "Watertight Ray/Triangle Intersection", JCGT 2013.
+struct FWatertightRay
+{
+	FWatertightRay(const FRay& ray)
+	{
+		const FVec3& dir = ray.Direction();
+
+		// z is the dominant axis, swap x and y to keep the winding
+		kz = 0;
+		if (fabs(dir[1]) > fabs(dir[kz])) kz = 1;
+		if (fabs(dir[2]) > fabs(dir[kz])) kz = 2;
+		kx = (kz + 1) % 3;
+		ky = (kx + 1) % 3;
+		if (dir[kz] < 0.0) std::swap(kx, ky);
+
+		Sx = dir[kx] / dir[kz];
+		Sy = dir[ky] / dir[kz];
+		Sz = 1.0 / dir[kz];
+
+		for (int a = 0; a < 3; a++)
+		{
+			inv_dir[a] = 1.0 / dir[a];
+		}
+	}
+
+	int kx, ky, kz;
+	FReal Sx, Sy, Sz;
+	FVec3 inv_dir;
+};
+
+// slab test with precomputed inverse direction, returns the entry distance
+static inline bool hit_box(const FAABB& box, const FPoint3& origin, const FVec3& inv_dir, FReal t_min, FReal t_max, FReal& t_enter)
+{
+	for (int a = 0; a < 3; a++)
+	{
+		FReal t0 = (box.min()[a] - origin[a]) * inv_dir[a];
+		FReal t1 = (box.max()[a] - origin[a]) * inv_dir[a];
+		if (inv_dir[a] < 0.0) std::swap(t0, t1);
+
+		t_min = t0 > t_min ? t0 : t_min;
+		t_max = t1 < t_max ? t1 : t_max;
+		if (t_max < t_min)
+			return false;
+	} // end for a
+
+	t_enter = t_min;
+	return true;
+}
+
+void FTriangleMesh::build()
+{
+	const uint32_t num_tris = static_cast<uint32_t>(triangle_count());
+
+	nodes.clear();
+	tri_order.resize(num_tris);
+	if (num_tris == 0) return;
+
+	std::vector<FAABB> tri_boxes(num_tris);
+	std::vector<FPoint3> centroids(num_tris);
+	for (uint32_t i = 0; i < num_tris; i++)
+	{
+		const FPoint3& p0 = positions[indices[3 * i + 0]];
+		const FPoint3& p1 = positions[indices[3 * i + 1]];
+		const FPoint3& p2 = positions[indices[3 * i + 2]];
+
+		FPoint3 small(fmin(p0.x(), fmin(p1.x(), p2.x())), fmin(p0.y(), fmin(p1.y(), p2.y())), fmin(p0.z(), fmin(p1.z(), p2.z())));
+		FPoint3 big(fmax(p0.x(), fmax(p1.x(), p2.x())), fmax(p0.y(), fmax(p1.y(), p2.y())), fmax(p0.z(), fmax(p1.z(), p2.z())));
+		tri_boxes[i] = FAABB(small, big);
+		centroids[i] = (small + big) * 0.5;
+		tri_order[i] = i;
+	}
+
+	nodes.reserve(2 * (num_tris / MAX_TRIANGLES_IN_LEAF + 1));
+	build_recursive(0, num_tris, tri_boxes, centroids);
+}
+
+uint32_t FTriangleMesh::build_recursive(uint32_t start, uint32_t end, std::vector<FAABB>& tri_boxes, std::vector<FPoint3>& centroids)
+{
+	const uint32_t index = static_cast<uint32_t>(nodes.size());
+	nodes.push_back(FNode());
+
+	FAABB box = tri_boxes[tri_order[start]];
+	FAABB centroid_box(centroids[tri_order[start]], centroids[tri_order[start]]);
+	for (uint32_t i = start + 1; i < end; i++)
+	{
+		box = surrounding_box(box, tri_boxes[tri_order[i]]);
+		centroid_box = surrounding_box(centroid_box, FAABB(centroids[tri_order[i]], centroids[tri_order[i]]));
+	}
+	nodes[index].box = box;
+
+	const uint32_t span = end - start;
+	const int axis = centroid_box.longest_axies();
+	const bool degenerate = centroid_box.max()[axis] <= centroid_box.min()[axis];
+	if (span <= MAX_TRIANGLES_IN_LEAF || (degenerate && span <= UINT16_MAX))
+	{
+		nodes[index].offset = start;
+		nodes[index].count = static_cast<uint16_t>(span);
+		nodes[index].axis = 0;
+		return index;
+	}
+
+	// median split on the centroids
+	const uint32_t mid = start + span / 2;
+	std::nth_element(tri_order.begin() + start, tri_order.begin() + mid, tri_order.begin() + end,
+		[&centroids, axis](uint32_t a, uint32_t b) {
+			return centroids[a][axis] < centroids[b][axis];
+		});
+
+	build_recursive(start, mid, tri_boxes, centroids);
+	const uint32_t right = build_recursive(mid, end, tri_boxes, centroids);
+
+	nodes[index].offset = right;
+	nodes[index].count = 0;
+	nodes[index].axis = static_cast<uint16_t>(axis);
+	return index;
+}
+
+size_t FTriangleMesh::triangle_bytes() const
+{
+	return indices.size() * sizeof(uint32_t) + tri_order.size() * sizeof(uint32_t) + nodes.size() * sizeof(FNode);
+}
+
+bool FTriangleMesh::intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const
+{
+	if (nodes.empty())
+		return false;
+
+	const FWatertightRay wray(ray);
+	const FPoint3& origin = ray.Origin();
+	const bool dir_negative[3] = { wray.inv_dir[0] < 0.0, wray.inv_dir[1] < 0.0, wray.inv_dir[2] < 0.0 };
+
+	uint32_t closest = UINT32_MAX;
+	FReal closest_sofar = t_max;
+	FReal hit_v = 0.0, hit_w = 0.0;
+
+	uint32_t stack[64];
+	int stack_size = 0;
+	uint32_t current = 0;
+	while (true)
+	{
+		const FNode& node = nodes[current];
+		FReal t_enter;
+		if (hit_box(node.box, origin, wray.inv_dir, t_min, closest_sofar, t_enter))
+		{
+			if (node.count > 0)
+			{
+				for (uint32_t i = node.offset; i < node.offset + node.count; i++)
+				{
+					const uint32_t tri = tri_order[i];
+					const FVec3 A = positions[indices[3 * tri + 0]] - origin;
+					const FVec3 B = positions[indices[3 * tri + 1]] - origin;
+					const FVec3 C = positions[indices[3 * tri + 2]] - origin;
+
+					// shear and scale the vertices
+					const FReal Ax = A[wray.kx] - wray.Sx * A[wray.kz];
+					const FReal Ay = A[wray.ky] - wray.Sy * A[wray.kz];
+					const FReal Bx = B[wray.kx] - wray.Sx * B[wray.kz];
+					const FReal By = B[wray.ky] - wray.Sy * B[wray.kz];
+					const FReal Cx = C[wray.kx] - wray.Sx * C[wray.kz];
+					const FReal Cy = C[wray.ky] - wray.Sy * C[wray.kz];
+
+					// scaled barycentric coordinates
+					const FReal U = Cx * By - Cy * Bx;
+					const FReal V = Ax * Cy - Ay * Cx;
+					const FReal W = Bx * Ay - By * Ax;
+					if ((U < 0.0 || V < 0.0 || W < 0.0) && (U > 0.0 || V > 0.0 || W > 0.0))
+						continue;
+
+					const FReal det = U + V + W;
+					if (det == 0.0)
+						continue;
+
+					const FReal T = U * wray.Sz * A[wray.kz] + V * wray.Sz * B[wray.kz] + W * wray.Sz * C[wray.kz];
+					const FReal t = T / det;
+					if (t <= t_min || t >= closest_sofar)
+						continue;
+
+					closest = tri;
+					closest_sofar = t;
+					hit_v = V / det;
+					hit_w = W / det;
+				}
+			}
+			else
+			{
+				// visit the near child first
+				if (dir_negative[node.axis])
+				{
+					stack[stack_size++] = current + 1;
+					current = node.offset;
+				}
+				else
+				{
+					stack[stack_size++] = node.offset;
+					current = current + 1;
+				}
+				continue;
+			}
+		}
+
+		if (stack_size == 0)
+			break;
+		current = stack[--stack_size];
+	} // end while
+
+	if (closest == UINT32_MAX)
+		return false;
+
+	// barycentrics of vertex 1 and 2 are kept in u,v until the surface is evaluated
+	outHit.set_hit(closest_sofar, this, static_cast<int>(closest));
+	outHit.u = hit_v;
+	outHit.v = hit_w;
+	return true;
+}
+
+void FTriangleMesh::surface(const FRay& ray, FHitRecord& rec) const
+{
+	const uint32_t i0 = indices[3 * rec.prim_id + 0];
+	const uint32_t i1 = indices[3 * rec.prim_id + 1];
+	const uint32_t i2 = indices[3 * rec.prim_id + 2];
+	const FReal hit_v = rec.u;
+	const FReal hit_w = rec.v;
+	const FReal hit_u = 1.0 - hit_v - hit_w;
+
+	rec.p = ray.At(rec.t);
+
+	FVec3 outward_normal = unit_vector(cross(positions[i1] - positions[i0], positions[i2] - positions[i0]));
+	if (!normals.empty())
+	{
+		FVec3 shading_normal = hit_u * normals[i0] + hit_v * normals[i1] + hit_w * normals[i2];
+		if (shading_normal.length2() > 0.0)
+		{
+			outward_normal = unit_vector(shading_normal);
+		}
+	}
+	rec.set_face_normal(ray, outward_normal);
+
+	if (!uvs.empty())
+	{
+		rec.u = hit_u * uvs[2 * i0] + hit_v * uvs[2 * i1] + hit_w * uvs[2 * i2];
+		rec.v = hit_u * uvs[2 * i0 + 1] + hit_v * uvs[2 * i1 + 1] + hit_w * uvs[2 * i2 + 1];
+	}
+	rec.mat_ptr = mat_ptr.get();
+}
@@ -0,0 +1,68 @@
+// hittable: indexed triangle mesh
+// vertex attributes live in flat arrays shared by all triangles, a triangle is
+// just three 32-bit indices. each mesh owns a flat bvh over its triangles.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "hittable.h"
+
+class FMaterial;
+
+#define MAX_TRIANGLES_IN_LEAF	4
+
+// triangle mesh
+class FTriangleMesh : public FHittable
+{
+public:
+	FTriangleMesh(const shared_ptr<FMaterial>& m) : mat_ptr(m) {}
+	FTriangleMesh(std::vector<FPoint3> InPositions, std::vector<uint32_t> InIndices, const shared_ptr<FMaterial>& m)
+		: positions(std::move(InPositions))
+		, indices(std::move(InIndices))
+		, mat_ptr(m)
+	{
+		build();
+	}
+
+	// (re)build the bvh, call after the buffers are filled
+	void build();
+
+	size_t triangle_count() const { return indices.size() / 3; }
+	// bytes used by the index buffer and the bvh
+	size_t triangle_bytes() const;
+
+	virtual bool intersect(const FRay& ray, FReal t_min, FReal t_max, FHitRecord& outHit) const override;
+	virtual void surface(const FRay& ray, FHitRecord& rec) const override;
+	virtual bool bounding_box(FReal t0, FReal t1, FAABB& outbox) const override
+	{
+		if (nodes.empty()) return false;
+
+		outbox = nodes[0].box;
+		return true;
+	}
+
+public:
+	std::vector<FPoint3>	positions;
+	std::vector<FVec3>		normals;	// optional, one per position
+	std::vector<FReal>		uvs;		// optional, two per position
+	std::vector<uint32_t>	indices;	// three per triangle
+	shared_ptr<FMaterial>	mat_ptr;
+
+protected:
+	// flat bvh node, the left child of an interior node directly follows it
+	struct FNode
+	{
+		FAABB		box;
+		uint32_t	offset;	// leaf: first entry in tri_order, interior: right child
+		uint16_t	count;	// triangles in leaf, 0 for interior nodes
+		uint16_t	axis;	// split axis of interior nodes
+	};
+
+	uint32_t build_recursive(uint32_t start, uint32_t end, std::vector<FAABB>& tri_boxes, std::vector<FPoint3>& centroids);
+
+protected:
+	std::vector<FNode>		nodes;
+	std::vector<uint32_t>	tri_order;	// triangle ids in leaf order
+};
@@ -4,7 +4,7 @@ cfg_systemversion = "latest" -- "10.0.17763.0"   -- To use the latest version of
 
 -- solution
 workspace "RayTracingProject"
-    configurations { "Debug", "Release" }
+    configurations { "Debug", "Release", "ReleaseFloat" }
     platforms { "Win32", "Win64" }
 
     location "Build"
@@ -20,11 +20,17 @@ workspace "RayTracingProject"
         defines { "NDEBUG" }
         optimize "On"    
 
+    filter "configurations:ReleaseFloat"    -- single precision math core
+        defines { "NDEBUG", "RT_SCALAR_FLOAT" }
+        optimize "On"
+        targetsuffix("_f")
+
     filter "platforms:Win32"
         architecture "x32"
 
     filter "platforms:Win64"
         architecture "x64"
+        vectorextensions "AVX"    -- FSphereSet batches spheres with AVX
 
     filter {}
 
@@ -35,6 +41,7 @@ workspace "RayTracingProject"
 -- project RayTracing
 project "RayTracing"
     language "C++"
+    cppdialect "C++17"    -- aligned new for simd backed FVec3 in containers
     kind "ConsoleApp"
 
     includedirs {